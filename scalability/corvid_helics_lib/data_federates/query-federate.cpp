@@ -13,16 +13,29 @@
 #include <exception>
 #include <cstdlib>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <utility>
 
 #include <boost/optional.hpp>
 #include <boost/json.hpp>
 
-#include "stopwatch.hpp"
+#include "profiler.hpp"
+#include "latency_histogram.hpp"
+#include "metrics_server.hpp"
+#include "time_accountant.hpp"
 
 #include "query_federate_input.hpp"
 #include "websocket_client.hpp"
 #include "json_templates.hpp"
 #include "local_log_helper.hpp"
+#include "telemetry_frame.hpp"
+#include "runtime_control.hpp"
+#include "query_sampling.hpp"
 
 namespace
 {
@@ -50,6 +63,111 @@ std::optional<data::QueryFederateInput> GetQueryFederateInput(int argc, char **a
     return query_input;
 }
 
+utils::SendOptions GetSendOptions(const data::ClientDetails &details)
+{
+    utils::SendOptions options;
+    options.max_queued_messages = details.max_queued_messages;
+    options.max_frame_bytes = details.max_frame_bytes;
+
+    if (!details.overflow_policy.empty())
+    {
+        const std::optional<utils::OverflowPolicy> policy = utils::OverflowPolicyFromString(details.overflow_policy);
+        if (policy)
+        {
+            options.overflow_policy = policy.value();
+        }
+        else
+        {
+            std::cerr << "Unknown overflow_policy '" << details.overflow_policy << "', using 'block'.\n";
+        }
+    }
+
+    return options;
+}
+
+utils::ReconnectOptions GetReconnectOptions(const data::ClientDetails &details)
+{
+    utils::ReconnectOptions options;
+    options.enabled = details.reconnect;
+
+    // Zero means the setting was left out, keep the defaults
+    if (details.reconnect_initial_backoff_ms > 0.0) options.initial_backoff_ms = details.reconnect_initial_backoff_ms;
+    if (details.reconnect_max_backoff_ms > 0.0) options.max_backoff_ms = details.reconnect_max_backoff_ms;
+    if (details.replay_buffer_messages > 0) options.replay_buffer_messages = details.replay_buffer_messages;
+
+    return options;
+}
+
+utils::CompressionOptions GetCompressionOptions(const data::DeflateDetails &details)
+{
+    utils::CompressionOptions options;
+    options.enabled = details.enabled;
+    options.no_context_takeover = details.no_context_takeover;
+    options.min_message_bytes = details.min_message_bytes;
+
+    // Zero means the setting was left out, keep the defaults
+    if (details.level > 0) options.level = details.level;
+    if (details.client_max_window_bits > 0) options.client_max_window_bits = details.client_max_window_bits;
+    if (details.server_max_window_bits > 0) options.server_max_window_bits = details.server_max_window_bits;
+    if (details.mem_level > 0) options.mem_level = details.mem_level;
+    if (details.sample_every > 0) options.sample_every = details.sample_every;
+
+    return options;
+}
+
+utils::AsyncLogOptions GetAsyncLogOptions(const data::AsyncLogDetails &details)
+{
+    utils::AsyncLogOptions options;
+    options.enabled = details.enabled;
+
+    // Zero means the setting was left out, keep the defaults
+    if (details.max_batch_bytes > 0) options.max_batch_bytes = details.max_batch_bytes;
+    if (details.max_batch_delay_ms > 0.0) options.max_batch_delay_ms = details.max_batch_delay_ms;
+
+    return options;
+}
+
+/**
+ * Starts the Prometheus endpoint and mirrors the WebSocket send stats into it on every scrape.
+ */
+void StartMetricsServer(const data::QueryFederateInput &config, const std::shared_ptr<utils::WebSocketClient> &client,
+                        utils::MetricsServer &server, utils::LocalLogHelper &log)
+{
+    utils::MetricsRegistry &metrics = utils::MetricsRegistry::Get();
+    metrics.SetConstantLabels({ { "federate", config.federate_name } });
+    metrics.AddCollector(
+        [&metrics, weak_client = std::weak_ptr<utils::WebSocketClient>(client)]()
+        {
+            const std::shared_ptr<utils::WebSocketClient> current_client = weak_client.lock();
+            if (!current_client) return;
+
+            const utils::SendStats stats = current_client->GetSendStats();
+            metrics.GetGauge("corvid_websocket_queue_depth", "Messages waiting in the WebSocket send queue")
+                .Set(static_cast<double>(stats.queue_depth));
+            metrics.GetCounter("corvid_websocket_messages_sent_total", "Messages written to the WebSocket")
+                .Advance(stats.sent_messages);
+            metrics.GetCounter("corvid_websocket_messages_dropped_total", "Messages dropped by the send queue")
+                .Advance(stats.dropped_messages);
+            metrics.GetCounter("corvid_websocket_bytes_sent_total", "Payload bytes written to the WebSocket")
+                .Advance(stats.sent_bytes);
+            metrics.GetCounter("corvid_websocket_reconnects_total", "WebSocket reconnects").Advance(stats.reconnects);
+        });
+
+    // Zero means the setting was left out
+    const std::string address = config.metrics.address.empty() ? "127.0.0.1" : config.metrics.address;
+    const unsigned short port = config.metrics.port > 0 ? config.metrics.port : 9464;
+
+    boost::system::error_code ec;
+    if (server.Start(address, port, ec))
+    {
+        log << "Serving metrics at http://" << address << ":" << server.GetPort() << "/metrics\n";
+    }
+    else
+    {
+        log << "Could not serve metrics on " << address << ":" << port << ": " << ec.message() << "\n";
+    }
+}
+
 helics::MessageFederate GetFederate(const data::QueryFederateInput &config, utils::LocalLogHelper &log)
 {
     helics::FederateInfo fi;
@@ -61,57 +179,322 @@ helics::MessageFederate GetFederate(const data::QueryFederateInput &config, util
     return msg_fed;
 }
 
-std::string DebugTimeQueryLoop(double granted_time, helics::MessageFederate &msg_fed)
+struct QueryResult
 {
-    utils::Stopwatch loop_watch;
-    loop_watch.Start();
+    std::string name{};
+    std::string result{};
+    double latency_ms{};
+    bool is_error{};
+};
+
+/**
+ * Older HELICS answers a query it cannot resolve with "#invalid", "#error" and the like, newer versions with a JSON
+ * object holding an "error" member.
+ */
+bool IsQueryError(const std::string &result)
+{
+    if (!result.empty() && result.front() == '#')
+    {
+        return true;
+    }
+    if (result.find("\"error\"") == std::string::npos)
+    {
+        return false;
+    }
+
+    boost::system::error_code ec;
+    const boost::json::value parsed = boost::json::parse(result, ec);
+    return !ec && parsed.is_object() && parsed.as_object().contains("error");
+}
+
+/**
+ * Sends every query before waiting on any of them, so the batch costs about one round trip to the slowest target
+ * instead of one round trip per query. A latency is taken when its result is collected, results that arrive while an
+ * earlier one is being waited on are only seen afterwards, so the latencies are upper bounds.
+ */
+std::vector<QueryResult> RunQueries(helics::MessageFederate &msg_fed, const std::vector<data::QuerySpec> &queries)
+{
+    struct PendingQuery
+    {
+        helics::QueryId id;
+        std::size_t index{};
+    };
+
+    std::vector<QueryResult> results(queries.size());
+    std::vector<PendingQuery> pending;
+    pending.reserve(queries.size());
+
+    const std::chrono::steady_clock::time_point dispatch_time = std::chrono::steady_clock::now();
+    {
+        CORVID_PROFILE_SCOPE(dispatch_scope, "dispatch_queries");
+        for (std::size_t i = 0; i < queries.size(); i++)
+        {
+            results[i].name = queries[i].GetName();
+            pending.push_back({ msg_fed.queryAsync(queries[i].target, queries[i].query), i });
+        }
+    }
 
+    CORVID_PROFILE_SCOPE(collect_scope, "collect_queries");
+    while (!pending.empty())
+    {
+        // Take whichever result is already in, otherwise block on the oldest
+        auto ready = std::find_if(pending.begin(), pending.end(),
+                                  [&msg_fed](const PendingQuery &query) { return msg_fed.isQueryCompleted(query.id); });
+        if (ready == pending.end())
+        {
+            ready = pending.begin();
+        }
+
+        QueryResult &result = results[ready->index];
+        result.result = msg_fed.queryComplete(ready->id);
+        result.latency_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - dispatch_time).count();
+        result.is_error = IsQueryError(result.result);
+        pending.erase(ready);
+    }
+
+    return results;
+}
+
+/**
+ * Latency and failures of one query over the run, keyed by QuerySpec::GetName.
+ */
+struct QueryStats
+{
+    utils::LatencyHistogram latency_ns{};
+    std::uint64_t errors{};
+};
+
+std::string FormatQueryStats(const std::map<std::string, QueryStats> &query_stats)
+{
     std::stringstream ss;
-    ss << "\n##########################################\n";
-    ss << "Granted Time: " << granted_time << "\n";
-    ss << msg_fed.query("root", "global_time_debugging") << "\n";
-    ss << "Query Execution Time: " << loop_watch.ElapsedMilliseconds() << " ms\n";
+    ss << "\n##########################################\n"
+       << "Query Latency (count, p50/p99/max ms, errors):\n";
+    for (const auto &[name, stats] : query_stats)
+    {
+        const utils::LatencyHistogram &latency = stats.latency_ns;
+        ss << name << ": " << latency.GetCount() << ", " << latency.GetPercentile(50.0) / 1e6 << "/"
+           << latency.GetPercentile(99.0) / 1e6 << "/" << latency.GetMax() / 1e6 << ", " << stats.errors << "\n";
+    }
     ss << "##########################################\n";
 
     return ss.str();
 }
 
-std::string DiscreteQueriesLoop(double granted_time, helics::MessageFederate &msg_fed)
+/**
+ * Adds the results to the per query stats. Failures are logged at every level.
+ */
+void RecordQueryResults(const std::vector<QueryResult> &results, double granted_time,
+                        std::map<std::string, QueryStats> &query_stats, utils::Counter &errors_metric,
+                        utils::LocalLogHelper &log)
 {
-    utils::Stopwatch loop_watch;
-    loop_watch.Start();
+    for (const QueryResult &result : results)
+    {
+        QueryStats &stats = query_stats[result.name];
+        stats.latency_ns.Record(static_cast<std::uint64_t>(result.latency_ms * 1e6));
+        if (result.is_error)
+        {
+            stats.errors++;
+            errors_metric.Increment();
+            log << "Query " << result.name << " failed at " << granted_time << ": " << result.result << "\n";
+        }
+    }
+}
 
+std::string FormatQueryResults(double granted_time, const std::vector<QueryResult> &results, double query_ms)
+{
     std::stringstream ss;
     ss << "\n##########################################\n";
     ss << "Granted Time: " << granted_time << "\n";
-    ss << "Name: " << msg_fed.query("root", "name") << "\n";
-    ss << "Address: " << msg_fed.query("root", "address") << "\n";
-    ss << "IsInit: " << msg_fed.query("root", "isinit") << "\n";
-    ss << "IsConnected: " << msg_fed.query("root", "isconnected") << "\n";
-    ss << "Query Execution Time: " << loop_watch.ElapsedMilliseconds() << " ms\n";
+    for (const QueryResult &result : results)
+    {
+        ss << result.name << ": " << result.result << " (" << result.latency_ms << " ms)\n";
+    }
+    ss << "Query Execution Time: " << query_ms << " ms\n";
     ss << "##########################################\n";
 
     return ss.str();
 }
 
+// How long the federate thread waits for stall queries still running when the grant arrives
+constexpr std::chrono::milliseconds STALL_HANDLER_WAIT{ 1000 };
+
+// Schema of the per step telemetry frames, bump the version when the record names change
+constexpr std::uint16_t QUERY_TELEMETRY_SCHEMA = 1;
+constexpr std::uint16_t QUERY_TELEMETRY_VERSION = 3;
+
+using TelemetrySink = std::function<void(std::string &&)>;
+
 double PerformLoop(helics::MessageFederate &msg_fed, const double total_time, const double period,
-                   utils::LocalLogHelper &log)
+                   utils::LocalLogHelper &log, const TelemetrySink &send_telemetry, const data::RuntimeControl &control,
+                   utils::TimeAccountant &accountant)
 {
-    utils::Stopwatch main_watch;
+    utils::TelemetryFrameWriter telemetry(msg_fed.getName(), QUERY_TELEMETRY_SCHEMA, QUERY_TELEMETRY_VERSION);
+
+    // Recorded whether or not the metrics server runs, it is a few atomic adds per step
+    utils::MetricsRegistry &metrics = utils::MetricsRegistry::Get();
+    utils::Histogram &grant_wait_metric = metrics.GetHistogram("corvid_grant_wait_ms", "Time blocked in requestTime");
+    utils::Histogram &step_metric = metrics.GetHistogram("corvid_step_ms", "Wall time per granted step");
+    utils::Histogram &query_metric = metrics.GetHistogram("corvid_query_ms", "Time to run the configured queries");
+    utils::Counter &steps_metric = metrics.GetCounter("corvid_steps_total", "Granted steps");
+    utils::Gauge &granted_time_metric = metrics.GetGauge("corvid_granted_time_seconds", "Last granted simulated time");
+    utils::Counter &query_errors_metric =
+        metrics.GetCounter("corvid_query_errors_total", "Queries answered with an error");
+    utils::Counter &stalls_metric = metrics.GetCounter("corvid_stalls_total", "Grants that outlived stall_timeout_ms");
+    utils::Gauge &query_stride_metric = metrics.GetGauge("corvid_query_stride", "Adaptive steps between query runs");
+    std::map<std::string, QueryStats> query_stats;
+
+    std::uint64_t revision = 0;
+    data::RuntimeSettings settings = control.GetSettings(revision);
+    data::QuerySampler sampler;
+
+    // The stall queries run on the watchdog's thread while this one is still blocked in requestTime. settings is only
+    // changed, and the results only read, once Disarm reports the handler finished. Until then the watchdog is not
+    // armed again.
+    std::vector<QueryResult> stall_results;
+    double stall_wait_ms = 0.0;
+    bool is_stall_pending = false;
+    data::StallWatchdog watchdog(
+        [&msg_fed, &settings, &stall_results, &stall_wait_ms](double waited_ms)
+        {
+            CORVID_PROFILE_SCOPE(stall_scope, "stall_queries");
+            stall_wait_ms = waited_ms;
+            stall_results = RunQueries(msg_fed, settings.stall_queries);
+        });
 
     double granted_time = 0.0;
+    std::uint64_t step_count = 0;
 
-    main_watch.Start();
+    CORVID_PROFILE_SCOPE(loop_scope, "query_loop");
     while (granted_time + period <= total_time)
     {
-        granted_time = msg_fed.requestTime(granted_time + period);
+        CORVID_PROFILE_SCOPE(step_scope, "step");
+        CORVID_PROFILE_SCOPE(grant_scope, "request_time");
+        const double requested_time = granted_time + period;
+        const bool is_watching =
+            !is_stall_pending && settings.stall_timeout_ms > 0.0 && !settings.stall_queries.empty();
+        if (is_watching)
+        {
+            watchdog.Arm(settings.stall_timeout_ms);
+        }
+        granted_time = accountant.RequestTime(msg_fed, requested_time);
+        data::StallOutcome stall{};
+        if (is_watching || is_stall_pending)
+        {
+            stall = watchdog.Disarm(STALL_HANDLER_WAIT);
+        }
+        is_stall_pending = stall.is_running;
+        const bool has_stalled = stall.has_fired && !stall.is_running && !stall.error;
+        const double grant_wait_ms = grant_scope.Stop();
+        step_count++;
+        grant_wait_metric.Observe(grant_wait_ms);
+        steps_metric.Increment();
+        granted_time_metric.Set(granted_time);
+
+        if (utils::TraceWriter *trace = utils::Profiler::Get().GetTraceWriter())
+        {
+            trace->SetSimulatedTime(granted_time);
+            trace->AddInstant("grant");
+        }
+
+        if (stall.error)
+        {
+            try
+            {
+                std::rethrow_exception(stall.error);
+            }
+            catch (const std::exception &e)
+            {
+                log << "Stall queries failed: " << e.what() << "\n";
+            }
+            catch (...)
+            {
+                log << "Stall queries failed with an unknown exception\n";
+            }
+        }
+
+        if (has_stalled)
+        {
+            // Logged at every level, this is the federation getting stuck
+            stalls_metric.Increment();
+            RecordQueryResults(stall_results, requested_time, query_stats, query_errors_metric, log);
+            log << "Stall: no grant for " << stall_wait_ms << " ms after requesting " << requested_time
+                << ", granted after " << grant_wait_ms << " ms"
+                << FormatQueryResults(requested_time, stall_results, stall_wait_ms);
+
+            if (send_telemetry)
+            {
+                telemetry.AddSample("stall_wait_ms", granted_time, grant_wait_ms);
+                for (const QueryResult &result : stall_results)
+                {
+                    telemetry.AddEvent("stall_query." + result.name, granted_time, result.result);
+                }
+            }
+        }
+
+        if (!is_stall_pending && control.GetRevision() != revision)
+        {
+            settings = control.GetSettings(revision);
+            log << "Applied runtime settings revision " << revision << " at " << granted_time << ": "
+                << utils::ToJsonString(settings) << "\n";
+        }
+
+        double query_ms = 0.0;
+        if (sampler.ShouldRun(settings, std::chrono::steady_clock::now()) && !settings.queries.empty())
+        {
+            CORVID_PROFILE_SCOPE(query_scope, "queries");
+            const std::vector<QueryResult> results = RunQueries(msg_fed, settings.queries);
+            query_ms = query_scope.Stop();
+            query_metric.Observe(query_ms);
+            RecordQueryResults(results, granted_time, query_stats, query_errors_metric, log);
+
+            const bool is_stride_changed = sampler.RecordQueries(settings, query_ms);
+            if (settings.query_sampling == data::QuerySampling::ADAPTIVE)
+            {
+                query_stride_metric.Set(sampler.GetStride());
+            }
+            if (is_stride_changed && settings.log_level != data::LogLevel::ERROR)
+            {
+                log << "Query stride now " << sampler.GetStride() << " steps, the queries took " << query_ms
+                    << " ms at " << granted_time << "\n";
+            }
+
+            if (settings.log_level == data::LogLevel::DEBUG)
+            {
+                log << FormatQueryResults(granted_time, results, query_ms);
+            }
+
+            if (send_telemetry)
+            {
+                telemetry.AddSample("query_ms", granted_time, query_ms);
+                for (const QueryResult &result : results)
+                {
+                    telemetry.AddEvent("query." + result.name, granted_time, result.result);
+                }
+            }
+        }
 
-        // std::string output_string = DebugTimeQueryLoop(granted_time, msg_fed);
-        std::string output_string = DiscreteQueriesLoop(granted_time, msg_fed);
+        if (step_count % settings.report_every == 0)
+        {
+            if (settings.log_level != data::LogLevel::ERROR)
+            {
+                log << "Granted Time: " << granted_time << " Grant Wait: " << grant_wait_ms
+                    << " ms Step: " << step_scope.ElapsedMilliseconds() << " ms\n";
+            }
+
+            if (send_telemetry)
+            {
+                telemetry.AddSample("grant_wait_ms", granted_time, grant_wait_ms);
+                telemetry.AddSample("step_ms", granted_time, step_scope.ElapsedMilliseconds());
+                telemetry.AddCounter("steps", granted_time, step_count);
+                send_telemetry(telemetry.Finish());
+            }
+        }
 
-        log << output_string;
+        step_metric.Observe(step_scope.ElapsedMilliseconds());
+        sampler.RecordStep(step_scope.ElapsedMilliseconds() - query_ms);
     }
-    double main_loop_ms = main_watch.ElapsedMilliseconds();
+    double main_loop_ms = loop_scope.Stop();
 
     std::stringstream end;
     end << "\n##########################################\n"
@@ -119,16 +502,22 @@ double PerformLoop(helics::MessageFederate &msg_fed, const double total_time, co
         << "\n##########################################\n"
         << "\nFederate finalized.\nGranted time: " << granted_time << "\n";
     log << end.str();
+    if (!query_stats.empty())
+    {
+        log << FormatQueryStats(query_stats);
+    }
 
     return granted_time;
 }
 
-double ExecuteFederate(const data::QueryFederateInput &config, utils::LocalLogHelper &log)
+double ExecuteFederate(const data::QueryFederateInput &config, utils::LocalLogHelper &log,
+                       const TelemetrySink &send_telemetry, const data::RuntimeControl &control)
 {
     helics::MessageFederate msg_fed = GetFederate(config, log);
     const double period = msg_fed.getTimeProperty(HELICS_PROPERTY_TIME_PERIOD);
 
     double granted_time = -1.0;
+    utils::TimeAccountant accountant(config.federate_name);
 
     try
     {
@@ -137,24 +526,57 @@ double ExecuteFederate(const data::QueryFederateInput &config, utils::LocalLogHe
         // Sleep for a few seconds to enure the cosim is fully setup (this is the recommended approach....booo)
         std::this_thread::sleep_for(std::chrono::seconds(5));
 
-        granted_time = PerformLoop(msg_fed, config.total_time, period, log);
+        granted_time = PerformLoop(msg_fed, config.total_time, period, log, send_telemetry, control, accountant);
     }
     catch (const std::exception &e)
     {
         log << "Error: " << e.what() << std::endl;
     }
 
+    // Closed before finalize so the last step's compute does not include tearing the federation down
+    accountant.Finish();
+    log << accountant.GetSummary();
+    if (!config.time_report_file.empty() && !accountant.WriteReport(config.time_report_file))
+    {
+        log << "Could not write time report to '" << config.time_report_file << "'\n";
+    }
+
     // Remember to finalize the fed
     msg_fed.finalize();
 
     return granted_time;
 }
+/**
+ * The client callbacks refer to the log and the RuntimeControl living next to the guard. Stopping the client joins
+ * its IO thread, so no callback can run once they go out of scope, whichever way the scope is left. What is still
+ * queued, e.g. the flushed log, gets a bounded chance to go out before the connection closes.
+ */
+class ClientStopGuard
+{
+  private:
+    std::shared_ptr<utils::WebSocketClient> m_client;
+
+  public:
+    explicit ClientStopGuard(std::shared_ptr<utils::WebSocketClient> client) : m_client(std::move(client)) {}
+    ClientStopGuard(const ClientStopGuard &) = delete;
+    ClientStopGuard &operator=(const ClientStopGuard &) = delete;
+
+    ~ClientStopGuard()
+    {
+        m_client->Drain(std::chrono::seconds(5));
+        m_client->CloseConnection();
+        m_client->StopRun();
+        m_client->SetOnMessage({});
+        m_client->SetOnError({});
+    }
+};
+
 } // namespace
 
 int main(int argc, char **argv)
 {
     int ret_val = EXIT_FAILURE;
-    auto client = std::make_shared<utils::WebSocketClient>();
+    std::shared_ptr<utils::WebSocketClient> client{};
 
     try
     {
@@ -164,7 +586,8 @@ int main(int argc, char **argv)
             return EXIT_FAILURE;
         }
 
-        utils::LocalLogHelper log(query_input.value().local_log_file);
+        utils::LocalLogHelper log(query_input.value().local_log_file,
+                                  GetAsyncLogOptions(query_input.value().async_log));
         if (!log.IsOpen())
         {
             std::cerr << "Could not open file '" << query_input.value().local_log_file << "'!" << std::endl;
@@ -172,9 +595,28 @@ int main(int argc, char **argv)
         }
 
         // Configure the client
-        client->SetOnMessage([&log](const std::string &msg) { log << "Received: " << msg << std::endl; });
+        const data::ClientDetails &client_details = query_input.value().client_details;
+        client = std::make_shared<utils::WebSocketClient>(GetSendOptions(client_details),
+                                                          GetReconnectOptions(client_details),
+                                                          GetCompressionOptions(client_details.permessage_deflate));
+        // Commands retune the running federate, anything else is only logged
+        data::RuntimeControl control(query_input.value().runtime);
+        client->SetOnMessage(
+            [&log, &control, &client](const std::string &msg)
+            {
+                const std::optional<std::string> reply = control.HandleMessage(msg);
+                if (reply)
+                {
+                    client->Send(reply.value(), utils::SendPriority::HIGH);
+                }
+                else
+                {
+                    log << "Received: " << msg << std::endl;
+                }
+            });
         client->SetOnError([&log](const boost::system::error_code &ec, const std::string &what)
                            { log << what << ": " << ec.message() << std::endl; });
+        const ClientStopGuard client_stop_guard(client);
 
         client->AsyncRun();
         client->Connect(query_input.value().client_details.host, query_input.value().client_details.port,
@@ -193,13 +635,76 @@ int main(int argc, char **argv)
 
         log.SetOnWriteCallback([&client](const std::string &msg) { client->Send(msg); });
 
+        utils::MetricsServer metrics_server;
+        if (query_input.value().metrics.enabled)
+        {
+            StartMetricsServer(query_input.value(), client, metrics_server, log);
+        }
+
         // Configure and launch the federate
-        const double granted_time = ExecuteFederate(query_input.value(), log);
+        std::unique_ptr<utils::TraceWriter> trace{};
+        if (!query_input.value().trace_file.empty())
+        {
+            trace = std::make_unique<utils::TraceWriter>(query_input.value().trace_file,
+                                                         query_input.value().federate_name);
+            if (trace->IsOpen())
+            {
+                utils::Profiler::Get().SetTraceWriter(trace.get());
+            }
+            else
+            {
+                log << "Could not open trace file '" << query_input.value().trace_file << "'\n";
+            }
+        }
+
+        TelemetrySink send_telemetry{};
+        if (query_input.value().send_telemetry)
+        {
+            send_telemetry = [&client](std::string &&frame) { client->SendBinary(std::move(frame)); };
+        }
+
+        const double granted_time = ExecuteFederate(query_input.value(), log, send_telemetry, control);
         if (granted_time < 0.0)
         {
             log << "Could not perform simulation! Federate finalized.\nGranted time: " << granted_time;
         }
 
+        const utils::SendStats stats = client->GetSendStats();
+        log << "WebSocket Messages Sent: " << stats.sent_messages << "\nWebSocket Frames Sent: " << stats.sent_frames
+            << "\nWebSocket Messages Dropped: " << stats.dropped_messages
+            << "\nWebSocket Queue Depth: " << stats.queue_depth << "\nWebSocket Reconnects: " << stats.reconnects
+            << "\nWebSocket Bytes Sent: " << stats.sent_bytes << "\n";
+        log << "High Priority Latency (mean/p99/max ms): " << stats.high_priority.mean_latency_ms << "/"
+            << stats.high_priority.p99_latency_ms << "/" << stats.high_priority.max_latency_ms
+            << "\nBulk Latency (mean/p99/max ms): " << stats.bulk.mean_latency_ms << "/" << stats.bulk.p99_latency_ms
+            << "/" << stats.bulk.max_latency_ms << "\n";
+        if (client_details.permessage_deflate.enabled)
+        {
+            log << "Deflate Sampled Bytes: " << stats.sampled_bytes
+                << "\nDeflate Estimated Ratio: " << stats.GetCompressionRatio()
+                << "\nDeflate CPU Cost (ms per MB): " << stats.GetCompressMsPerMegabyte() << "\n";
+        }
+        if (log.IsAsync())
+        {
+            log << "Log Batches Written: " << log.GetBatchCount() << "\n";
+        }
+
+        if (trace)
+        {
+            utils::Profiler::Get().SetTraceWriter(nullptr);
+            log << "Trace Events Written: " << trace->GetEventCount() << "\n";
+        }
+
+        log << "\nProfile:\n" << utils::Profiler::Get().GetSummaryTable();
+        const std::string &profile_file = query_input.value().profile_file;
+        if (!profile_file.empty() && !utils::Profiler::Get().WriteJson(profile_file))
+        {
+            log << "Could not write profile to '" << profile_file << "'\n";
+        }
+
+        // Get the batched log out to the client before the connection closes
+        log.Flush();
+
         ret_val = EXIT_SUCCESS;
     }
     catch (const std::exception &e)
@@ -211,8 +716,5 @@ int main(int argc, char **argv)
         std::cerr << "Unknown Exception: An object that does not inherit std::exception was thrown!" << std::endl;
     }
 
-    client->CloseConnection();
-    client->StopRun();
-
     return ret_val;
 }
\ No newline at end of file
@@ -1,10 +1,276 @@
 #include "query_federate_input.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
 #include "json_templates.hpp"
 
+namespace
+{
+
+/**
+ * @return std::nullopt unless json_value is a non empty string or an object with a non empty "query".
+ */
+std::optional<data::QuerySpec> QuerySpecFromJson(const boost::json::value &json_value)
+{
+    std::optional<data::QuerySpec> spec{};
+    if (json_value.is_string())
+    {
+        if (!json_value.as_string().empty())
+        {
+            spec = data::QuerySpec{ "root", boost::json::value_to<std::string>(json_value) };
+        }
+        return spec;
+    }
+    if (!json_value.is_object())
+    {
+        return spec;
+    }
+
+    const boost::json::object &obj = json_value.as_object();
+    const boost::json::value *target = obj.if_contains("target");
+    const boost::json::value *query = obj.if_contains("query");
+    if (query == nullptr || !query->is_string() || query->as_string().empty()) return spec;
+    if (target != nullptr && (!target->is_string() || target->as_string().empty())) return spec;
+
+    spec = data::QuerySpec{ target != nullptr ? boost::json::value_to<std::string>(*target) : "root",
+                            boost::json::value_to<std::string>(*query) };
+    return spec;
+}
+
+} // namespace
+
+void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::DeflateDetails &data)
+{
+    json_value = { { "enabled", data.enabled },
+                   { "level", data.level },
+                   { "client_max_window_bits", data.client_max_window_bits },
+                   { "server_max_window_bits", data.server_max_window_bits },
+                   { "mem_level", data.mem_level },
+                   { "no_context_takeover", data.no_context_takeover },
+                   { "min_message_bytes", data.min_message_bytes },
+                   { "sample_every", data.sample_every } };
+}
+
+data::DeflateDetails data::tag_invoke(boost::json::value_to_tag<data::DeflateDetails>,
+                                      const boost::json::value &json_value)
+{
+    data::DeflateDetails data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "enabled", data.enabled);
+    utils::extract(obj, "level", data.level);
+    utils::extract(obj, "client_max_window_bits", data.client_max_window_bits);
+    utils::extract(obj, "server_max_window_bits", data.server_max_window_bits);
+    utils::extract(obj, "mem_level", data.mem_level);
+    utils::extract(obj, "no_context_takeover", data.no_context_takeover);
+    utils::extract(obj, "min_message_bytes", data.min_message_bytes);
+    utils::extract(obj, "sample_every", data.sample_every);
+
+    return data;
+}
+
+std::optional<data::LogLevel> data::LogLevelFromString(const std::string &level)
+{
+    std::optional<data::LogLevel> result{};
+    if (level == "error") result = data::LogLevel::ERROR;
+    if (level == "info") result = data::LogLevel::INFO;
+    if (level == "debug") result = data::LogLevel::DEBUG;
+    return result;
+}
+
+std::string data::ToString(data::LogLevel level)
+{
+    switch (level)
+    {
+    case data::LogLevel::ERROR:
+        return "error";
+    case data::LogLevel::INFO:
+        return "info";
+    case data::LogLevel::DEBUG:
+        return "debug";
+    }
+    return "debug";
+}
+
+std::string data::QuerySpec::GetName() const
+{
+    return target == "root" ? query : target + "/" + query;
+}
+
+void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::QuerySpec &data)
+{
+    // Root queries keep the plain string form they have always had in the config and the command replies
+    if (data.target == "root")
+    {
+        json_value = data.query;
+    }
+    else
+    {
+        json_value = { { "target", data.target }, { "query", data.query } };
+    }
+}
+
+data::QuerySpec data::tag_invoke(boost::json::value_to_tag<data::QuerySpec>, const boost::json::value &json_value)
+{
+    const std::optional<data::QuerySpec> spec = QuerySpecFromJson(json_value);
+    if (!spec)
+    {
+        throw std::invalid_argument("a query must be a string or an object with a target and a query");
+    }
+
+    return spec.value();
+}
+
+std::optional<data::QuerySampling> data::QuerySamplingFromString(const std::string &sampling)
+{
+    std::optional<data::QuerySampling> result{};
+    if (sampling == "every_n") result = data::QuerySampling::EVERY_N;
+    if (sampling == "interval") result = data::QuerySampling::INTERVAL;
+    if (sampling == "adaptive") result = data::QuerySampling::ADAPTIVE;
+    return result;
+}
+
+std::string data::ToString(data::QuerySampling sampling)
+{
+    switch (sampling)
+    {
+    case data::QuerySampling::EVERY_N:
+        return "every_n";
+    case data::QuerySampling::INTERVAL:
+        return "interval";
+    case data::QuerySampling::ADAPTIVE:
+        return "adaptive";
+    }
+    return "every_n";
+}
+
+void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::RuntimeSettings &data)
+{
+    json_value = { { "log_level", data::ToString(data.log_level) },
+                   { "query_sampling", data::ToString(data.query_sampling) },
+                   { "query_every", data.query_every },
+                   { "query_interval_ms", data.query_interval_ms },
+                   { "query_budget", data.query_budget },
+                   { "report_every", data.report_every },
+                   { "queries", boost::json::value_from(data.queries) },
+                   { "stall_timeout_ms", data.stall_timeout_ms },
+                   { "stall_queries", boost::json::value_from(data.stall_queries) } };
+}
+
+data::RuntimeSettings data::tag_invoke(boost::json::value_to_tag<data::RuntimeSettings>,
+                                       const boost::json::value &json_value)
+{
+    // Keys left out keep the defaults, so an empty "runtime" block behaves like the federate always did
+    data::RuntimeSettings data;
+    const std::string error = data::MergeRuntimeSettings(json_value.as_object(), data);
+    if (!error.empty())
+    {
+        throw std::invalid_argument("runtime: " + error);
+    }
+
+    return data;
+}
+
+std::string data::MergeRuntimeSettings(const boost::json::object &obj, data::RuntimeSettings &settings)
+{
+    // A misspelled key would otherwise be accepted and silently change nothing
+    static const std::string known_keys[] = { "log_level",    "query_sampling", "query_every", "query_interval_ms",
+                                              "query_budget", "report_every",   "queries",     "stall_timeout_ms",
+                                              "stall_queries" };
+    for (const auto &[key, value] : obj)
+    {
+        if (std::find(std::begin(known_keys), std::end(known_keys), key) == std::end(known_keys))
+        {
+            return "unknown setting '" + std::string(key) + "'";
+        }
+    }
+
+    data::RuntimeSettings merged = settings;
+
+    if (const boost::json::value *found = obj.if_contains("log_level"))
+    {
+        const std::optional<data::LogLevel> level =
+            found->is_string() ? data::LogLevelFromString(boost::json::value_to<std::string>(*found)) : std::nullopt;
+        if (!level) return "log_level must be one of 'error', 'info' or 'debug'";
+        merged.log_level = level.value();
+    }
+
+    for (const auto &[key, field] : { std::make_pair("query_every", &merged.query_every),
+                                      std::make_pair("report_every", &merged.report_every) })
+    {
+        if (const boost::json::value *found = obj.if_contains(key))
+        {
+            if (!found->is_int64() || found->as_int64() < 1) return std::string(key) + " must be a positive integer";
+            *field = static_cast<std::uint32_t>(found->as_int64());
+        }
+    }
+
+    if (const boost::json::value *found = obj.if_contains("query_sampling"))
+    {
+        const std::optional<data::QuerySampling> sampling =
+            found->is_string() ? data::QuerySamplingFromString(boost::json::value_to<std::string>(*found))
+                               : std::nullopt;
+        if (!sampling) return "query_sampling must be one of 'every_n', 'interval' or 'adaptive'";
+        merged.query_sampling = sampling.value();
+    }
+
+    if (const boost::json::value *found = obj.if_contains("query_interval_ms"))
+    {
+        if (!found->is_number() || found->to_number<double>() <= 0.0) return "query_interval_ms must be positive";
+        merged.query_interval_ms = found->to_number<double>();
+    }
+
+    if (const boost::json::value *found = obj.if_contains("query_budget"))
+    {
+        const double budget = found->is_number() ? found->to_number<double>() : 0.0;
+        if (budget <= 0.0 || budget > 1.0) return "query_budget must be a fraction of the step time in (0, 1]";
+        merged.query_budget = budget;
+    }
+
+    if (const boost::json::value *found = obj.if_contains("stall_timeout_ms"))
+    {
+        if (!found->is_number() || found->to_number<double>() < 0.0) return "stall_timeout_ms must not be negative";
+        merged.stall_timeout_ms = found->to_number<double>();
+    }
+
+    for (const auto &[key, field] : { std::make_pair("queries", &merged.queries),
+                                      std::make_pair("stall_queries", &merged.stall_queries) })
+    {
+        if (const boost::json::value *found = obj.if_contains(key))
+        {
+            const std::string error =
+                std::string(key) + " must be an array of strings or { \"target\", \"query\" } objects";
+            if (!found->is_array()) return error;
+            std::vector<data::QuerySpec> queries;
+            for (const boost::json::value &query : found->as_array())
+            {
+                std::optional<data::QuerySpec> spec = QuerySpecFromJson(query);
+                if (!spec) return error;
+                queries.push_back(std::move(spec.value()));
+            }
+            *field = std::move(queries);
+        }
+    }
+
+    settings = std::move(merged);
+    return "";
+}
+
 void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::ClientDetails &data)
 {
-    json_value = { { "host", data.host }, { "port", data.port }, { "target", data.target } };
+    json_value = { { "host", data.host },
+                   { "port", data.port },
+                   { "target", data.target },
+                   { "max_queued_messages", data.max_queued_messages },
+                   { "max_frame_bytes", data.max_frame_bytes },
+                   { "overflow_policy", data.overflow_policy },
+                   { "reconnect", data.reconnect },
+                   { "reconnect_initial_backoff_ms", data.reconnect_initial_backoff_ms },
+                   { "reconnect_max_backoff_ms", data.reconnect_max_backoff_ms },
+                   { "replay_buffer_messages", data.replay_buffer_messages },
+                   { "permessage_deflate", data.permessage_deflate } };
 }
 
 data::ClientDetails data::tag_invoke(boost::json::value_to_tag<data::ClientDetails>,
@@ -16,6 +282,52 @@ data::ClientDetails data::tag_invoke(boost::json::value_to_tag<data::ClientDetai
     utils::extract(obj, "host", data.host);
     utils::extract(obj, "port", data.port);
     utils::extract(obj, "target", data.target);
+    utils::extract(obj, "max_queued_messages", data.max_queued_messages);
+    utils::extract(obj, "max_frame_bytes", data.max_frame_bytes);
+    utils::extract(obj, "overflow_policy", data.overflow_policy);
+    utils::extract(obj, "reconnect", data.reconnect);
+    utils::extract(obj, "reconnect_initial_backoff_ms", data.reconnect_initial_backoff_ms);
+    utils::extract(obj, "reconnect_max_backoff_ms", data.reconnect_max_backoff_ms);
+    utils::extract(obj, "replay_buffer_messages", data.replay_buffer_messages);
+    utils::extract(obj, "permessage_deflate", data.permessage_deflate);
+
+    return data;
+}
+
+void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::AsyncLogDetails &data)
+{
+    json_value = { { "enabled", data.enabled },
+                   { "max_batch_bytes", data.max_batch_bytes },
+                   { "max_batch_delay_ms", data.max_batch_delay_ms } };
+}
+
+data::AsyncLogDetails data::tag_invoke(boost::json::value_to_tag<data::AsyncLogDetails>,
+                                       const boost::json::value &json_value)
+{
+    data::AsyncLogDetails data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "enabled", data.enabled);
+    utils::extract(obj, "max_batch_bytes", data.max_batch_bytes);
+    utils::extract(obj, "max_batch_delay_ms", data.max_batch_delay_ms);
+
+    return data;
+}
+
+void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::MetricsDetails &data)
+{
+    json_value = { { "enabled", data.enabled }, { "address", data.address }, { "port", data.port } };
+}
+
+data::MetricsDetails data::tag_invoke(boost::json::value_to_tag<data::MetricsDetails>,
+                                      const boost::json::value &json_value)
+{
+    data::MetricsDetails data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "enabled", data.enabled);
+    utils::extract(obj, "address", data.address);
+    utils::extract(obj, "port", data.port);
 
     return data;
 }
@@ -26,7 +338,14 @@ void data::tag_invoke(boost::json::value_from_tag, boost::json::value &json_valu
                    { "fed_info_json", boost::json::parse(data.fed_info_json) },
                    { "client_details", data.client_details },
                    { "total_time", data.total_time },
-                   { "local_log_file", data.local_log_file } };
+                   { "local_log_file", data.local_log_file },
+                   { "async_log", data.async_log },
+                   { "profile_file", data.profile_file },
+                   { "trace_file", data.trace_file },
+                   { "time_report_file", data.time_report_file },
+                   { "metrics", data.metrics },
+                   { "send_telemetry", data.send_telemetry },
+                   { "runtime", data.runtime } };
 }
 
 data::QueryFederateInput data::tag_invoke(boost::json::value_to_tag<data::QueryFederateInput>,
@@ -40,6 +359,13 @@ data::QueryFederateInput data::tag_invoke(boost::json::value_to_tag<data::QueryF
     utils::extract(obj, "client_details", data.client_details);
     utils::extract(obj, "total_time", data.total_time);
     utils::extract(obj, "local_log_file", data.local_log_file);
+    utils::extract(obj, "async_log", data.async_log);
+    utils::extract(obj, "profile_file", data.profile_file);
+    utils::extract(obj, "trace_file", data.trace_file);
+    utils::extract(obj, "time_report_file", data.time_report_file);
+    utils::extract(obj, "metrics", data.metrics);
+    utils::extract(obj, "send_telemetry", data.send_telemetry);
+    utils::extract(obj, "runtime", data.runtime);
 
     return data;
 }
\ No newline at end of file
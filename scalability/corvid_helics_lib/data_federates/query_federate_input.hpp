@@ -1,17 +1,141 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <boost/json.hpp>
 
 namespace data
 {
 
+/**
+ * permessage-deflate settings, see utils::CompressionOptions. Values left at zero keep the library defaults.
+ */
+struct DeflateDetails
+{
+    bool enabled{};
+    int level{};
+    int client_max_window_bits{};
+    int server_max_window_bits{};
+    int mem_level{};
+    bool no_context_takeover{};
+    std::size_t min_message_bytes{};
+    std::uint32_t sample_every{};
+};
+
+/**
+ * ERROR only logs failures and the end of run summary, INFO adds a line per report, DEBUG adds every query result.
+ */
+enum class LogLevel
+{
+    ERROR,
+    INFO,
+    DEBUG
+};
+
+std::optional<LogLevel> LogLevelFromString(const std::string &level);
+std::string ToString(LogLevel level);
+
+/**
+ * When the monitoring queries run, see data::QuerySampler. EVERY_N runs them every query_every steps, INTERVAL every
+ * query_interval_ms of wall time, ADAPTIVE starts at query_every and doubles the stride while the queries cost more
+ * than query_budget of the step time, halving it again once they are well under.
+ */
+enum class QuerySampling
+{
+    EVERY_N,
+    INTERVAL,
+    ADAPTIVE
+};
+
+std::optional<QuerySampling> QuerySamplingFromString(const std::string &sampling);
+std::string ToString(QuerySampling sampling);
+
+/**
+ * One query and the federate, core or broker that answers it. In the config a plain string is a query to the root
+ * broker, { "target": "gld_1", "query": "publications" } sends it elsewhere.
+ */
+struct QuerySpec
+{
+    std::string target{ "root" };
+    std::string query{};
+
+    /**
+     * @brief The query for the root broker, target/query for anything else. Used in the logs and telemetry.
+     */
+    std::string GetName() const;
+};
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const QuerySpec &data);
+QuerySpec tag_invoke(boost::json::value_to_tag<QuerySpec>, const boost::json::value &json_value);
+
+/**
+ * Monitoring settings that can be changed while the federate runs, see data::RuntimeControl. The values here are the
+ * ones the federate starts with.
+ */
+struct RuntimeSettings
+{
+    LogLevel log_level{ LogLevel::DEBUG };
+    QuerySampling query_sampling{ QuerySampling::EVERY_N };
+    // Run the queries every N granted steps, the smallest stride in adaptive mode
+    std::uint32_t query_every{ 1 };
+    // Wall time between query runs in interval mode
+    double query_interval_ms{ 1000.0 };
+    // Share of the step time the queries may take in adaptive mode, averaged over the stride
+    double query_budget{ 0.05 };
+    // Log a step summary and send a telemetry frame every N granted steps
+    std::uint32_t report_every{ 1 };
+    // Sent together each time the queries run, so a batch costs about one round trip
+    std::vector<QuerySpec> queries{ { "root", "name" }, { "root", "address" }, { "root", "isinit" },
+                                    { "root", "isconnected" } };
+    // Heavy queries only run once a grant has been outstanding for stall_timeout_ms, while the federation is stuck.
+    // 0 or no stall queries disables the watch.
+    double stall_timeout_ms{ 10000.0 };
+    std::vector<QuerySpec> stall_queries{ { "root", "global_time_debugging" } };
+};
+
 struct ClientDetails
 {
     std::string host{};
     std::string port{};
     std::string target{};
+
+    // Send queue bounds and frame coalescing, see utils::SendOptions
+    std::size_t max_queued_messages{};
+    std::size_t max_frame_bytes{};
+    std::string overflow_policy{ "block" };
+
+    // Reconnect with backoff and replay, see utils::ReconnectOptions
+    bool reconnect{};
+    double reconnect_initial_backoff_ms{};
+    double reconnect_max_backoff_ms{};
+    std::size_t replay_buffer_messages{};
+
+    DeflateDetails permessage_deflate{};
+};
+
+/**
+ * Batches log statements on a background thread, see utils::AsyncLogOptions. Values left at zero keep the defaults.
+ */
+struct AsyncLogDetails
+{
+    bool enabled{};
+    std::size_t max_batch_bytes{};
+    double max_batch_delay_ms{};
+};
+
+/**
+ * Prometheus endpoint, see utils::MetricsServer. The address defaults to loopback, set "0.0.0.0" to scrape from
+ * another host.
+ */
+struct MetricsDetails
+{
+    bool enabled{};
+    std::string address{};
+    unsigned short port{};
 };
 
 struct QueryFederateInput
@@ -21,11 +145,43 @@ struct QueryFederateInput
     ClientDetails client_details{};
     double total_time{};
     std::string local_log_file{};
+    AsyncLogDetails async_log{};
+    // Zone profile written here as JSON at exit, empty for the log summary only
+    std::string profile_file{};
+    // Chrome trace of the zones and grants, merge with the other federates' traces using merge_traces. Empty disables.
+    std::string trace_file{};
+    // Blocked versus compute time per step, combine with the other federates' reports using combine_time_reports.
+    // Empty only logs the summary.
+    std::string time_report_file{};
+    MetricsDetails metrics{};
+    // Sends per step timings as binary telemetry frames next to the text log
+    bool send_telemetry{};
+    RuntimeSettings runtime{};
 };
 
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::DeflateDetails &data);
+data::DeflateDetails tag_invoke(boost::json::value_to_tag<data::DeflateDetails>, const boost::json::value &json_value);
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::RuntimeSettings &data);
+data::RuntimeSettings tag_invoke(boost::json::value_to_tag<data::RuntimeSettings>,
+                                 const boost::json::value &json_value);
+
+/**
+ * @brief Applies only the keys present in obj on top of settings, used for partial updates.
+ * @return an error message, empty if every key was valid. Nothing is applied when a key is invalid or unknown.
+ */
+std::string MergeRuntimeSettings(const boost::json::object &obj, data::RuntimeSettings &settings);
+
 void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::ClientDetails &data);
 data::ClientDetails tag_invoke(boost::json::value_to_tag<data::ClientDetails>, const boost::json::value &json_value);
 
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::AsyncLogDetails &data);
+data::AsyncLogDetails tag_invoke(boost::json::value_to_tag<data::AsyncLogDetails>,
+                                 const boost::json::value &json_value);
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::MetricsDetails &data);
+data::MetricsDetails tag_invoke(boost::json::value_to_tag<data::MetricsDetails>, const boost::json::value &json_value);
+
 void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const data::QueryFederateInput &data);
 data::QueryFederateInput tag_invoke(boost::json::value_to_tag<data::QueryFederateInput>,
                                     const boost::json::value &json_value);
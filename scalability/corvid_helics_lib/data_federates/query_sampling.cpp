@@ -0,0 +1,172 @@
+#include "query_sampling.hpp"
+
+#include <algorithm>
+
+namespace
+{
+
+// Stride the adaptive mode backs off to at most, a few hours of one second steps
+constexpr std::uint32_t MAX_ADAPTIVE_STRIDE = 4096;
+
+// Weight of the newest step in the step time average
+constexpr double STEP_AVERAGE_WEIGHT = 0.1;
+
+} // namespace
+
+// ###################################
+// QuerySampler Implementation
+// ###################################
+
+bool data::QuerySampler::ShouldRun(const data::RuntimeSettings &settings, Clock::time_point now)
+{
+    m_steps_since_run++;
+
+    bool should_run = false;
+    switch (settings.query_sampling)
+    {
+    case data::QuerySampling::EVERY_N:
+        should_run = m_steps_since_run >= settings.query_every;
+        break;
+    case data::QuerySampling::INTERVAL:
+        should_run = !m_last_run || std::chrono::duration<double, std::milli>(now - m_last_run.value()).count() >=
+                                        settings.query_interval_ms;
+        break;
+    case data::QuerySampling::ADAPTIVE:
+        // query_every is the floor, raising it at runtime takes effect straight away
+        m_stride = std::max(m_stride, settings.query_every);
+        should_run = m_steps_since_run >= m_stride;
+        break;
+    }
+
+    if (should_run)
+    {
+        m_steps_since_run = 0;
+        m_last_run = now;
+    }
+    return should_run;
+}
+
+void data::QuerySampler::RecordStep(double step_ms)
+{
+    m_step_ms = m_step_ms > 0.0 ? m_step_ms + STEP_AVERAGE_WEIGHT * (step_ms - m_step_ms) : step_ms;
+}
+
+bool data::QuerySampler::RecordQueries(const data::RuntimeSettings &settings, double query_ms)
+{
+    if (settings.query_sampling != data::QuerySampling::ADAPTIVE || m_step_ms <= 0.0)
+    {
+        return false;
+    }
+
+    // One run is spread over the stride, so it fits the budget while query_ms / stride <= budget * step_ms
+    const double allowed_ms = settings.query_budget * m_step_ms * m_stride;
+    const std::uint32_t previous_stride = m_stride;
+    if (query_ms > allowed_ms && m_stride < MAX_ADAPTIVE_STRIDE)
+    {
+        m_stride = std::min(m_stride * 2, MAX_ADAPTIVE_STRIDE);
+    }
+    else if (query_ms * 4.0 < allowed_ms && m_stride > settings.query_every)
+    {
+        // Only come back down with room to spare, halving still leaves the run at half the budget
+        m_stride = std::max(m_stride / 2, settings.query_every);
+    }
+
+    return m_stride != previous_stride;
+}
+
+// ###################################
+// StallWatchdog Implementation
+// ###################################
+
+data::StallWatchdog::StallWatchdog(StallHandler on_stall) : m_on_stall(std::move(on_stall))
+{
+    m_thread = std::thread([this]() { Run(); });
+}
+
+data::StallWatchdog::~StallWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopping = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void data::StallWatchdog::Arm(double timeout_ms)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_armed_at = Clock::now();
+        m_deadline = m_armed_at + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double, std::milli>(timeout_ms));
+        m_wait_id++;
+        m_has_fired = false;
+    }
+    m_cv.notify_all();
+}
+
+data::StallOutcome data::StallWatchdog::Disarm(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_deadline.reset();
+    m_wait_id++;
+    m_cv.notify_all();
+
+    data::StallOutcome outcome;
+    outcome.has_fired = m_has_fired;
+    outcome.is_running = !m_cv.wait_for(lock, timeout, [this]() { return !m_is_handling; });
+    if (outcome.is_running)
+    {
+        return outcome;
+    }
+
+    outcome.error = m_error;
+    m_has_fired = false;
+    m_error = nullptr;
+    return outcome;
+}
+
+void data::StallWatchdog::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_is_stopping)
+    {
+        if (!m_deadline)
+        {
+            m_cv.wait(lock);
+            continue;
+        }
+
+        const std::uint64_t wait_id = m_wait_id;
+        const bool is_disarmed = m_cv.wait_until(lock, m_deadline.value(), [this, wait_id]()
+                                                 { return m_is_stopping || m_wait_id != wait_id || !m_deadline; });
+        if (is_disarmed)
+        {
+            continue;
+        }
+
+        // Still the same wait past its deadline, handle it once and leave the lock free for Disarm meanwhile
+        m_deadline.reset();
+        m_is_handling = true;
+        m_has_fired = true;
+        const double waited_ms = std::chrono::duration<double, std::milli>(Clock::now() - m_armed_at).count();
+
+        // An exception would end this thread with std::terminate, keep it for Disarm to hand over instead
+        std::exception_ptr error{};
+        lock.unlock();
+        try
+        {
+            m_on_stall(waited_ms);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        m_error = error;
+        m_is_handling = false;
+        m_cv.notify_all();
+    }
+}
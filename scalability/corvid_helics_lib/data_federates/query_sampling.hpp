@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "query_federate_input.hpp"
+
+namespace data
+{
+
+/**
+ * Decides per granted step whether the monitoring queries run, following RuntimeSettings::query_sampling. The
+ * settings are passed in on every call so a runtime "set" takes effect at the next step. Federate thread only.
+ */
+class QuerySampler
+{
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    std::uint32_t m_stride{ 1 };
+    std::uint64_t m_steps_since_run{};
+    std::optional<Clock::time_point> m_last_run{};
+    // Moving average of the step time without the queries, what the step would cost if nobody was monitoring
+    double m_step_ms{};
+
+  public:
+    /**
+     * @brief Call once per granted step, counts the step and starts a new sampling period when it returns true.
+     */
+    bool ShouldRun(const RuntimeSettings &settings, Clock::time_point now);
+
+    /**
+     * @param step_ms the step's wall time less the time spent in its queries.
+     */
+    void RecordStep(double step_ms);
+
+    /**
+     * @brief Adjusts the adaptive stride against the budget, a no-op in the other modes.
+     * @return true if the stride changed.
+     */
+    bool RecordQueries(const RuntimeSettings &settings, double query_ms);
+
+    /**
+     * @brief Steps between query runs in adaptive mode.
+     */
+    std::uint32_t GetStride() const { return m_stride; }
+};
+
+/**
+ * What happened to the stall handler during one armed wait, see StallWatchdog::Disarm.
+ */
+struct StallOutcome
+{
+    bool has_fired{};           // the handler ran, or is still running, for this wait
+    bool is_running{};          // Disarm gave up waiting, nothing the handler writes may be read yet
+    std::exception_ptr error{}; // what the handler threw, if it threw
+};
+
+/**
+ * Runs a handler on its own thread when a wait outlives its timeout, used to send the heavy stall queries while the
+ * federate thread is still blocked in requestTime. The handler runs at most once per Arm.
+ */
+class StallWatchdog
+{
+  public:
+    using StallHandler = std::function<void(double waited_ms)>;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    StallHandler m_on_stall;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // Set while armed and the handler has not run yet
+    std::optional<Clock::time_point> m_deadline{};
+    Clock::time_point m_armed_at{};
+    std::uint64_t m_wait_id{};
+    bool m_is_handling{};
+    bool m_has_fired{};
+    std::exception_ptr m_error{};
+    bool m_is_stopping{};
+    std::thread m_thread;
+
+    void Run();
+
+  public:
+    explicit StallWatchdog(StallHandler on_stall);
+    ~StallWatchdog();
+
+    StallWatchdog(const StallWatchdog &) = delete;
+    StallWatchdog &operator=(const StallWatchdog &) = delete;
+
+    /**
+     * @brief Starts watching a wait. Do not arm while an earlier Disarm still reports the handler running.
+     */
+    void Arm(double timeout_ms);
+
+    /**
+     * @brief Stops watching the wait and waits up to timeout for a handler that is still running.
+     * Unless is_running is set, the handler has finished, so whatever it wrote can be read without further locking.
+     * Otherwise call Disarm again later, without arming, to collect the outcome once the handler is done.
+     */
+    StallOutcome Disarm(std::chrono::milliseconds timeout);
+};
+
+} // namespace data
@@ -0,0 +1,72 @@
+#include "runtime_control.hpp"
+
+#include <boost/json.hpp>
+
+#include <utility>
+
+data::RuntimeControl::RuntimeControl(const data::RuntimeSettings &initial) : m_settings(initial) {}
+
+data::RuntimeSettings data::RuntimeControl::GetSettings(std::uint64_t &revision) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    revision = m_revision.load(std::memory_order_relaxed);
+    return m_settings;
+}
+
+std::optional<std::string> data::RuntimeControl::HandleMessage(const std::string &message)
+{
+    std::optional<std::string> reply{};
+
+    boost::system::error_code ec;
+    const boost::json::value parsed = boost::json::parse(message, ec);
+    if (ec || !parsed.is_object())
+    {
+        return reply;
+    }
+
+    const boost::json::object &obj = parsed.as_object();
+    const boost::json::value *command_value = obj.if_contains("command");
+    if (command_value == nullptr || !command_value->is_string())
+    {
+        return reply;
+    }
+
+    const std::string command = boost::json::value_to<std::string>(*command_value);
+    const boost::json::value *id = obj.if_contains("id");
+
+    std::string error;
+    boost::json::value settings_json;
+    std::uint64_t revision = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (command == "set")
+        {
+            const boost::json::value *settings = obj.if_contains("settings");
+            if (settings == nullptr || !settings->is_object())
+            {
+                error = "set needs a settings object";
+            }
+            else
+            {
+                error = data::MergeRuntimeSettings(settings->as_object(), m_settings);
+                if (error.empty()) m_revision.fetch_add(1, std::memory_order_release);
+            }
+        }
+        else if (command != "get")
+        {
+            error = "unknown command '" + command + "'";
+        }
+
+        settings_json = boost::json::value_from(m_settings);
+        revision = m_revision.load(std::memory_order_relaxed);
+    }
+
+    reply = boost::json::serialize(boost::json::object{ { "type", "command_reply" },
+                                                        { "id", id != nullptr ? *id : boost::json::value() },
+                                                        { "command", command },
+                                                        { "ok", error.empty() },
+                                                        { "error", error },
+                                                        { "revision", revision },
+                                                        { "settings", std::move(settings_json) } });
+    return reply;
+}
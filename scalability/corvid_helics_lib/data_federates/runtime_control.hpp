@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "query_federate_input.hpp"
+
+namespace data
+{
+
+/**
+ * Command channel for retuning a running federate. Commands arrive as JSON text on the WebSocket connection,
+ *
+ *   { "command": "get", "id": "1" }
+ *   { "command": "set", "id": "2", "settings": { "log_level": "info", "query_every": 10, "queries": [ "name" ] } }
+ *   { "command": "set", "id": "3", "settings": { "queries": [ "name", { "target": "gpk_118", "query": "state" } ] } }
+ *
+ * "set" applies only the keys it contains, and applies none of them if any is invalid. Every command gets a reply
+ * with the settings now in effect,
+ *
+ *   { "type": "command_reply", "id": "2", "command": "set", "ok": true, "error": "", "revision": 1,
+ *     "settings": { ... } }
+ *
+ * HandleMessage is called from the client thread and GetSettings from the federate thread, the federate picks the
+ * new settings up at its next granted step.
+ */
+class RuntimeControl
+{
+  private:
+    mutable std::mutex m_mutex;
+    RuntimeSettings m_settings;
+    std::atomic<std::uint64_t> m_revision{};
+
+  public:
+    explicit RuntimeControl(const RuntimeSettings &initial);
+
+    /**
+     * @brief Cheap check for the federate loop, only call GetSettings when this changes.
+     */
+    std::uint64_t GetRevision() const { return m_revision.load(std::memory_order_acquire); }
+
+    /**
+     * @param revision set to the revision of the returned settings.
+     */
+    RuntimeSettings GetSettings(std::uint64_t &revision) const;
+
+    /**
+     * @return the reply to send back, or std::nullopt if the message is not a command.
+     */
+    std::optional<std::string> HandleMessage(const std::string &message);
+};
+
+} // namespace data
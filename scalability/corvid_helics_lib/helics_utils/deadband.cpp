@@ -0,0 +1,124 @@
+#include "deadband.hpp"
+
+#include "json_templates.hpp"
+
+void utils::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const utils::DeadbandOptions &data)
+{
+    json_value = { { "absolute", data.absolute },
+                   { "relative", data.relative },
+                   { "refresh_interval", data.refresh_interval } };
+}
+
+utils::DeadbandOptions utils::tag_invoke(boost::json::value_to_tag<utils::DeadbandOptions>,
+                                         const boost::json::value &json_value)
+{
+    utils::DeadbandOptions data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "absolute", data.absolute);
+    utils::extract(obj, "relative", data.relative);
+    utils::extract(obj, "refresh_interval", data.refresh_interval);
+
+    return data;
+}
+
+bool utils::IsOutsideDeadband(const std::complex<double> &last, const std::complex<double> &current,
+                              const utils::DeadbandOptions &options)
+{
+    const bool has_absolute = options.absolute > 0.0;
+    const bool has_relative = options.relative > 0.0;
+    if (!has_absolute && !has_relative)
+    {
+        return true;
+    }
+
+    const double delta = std::abs(current - last);
+    return (has_absolute && delta > options.absolute) || (has_relative && delta > options.relative * std::abs(last));
+}
+
+namespace
+{
+
+bool IsRefreshDue(double last_time, double current_time, const utils::DeadbandOptions &options)
+{
+    return options.refresh_interval > 0.0 && current_time - last_time >= options.refresh_interval;
+}
+
+} // namespace
+
+// ###################################
+// DeadbandPublication Implementation
+// ###################################
+
+utils::DeadbandPublication::DeadbandPublication(const helics::Publication &pub, const utils::DeadbandOptions &options)
+    : m_pub(pub), m_options(options)
+{
+}
+
+bool utils::DeadbandPublication::IsDue(const std::complex<double> &value, double current_time) const
+{
+    return !m_has_value || IsOutsideDeadband(m_last_value, value, m_options) ||
+           IsRefreshDue(m_last_time, current_time, m_options);
+}
+
+bool utils::DeadbandPublication::Publish(const std::complex<double> &value, double current_time)
+{
+    if (!IsDue(value, current_time))
+    {
+        Suppress();
+        return false;
+    }
+
+    ForcePublish(value, current_time);
+    return true;
+}
+
+void utils::DeadbandPublication::ForcePublish(const std::complex<double> &value, double current_time)
+{
+    m_pub.publish(value);
+    m_published_count++;
+
+    m_last_value = value;
+    m_last_time = current_time;
+    m_has_value = true;
+}
+
+// ###################################
+// DeadbandInput Implementation
+// ###################################
+
+utils::DeadbandInput::DeadbandInput(const helics::Input &input, const utils::DeadbandOptions &options)
+    : m_input(input), m_options(options)
+{
+}
+
+bool utils::DeadbandInput::Update(double current_time)
+{
+    if (!m_input.isUpdated() && (m_has_value || !m_input.isValid()))
+    {
+        return false;
+    }
+
+    const std::complex<double> value = m_input.getValue<std::complex<double>>();
+    const bool should_accept = !m_has_value || IsOutsideDeadband(m_value, value, m_options) ||
+                               IsRefreshDue(m_last_time, current_time, m_options);
+    if (!should_accept)
+    {
+        m_suppressed_count++;
+        return false;
+    }
+
+    m_value = value;
+    m_last_time = current_time;
+    m_has_value = true;
+    m_accepted_count++;
+
+    return true;
+}
+
+void utils::DeadbandInput::Restore(const std::complex<double> &value, double time)
+{
+    m_value = value;
+    m_last_time = time;
+    m_has_value = true;
+}
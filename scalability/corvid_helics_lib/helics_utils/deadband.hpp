@@ -0,0 +1,125 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+
+#include <boost/json.hpp>
+
+#include <helics/application_api/Publications.hpp>
+#include <helics/application_api/Inputs.hpp>
+
+namespace utils
+{
+
+/**
+ * A value is only passed on when it moved further than the deadband from the last value that was passed on, that is
+ * when it exceeds either configured threshold. Zero disables a threshold, so a default constructed DeadbandOptions
+ * lets every value through.
+ */
+struct DeadbandOptions
+{
+    double absolute{};         // |new - last| must exceed this
+    double relative{};         // |new - last| must exceed this fraction of |last|
+    double refresh_interval{}; // force the value through after this much simulated time, 0 disables
+};
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const DeadbandOptions &data);
+DeadbandOptions tag_invoke(boost::json::value_to_tag<DeadbandOptions>, const boost::json::value &json_value);
+
+/**
+ * @brief Checks whether the change from last to current is outside of the deadband.
+ * @return true if either configured threshold is exceeded, or no threshold is configured.
+ */
+bool IsOutsideDeadband(const std::complex<double> &last, const std::complex<double> &current,
+                       const DeadbandOptions &options);
+
+/**
+ * Wraps a helics::Publication and only publishes values that leave the deadband around the last published value,
+ * or when the refresh interval has passed since the last publish. The reference is whatever was last put on the
+ * wire, so several sources sharing one publication are compared with the value the subscribers actually hold.
+ */
+class DeadbandPublication
+{
+  private:
+    helics::Publication m_pub{};
+    DeadbandOptions m_options{};
+    std::complex<double> m_last_value{ 0.0, 0.0 };
+    double m_last_time{};
+    bool m_has_value{};
+
+    std::uint64_t m_published_count{};
+    std::uint64_t m_suppressed_count{};
+
+  public:
+    DeadbandPublication() = default;
+    DeadbandPublication(const helics::Publication &pub, const DeadbandOptions &options);
+
+    /**
+     * @brief Checks value against the deadband around the last published value, without publishing.
+     * @param current_time is the granted time, used for the forced refresh.
+     * @return true if nothing was published yet, value left the deadband or the refresh is due.
+     */
+    bool IsDue(const std::complex<double> &value, double current_time) const;
+
+    /**
+     * @brief Publishes value unless it is inside the deadband around the last published value.
+     * @param current_time is the granted time, used for the forced refresh.
+     * @return true if the value was published.
+     */
+    bool Publish(const std::complex<double> &value, double current_time);
+
+    /**
+     * @brief Publishes value whatever the deadband says, e.g. when the receiver depends on seeing every value, or
+     *        when the decision was made together with other publications.
+     */
+    void ForcePublish(const std::complex<double> &value, double current_time);
+
+    /**
+     * @brief Counts a value that was held back by a decision made together with other publications.
+     */
+    void Suppress() { m_suppressed_count++; }
+
+    std::uint64_t GetPublishedCount() const { return m_published_count; }
+    std::uint64_t GetSuppressedCount() const { return m_suppressed_count; }
+};
+
+/**
+ * Wraps a helics::Input and only accepts updates that leave the deadband around the last accepted value, or when
+ * the refresh interval has passed since the last accepted value. GetValue() always returns the last accepted value.
+ */
+class DeadbandInput
+{
+  private:
+    helics::Input m_input{};
+    DeadbandOptions m_options{};
+    std::complex<double> m_value{ 0.0, 0.0 };
+    double m_last_time{};
+    bool m_has_value{};
+
+    std::uint64_t m_accepted_count{};
+    std::uint64_t m_suppressed_count{};
+
+  public:
+    DeadbandInput() = default;
+    DeadbandInput(const helics::Input &input, const DeadbandOptions &options);
+
+    /**
+     * @brief Pulls a pending update from the input, if any, and runs it through the deadband.
+     * @param current_time is the granted time, used for the forced refresh.
+     * @return true if a new value was accepted.
+     */
+    bool Update(double current_time);
+
+    /**
+     * @brief Seeds the accepted value without going through the input, e.g. when resuming from a checkpoint.
+     */
+    void Restore(const std::complex<double> &value, double time);
+
+    const std::complex<double> &GetValue() const { return m_value; }
+    helics::Input &GetInput() { return m_input; }
+
+    std::uint64_t GetAcceptedCount() const { return m_accepted_count; }
+    std::uint64_t GetSuppressedCount() const { return m_suppressed_count; }
+};
+
+} // namespace utils
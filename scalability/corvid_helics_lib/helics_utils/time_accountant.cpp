@@ -0,0 +1,257 @@
+#include "time_accountant.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#include "json_templates.hpp"
+
+namespace
+{
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::uint64_t ToNanoseconds(double ms)
+{
+    return ms > 0.0 ? static_cast<std::uint64_t>(ms * 1e6) : 0;
+}
+
+double NanosecondsToMilliseconds(std::uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e6;
+}
+
+} // namespace
+
+// ###################################
+// JSON Conversions
+// ###################################
+
+void utils::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value,
+                       const utils::TimeAccountingStep &data)
+{
+    json_value = { { "granted_time", data.granted_time },
+                   { "blocked_ms", data.blocked_ms },
+                   { "compute_ms", data.compute_ms } };
+}
+
+utils::TimeAccountingStep utils::tag_invoke(boost::json::value_to_tag<utils::TimeAccountingStep>,
+                                            const boost::json::value &json_value)
+{
+    utils::TimeAccountingStep data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "granted_time", data.granted_time);
+    utils::extract(obj, "blocked_ms", data.blocked_ms);
+    utils::extract(obj, "compute_ms", data.compute_ms);
+
+    return data;
+}
+
+void utils::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value,
+                       const utils::TimeAccountingReport &data)
+{
+    json_value = { { "federate", data.federate },
+                   { "step_count", data.step_count },
+                   { "wall_ms", data.wall_ms },
+                   { "blocked_ms", data.blocked_ms },
+                   { "compute_ms", data.compute_ms },
+                   { "sim_time_start", data.sim_time_start },
+                   { "sim_time_end", data.sim_time_end },
+                   { "wall_sim_ratio", data.wall_sim_ratio },
+                   { "blocked_p50_ms", data.blocked_p50_ms },
+                   { "blocked_p99_ms", data.blocked_p99_ms },
+                   { "blocked_max_ms", data.blocked_max_ms },
+                   { "compute_p50_ms", data.compute_p50_ms },
+                   { "compute_p99_ms", data.compute_p99_ms },
+                   { "compute_max_ms", data.compute_max_ms },
+                   { "steps", boost::json::value_from(data.steps) } };
+}
+
+utils::TimeAccountingReport utils::tag_invoke(boost::json::value_to_tag<utils::TimeAccountingReport>,
+                                              const boost::json::value &json_value)
+{
+    utils::TimeAccountingReport data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "federate", data.federate);
+    utils::extract(obj, "step_count", data.step_count);
+    utils::extract(obj, "wall_ms", data.wall_ms);
+    utils::extract(obj, "blocked_ms", data.blocked_ms);
+    utils::extract(obj, "compute_ms", data.compute_ms);
+    utils::extract(obj, "sim_time_start", data.sim_time_start);
+    utils::extract(obj, "sim_time_end", data.sim_time_end);
+    utils::extract(obj, "wall_sim_ratio", data.wall_sim_ratio);
+    utils::extract(obj, "blocked_p50_ms", data.blocked_p50_ms);
+    utils::extract(obj, "blocked_p99_ms", data.blocked_p99_ms);
+    utils::extract(obj, "blocked_max_ms", data.blocked_max_ms);
+    utils::extract(obj, "compute_p50_ms", data.compute_p50_ms);
+    utils::extract(obj, "compute_p99_ms", data.compute_p99_ms);
+    utils::extract(obj, "compute_max_ms", data.compute_max_ms);
+    utils::extract(obj, "steps", data.steps);
+
+    return data;
+}
+
+// ###################################
+// TimeAccountant Implementation
+// ###################################
+
+utils::TimeAccountant::TimeAccountant(std::string federate, bool keep_steps)
+    : m_federate(std::move(federate)), m_keep_steps(keep_steps)
+{
+}
+
+helics::Time utils::TimeAccountant::RequestTime(helics::Federate &fed, helics::Time next_time)
+{
+    BeginWait();
+    const helics::Time granted_time = fed.requestTime(next_time);
+    EndWait(static_cast<double>(granted_time));
+    return granted_time;
+}
+
+helics::iteration_time utils::TimeAccountant::RequestTimeIterative(helics::Federate &fed, helics::Time next_time,
+                                                                   helics::IterationRequest iterate)
+{
+    BeginWait();
+    const helics::iteration_time result = fed.requestTimeIterative(next_time, iterate);
+    EndWait(static_cast<double>(result.grantedTime));
+    return result;
+}
+
+void utils::TimeAccountant::BeginWait()
+{
+    const Clock::time_point now = Clock::now();
+    if (!m_start_time)
+    {
+        m_start_time = now;
+    }
+    if (m_current)
+    {
+        CloseStep(now);
+    }
+
+    m_wait_start = now;
+    m_is_waiting = true;
+}
+
+void utils::TimeAccountant::EndWait(double granted_time)
+{
+    const Clock::time_point now = Clock::now();
+    if (!m_start_time)
+    {
+        m_start_time = now;
+    }
+
+    // A grant without a matching BeginWait, the previous step ran right up to it
+    if (m_current)
+    {
+        CloseStep(now);
+    }
+
+    if (!m_first_grant_time)
+    {
+        m_first_grant_time = now;
+        m_sim_time_start = granted_time;
+    }
+    m_sim_time_end = granted_time;
+
+    m_current = TimeAccountingStep{ granted_time, m_is_waiting ? ToMilliseconds(now - m_wait_start) : 0.0, 0.0 };
+    m_grant_time = now;
+    m_is_waiting = false;
+}
+
+void utils::TimeAccountant::CloseStep(Clock::time_point now)
+{
+    TimeAccountingStep step = m_current.value();
+    m_current.reset();
+    step.compute_ms = ToMilliseconds(now - m_grant_time);
+
+    m_step_count++;
+    m_blocked_ms += step.blocked_ms;
+    m_compute_ms += step.compute_ms;
+    m_blocked.Record(ToNanoseconds(step.blocked_ms));
+    m_compute.Record(ToNanoseconds(step.compute_ms));
+    if (m_keep_steps)
+    {
+        m_steps.push_back(step);
+    }
+}
+
+void utils::TimeAccountant::Finish()
+{
+    const Clock::time_point now = Clock::now();
+    if (m_current)
+    {
+        CloseStep(now);
+    }
+    if (m_start_time)
+    {
+        m_wall_ms = ToMilliseconds(now - m_start_time.value());
+    }
+    if (m_first_grant_time)
+    {
+        m_granted_wall_ms = ToMilliseconds(now - m_first_grant_time.value());
+    }
+    m_is_waiting = false;
+}
+
+utils::TimeAccountingReport utils::TimeAccountant::GetReport() const
+{
+    utils::TimeAccountingReport report;
+    report.federate = m_federate;
+    report.step_count = m_step_count;
+    report.wall_ms = m_wall_ms;
+    report.blocked_ms = m_blocked_ms;
+    report.compute_ms = m_compute_ms;
+    report.sim_time_start = m_sim_time_start;
+    report.sim_time_end = m_sim_time_end;
+
+    // The first grant is where simulated time starts counting, so the wall time before it is left out
+    const double sim_span_s = m_sim_time_end - m_sim_time_start;
+    report.wall_sim_ratio = sim_span_s > 0.0 ? m_granted_wall_ms / 1e3 / sim_span_s : 0.0;
+
+    report.blocked_p50_ms = NanosecondsToMilliseconds(m_blocked.GetPercentile(50.0));
+    report.blocked_p99_ms = NanosecondsToMilliseconds(m_blocked.GetPercentile(99.0));
+    report.blocked_max_ms = NanosecondsToMilliseconds(m_blocked.GetMax());
+    report.compute_p50_ms = NanosecondsToMilliseconds(m_compute.GetPercentile(50.0));
+    report.compute_p99_ms = NanosecondsToMilliseconds(m_compute.GetPercentile(99.0));
+    report.compute_max_ms = NanosecondsToMilliseconds(m_compute.GetMax());
+    report.steps = m_steps;
+
+    return report;
+}
+
+std::string utils::TimeAccountant::GetSummary() const
+{
+    const utils::TimeAccountingReport report = GetReport();
+    const double accounted_ms = report.blocked_ms + report.compute_ms;
+    const double blocked_percent = accounted_ms > 0.0 ? 100.0 * report.blocked_ms / accounted_ms : 0.0;
+
+    std::stringstream ss;
+    ss << "\n##########################################\n"
+       << "Time Accounting (" << report.federate << ")\n"
+       << "Steps: " << report.step_count << "\nWall Time: " << report.wall_ms << " ms"
+       << "\nBlocked in Time Requests: " << report.blocked_ms << " ms (" << blocked_percent << "%)"
+       << "\nComputing Between Grants: " << report.compute_ms << " ms (" << 100.0 - blocked_percent << "%)"
+       << "\nBlocked per Step (p50/p99/max ms): " << report.blocked_p50_ms << "/" << report.blocked_p99_ms << "/"
+       << report.blocked_max_ms << "\nCompute per Step (p50/p99/max ms): " << report.compute_p50_ms << "/"
+       << report.compute_p99_ms << "/" << report.compute_max_ms << "\nWall/Sim Ratio: " << report.wall_sim_ratio
+       << "\n##########################################\n";
+    return ss.str();
+}
+
+bool utils::TimeAccountant::WriteReport(const std::string &output_file) const
+{
+    std::ofstream output_stream(output_file, std::ios::trunc);
+    if (!output_stream.is_open())
+    {
+        return false;
+    }
+
+    output_stream << boost::json::serialize(boost::json::value_from(GetReport())) << "\n";
+    return static_cast<bool>(output_stream);
+}
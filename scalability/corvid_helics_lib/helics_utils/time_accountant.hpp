@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <helics/application_api/Federate.hpp>
+
+#include "latency_histogram.hpp"
+
+namespace utils
+{
+
+/**
+ * One grant: how long the federate was blocked waiting for it and how long it then worked before asking for the
+ * next one. Iterations at the same granted time are separate steps.
+ */
+struct TimeAccountingStep
+{
+    double granted_time{};
+    double blocked_ms{};
+    double compute_ms{};
+};
+
+/**
+ * End of run summary of a TimeAccountant, written per federate and combined across the federation by
+ * combine_time_reports.
+ */
+struct TimeAccountingReport
+{
+    std::string federate{};
+    std::uint64_t step_count{};
+    double wall_ms{};
+    double blocked_ms{};
+    double compute_ms{};
+    double sim_time_start{};
+    double sim_time_end{};
+    // Wall seconds per simulated second, above 1 is slower than real time
+    double wall_sim_ratio{};
+    double blocked_p50_ms{};
+    double blocked_p99_ms{};
+    double blocked_max_ms{};
+    double compute_p50_ms{};
+    double compute_p99_ms{};
+    double compute_max_ms{};
+    std::vector<TimeAccountingStep> steps{};
+};
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const TimeAccountingStep &data);
+TimeAccountingStep tag_invoke(boost::json::value_to_tag<TimeAccountingStep>, const boost::json::value &json_value);
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const TimeAccountingReport &data);
+TimeAccountingReport tag_invoke(boost::json::value_to_tag<TimeAccountingReport>, const boost::json::value &json_value);
+
+/**
+ * Splits a federate's wall time into time blocked in HELICS time requests and time computing between grants. Use
+ * RequestTime in place of the federate's own, or BeginWait / EndWait around a request it cannot wrap, such as a
+ * callback federate returning its next time. Not thread safe, use it from the thread that requests time.
+ */
+class TimeAccountant
+{
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string m_federate{};
+    std::optional<Clock::time_point> m_start_time{};
+    std::optional<Clock::time_point> m_first_grant_time{};
+    Clock::time_point m_wait_start{};
+    Clock::time_point m_grant_time{};
+    bool m_is_waiting{};
+    // The step in progress, its compute time is known once the next wait begins
+    std::optional<TimeAccountingStep> m_current{};
+    bool m_keep_steps{};
+
+    std::vector<TimeAccountingStep> m_steps{};
+    std::uint64_t m_step_count{};
+    double m_blocked_ms{};
+    double m_compute_ms{};
+    double m_sim_time_start{};
+    double m_sim_time_end{};
+    double m_wall_ms{};
+    // Wall time from the first grant on, the span that simulated time advances over
+    double m_granted_wall_ms{};
+    LatencyHistogram m_blocked{};
+    LatencyHistogram m_compute{};
+
+    void CloseStep(Clock::time_point now);
+
+  public:
+    /**
+     * @param keep_steps keeps every step for the report, needed by combine_time_reports to find the critical path.
+     */
+    explicit TimeAccountant(std::string federate, bool keep_steps = true);
+
+    helics::Time RequestTime(helics::Federate &fed, helics::Time next_time);
+    helics::iteration_time RequestTimeIterative(helics::Federate &fed, helics::Time next_time,
+                                                helics::IterationRequest iterate);
+
+    void BeginWait();
+    void EndWait(double granted_time);
+
+    /**
+     * @brief Closes the last step, call once the time loop is done and before reading the report.
+     */
+    void Finish();
+
+    TimeAccountingReport GetReport() const;
+    std::string GetSummary() const;
+    bool WriteReport(const std::string &output_file) const;
+};
+
+} // namespace utils
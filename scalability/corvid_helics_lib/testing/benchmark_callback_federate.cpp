@@ -0,0 +1,239 @@
+#include <helics/application_api/BrokerApp.hpp>
+#include <helics/application_api/CallbackFederate.hpp>
+#include <helics/application_api/ValueFederate.hpp>
+#include <helics/application_api/Publications.hpp>
+#include <helics/application_api/Inputs.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct GrantStats
+{
+    long long grants{};
+    double total_latency_us{};
+    double max_latency_us{};
+
+    void Record(Clock::time_point requested, Clock::time_point granted)
+    {
+        const double latency_us = std::chrono::duration<double, std::micro>(granted - requested).count();
+        grants++;
+        total_latency_us += latency_us;
+        max_latency_us = std::max(max_latency_us, latency_us);
+    }
+};
+
+helics::FederateInfo GetFederateInfo(helics::CoreType core_type)
+{
+    helics::FederateInfo fi(core_type);
+    fi.coreInitString = "--federates=1";
+    fi.setProperty(HELICS_PROPERTY_TIME_PERIOD, 1.0);
+    return fi;
+}
+
+/**
+ * Stand-in for a feeder: publishes a power each step and reads back the voltage.
+ */
+void RunFeeder(helics::CoreType core_type, int steps)
+{
+    helics::ValueFederate feeder("bench_feeder", GetFederateInfo(core_type));
+    helics::Publication &s = feeder.registerGlobalPublication<std::complex<double>>("bench_feeder/S", "VA");
+    helics::Input &v = feeder.registerSubscription("bench_fed/V", "V");
+
+    feeder.enterExecutingMode();
+
+    double granted_time = 0.0;
+    while (granted_time + 1.0 <= steps)
+    {
+        s.publish(std::complex<double>(granted_time, 0.0));
+        granted_time = feeder.requestTime(granted_time + 1.0);
+        v.getValue<std::complex<double>>();
+    }
+
+    feeder.finalize();
+}
+
+/**
+ * The trivial step the measured federate performs at every grant: read, compute, publish.
+ */
+void Step(helics::Input &s, helics::Publication &v)
+{
+    const std::complex<double> power = s.getValue<std::complex<double>>();
+    v.publish(power * 0.5);
+}
+
+GrantStats RunBlocking(helics::CoreType core_type, int steps)
+{
+    GrantStats stats;
+
+    helics::ValueFederate fed("bench_fed", GetFederateInfo(core_type));
+    helics::Input &s = fed.registerSubscription("bench_feeder/S", "VA");
+    helics::Publication &v = fed.registerPublication<std::complex<double>>("V", "V");
+
+    fed.enterExecutingMode();
+
+    double granted_time = 0.0;
+    while (granted_time + 1.0 <= steps)
+    {
+        const Clock::time_point requested = Clock::now();
+        granted_time = fed.requestTime(granted_time + 1.0);
+        stats.Record(requested, Clock::now());
+
+        Step(s, v);
+    }
+
+    fed.finalize();
+
+    return stats;
+}
+
+GrantStats RunCallback(helics::CoreType core_type, int steps)
+{
+    GrantStats stats;
+
+    helics::CallbackFederate fed("bench_fed", GetFederateInfo(core_type));
+    helics::Input &s = fed.registerSubscription("bench_feeder/S", "VA");
+    helics::Publication &v = fed.registerPublication<std::complex<double>>("V", "V");
+
+    std::promise<void> finished;
+    std::future<void> finished_future = finished.get_future();
+    std::atomic<bool> is_finished{ false };
+    const auto fail = [&finished, &is_finished](std::exception_ptr error)
+    {
+        if (!is_finished.exchange(true))
+        {
+            finished.set_exception(error);
+        }
+    };
+    Clock::time_point requested = Clock::now();
+
+    fed.setInitializeCallback([]() { return helics::IterationRequest::NO_ITERATIONS; });
+    fed.setNextTimeCallback(
+        [&](helics::Time time) -> helics::Time
+        {
+            try
+            {
+                const double granted_time = static_cast<double>(time);
+                if (granted_time > 0.0)
+                {
+                    stats.Record(requested, Clock::now());
+                    Step(s, v);
+                }
+
+                if (granted_time + 1.0 > steps)
+                {
+                    if (!is_finished.exchange(true))
+                    {
+                        finished.set_value();
+                    }
+                    return helics::Time::maxVal();
+                }
+
+                requested = Clock::now();
+                return granted_time + 1.0;
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+                return helics::Time::maxVal();
+            }
+        });
+    fed.setErrorHandlerCallback(
+        [&fail](int error_code, std::string_view error_string)
+        {
+            fail(std::make_exception_ptr(
+                std::runtime_error("HELICS error " + std::to_string(error_code) + ": " + std::string(error_string))));
+        });
+    fed.setCosimulationTerminatedCallback(
+        [&fail]() { fail(std::make_exception_ptr(std::runtime_error("co-simulation ended before the last step"))); });
+
+    fed.enterInitializingModeAsync();
+    try
+    {
+        finished_future.get();
+    }
+    catch (...)
+    {
+        fed.finalize();
+        throw;
+    }
+
+    fed.finalize();
+
+    return stats;
+}
+
+void RunBenchmark(const std::string &mode, helics::CoreType core_type, int steps)
+{
+    helics::BrokerApp broker(core_type, "--federates=2");
+
+    std::thread feeder_thread(RunFeeder, core_type, steps);
+
+    const Clock::time_point start = Clock::now();
+    const GrantStats stats = mode == "callback" ? RunCallback(core_type, steps) : RunBlocking(core_type, steps);
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    feeder_thread.join();
+    broker.waitForDisconnect();
+
+    std::cout << "##########################################\n"
+              << "Mode: " << mode << "\n"
+              << "Grants: " << stats.grants << "\n"
+              << "Wall Time: " << wall_ms << " ms\n"
+              << "Throughput: " << (wall_ms > 0.0 ? stats.grants / (wall_ms / 1000.0) : 0.0) << " grants/s\n"
+              << "Mean Grant Latency: " << (stats.grants > 0 ? stats.total_latency_us / stats.grants : 0.0)
+              << " us\n"
+              << "Max Grant Latency: " << stats.max_latency_us << " us\n"
+              << "##########################################\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "Usage: benchmark_callback_federate <blocking|callback|both> [steps] [zmq|inproc]\n"
+                  << "Example:\n"
+                  << "    benchmark_callback_federate both 10000 zmq\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string mode(argv[1]);
+    const int steps = argc > 2 ? std::stoi(argv[2]) : 10000;
+    const helics::CoreType core_type =
+        argc > 3 && std::string(argv[3]) == "inproc" ? helics::CoreType::INPROC : helics::CoreType::ZMQ;
+
+    try
+    {
+        if (mode == "blocking" || mode == "both")
+        {
+            RunBenchmark("blocking", core_type, steps);
+        }
+        if (mode == "callback" || mode == "both")
+        {
+            RunBenchmark("callback", core_type, steps);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
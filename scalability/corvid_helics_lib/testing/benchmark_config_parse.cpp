@@ -0,0 +1,168 @@
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "json_templates.hpp"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Same shape as powerflow::input::PowerflowInput, the bulk of a generated config is the feeder list and the
+ * federation description.
+ */
+struct BenchFeeder
+{
+    int bus_id{};
+    std::vector<std::string> names{};
+};
+
+struct BenchConfig
+{
+    std::string gridpack_name{};
+    std::string fed_info_json{};
+    std::vector<BenchFeeder> gridlabd_infos{};
+    double total_time{};
+};
+
+BenchFeeder tag_invoke(boost::json::value_to_tag<BenchFeeder>, const boost::json::value &json_value)
+{
+    BenchFeeder data;
+    const boost::json::object &obj = json_value.as_object();
+    utils::extract(obj, "bus_id", data.bus_id);
+    utils::extract(obj, "names", data.names);
+    return data;
+}
+
+BenchConfig tag_invoke(boost::json::value_to_tag<BenchConfig>, const boost::json::value &json_value)
+{
+    BenchConfig data;
+    const boost::json::object &obj = json_value.as_object();
+    utils::extract(obj, "gridpack_name", data.gridpack_name);
+    utils::extract_json_string(obj, "fed_info_json", data.fed_info_json);
+    utils::extract(obj, "gridlabd_infos", data.gridlabd_infos);
+    utils::extract(obj, "total_time", data.total_time);
+    return data;
+}
+
+/**
+ * Writes a config of roughly target_bytes, split evenly between feeders and the subscriptions in fed_info_json.
+ */
+std::size_t WriteConfig(const std::string &path, std::size_t target_bytes)
+{
+    boost::json::array feeders;
+    boost::json::array subscriptions;
+    std::size_t approx_bytes = 0;
+    for (int feeder = 0; approx_bytes < target_bytes; feeder++)
+    {
+        const std::string name = "gld_feeder_" + std::to_string(feeder);
+        boost::json::array names;
+        for (const char *phase : { "A", "B", "C" })
+        {
+            const std::string key = name + "/power_" + phase;
+            names.push_back(boost::json::string(key));
+            subscriptions.push_back({ { "key", key }, { "type", "complex" }, { "required", true } });
+        }
+        feeders.push_back({ { "bus_id", feeder % 118 + 1 }, { "names", std::move(names) } });
+        approx_bytes += 3 * (2 * name.size() + 60);
+    }
+
+    boost::json::object config;
+    config["gridpack_name"] = "gpk_118";
+    config["fed_info_json"] = { { "coreType", "zmq" },
+                                { "period", 1.0 },
+                                { "subscriptions", std::move(subscriptions) } };
+    config["gridlabd_infos"] = std::move(feeders);
+    config["total_time"] = 3600.0;
+
+    const std::string text = boost::json::serialize(config);
+    std::ofstream out(path, std::ios::trunc);
+    out << text;
+    return text.size();
+}
+
+/**
+ * The previous FromJsonFile: read into a string, parse into a heap allocated tree, convert.
+ */
+BenchConfig ReadBaseline(const std::string &path)
+{
+    const auto size = std::filesystem::file_size(path);
+    std::string json_content(size, '\0');
+    std::ifstream in(path);
+    in.read(&json_content[0], static_cast<std::streamsize>(size));
+    return boost::json::value_to<BenchConfig>(boost::json::parse(json_content));
+}
+
+template <typename Function> void Measure(const std::string &name, int runs, double megabytes, Function &&function)
+{
+    std::vector<double> times_ms;
+    std::size_t feeders = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        const Clock::time_point start = Clock::now();
+        const BenchConfig config = function();
+        times_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        feeders = config.gridlabd_infos.size();
+    }
+    std::sort(times_ms.begin(), times_ms.end());
+
+    double total_ms = 0.0;
+    for (const double time_ms : times_ms)
+    {
+        total_ms += time_ms;
+    }
+    const double median_ms = times_ms[times_ms.size() / 2];
+    std::cout << name << ": " << feeders << " feeders, min " << times_ms.front() << " ms, median " << median_ms
+              << " ms, mean " << total_ms / runs << " ms, " << megabytes / (median_ms / 1000.0) << " MB/s\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 3)
+    {
+        std::cerr << "Usage: benchmark_config_parse [megabytes] [runs]\n"
+                  << "Example:\n"
+                  << "    benchmark_config_parse 10 20\n";
+        return EXIT_FAILURE;
+    }
+
+    const double megabytes = argc > 1 ? std::stod(argv[1]) : 10.0;
+    const int runs = std::max(argc > 2 ? std::stoi(argv[2]) : 20, 1);
+    const std::string path = (std::filesystem::temp_directory_path() / "benchmark_config_parse.json").string();
+
+    try
+    {
+        const std::size_t written = WriteConfig(path, static_cast<std::size_t>(megabytes * 1024 * 1024));
+        const double written_mb = static_cast<double>(written) / (1024.0 * 1024.0);
+        std::cout << "Config: " << written_mb << " MB, " << runs << " runs each\n";
+
+        // One untimed read each so both start from a warm page cache
+        ReadBaseline(path);
+        utils::FromJsonFile<BenchConfig>(path);
+
+        Measure("string + heap tree", runs, written_mb, [&path]() { return ReadBaseline(path); });
+        Measure("mapped + arena tree", runs, written_mb, [&path]() { return utils::FromJsonFile<BenchConfig>(path); });
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        std::remove(path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::remove(path.c_str());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,329 @@
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "io_context_pool.hpp"
+#include "shm_ring.hpp"
+#include "websocket_client.hpp"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+std::int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Every payload starts with the steady_clock time it was sent, both transports deliver within the process so the
+ * receiver can subtract it from its own clock.
+ */
+std::shared_ptr<std::string> MakePayload(std::size_t message_bytes)
+{
+    auto payload = std::make_shared<std::string>(std::max(message_bytes, sizeof(std::int64_t)), 'x');
+    const std::int64_t now = NowNs();
+    std::memcpy(payload->data(), &now, sizeof(now));
+    return payload;
+}
+
+class LatencyRecorder
+{
+  private:
+    std::mutex m_mutex;
+    std::vector<double> m_latencies_us;
+
+  public:
+    void Record(const char *data, std::size_t size)
+    {
+        if (size < sizeof(std::int64_t)) return;
+
+        std::int64_t sent = 0;
+        std::memcpy(&sent, data, sizeof(sent));
+        const double latency_us = static_cast<double>(NowNs() - sent) / 1000.0;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_latencies_us.push_back(latency_us);
+    }
+
+    std::size_t GetCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_latencies_us.size();
+    }
+
+    void Print(const std::string &transport, std::size_t sent, std::size_t dropped, double wall_ms)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<double> sorted = m_latencies_us;
+        std::sort(sorted.begin(), sorted.end());
+
+        double mean = 0.0;
+        for (double latency : sorted)
+        {
+            mean += latency;
+        }
+        mean = sorted.empty() ? 0.0 : mean / sorted.size();
+        const double p99 = sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+        const double seconds = wall_ms / 1000.0;
+
+        std::cout << transport << "," << sent << "," << sorted.size() << "," << dropped << "," << wall_ms << ","
+                  << (seconds > 0.0 ? sorted.size() / seconds : 0.0) << "," << mean << "," << p99 << "\n";
+    }
+};
+
+/**
+ * Spaces sends evenly at the requested rate, a federate publishes telemetry as it steps rather than in one burst. A
+ * rate of zero sends as fast as possible.
+ */
+class Pacer
+{
+  private:
+    Clock::time_point m_start{ Clock::now() };
+    double m_interval_ns{};
+
+  public:
+    explicit Pacer(std::size_t messages_per_second)
+        : m_interval_ns(messages_per_second > 0 ? 1e9 / messages_per_second : 0.0)
+    {
+    }
+
+    void Wait(std::size_t message)
+    {
+        std::this_thread::sleep_until(m_start +
+                                      std::chrono::nanoseconds(static_cast<std::int64_t>(message * m_interval_ns)));
+    }
+};
+
+bool WaitFor(const std::function<bool()> &done, std::chrono::seconds timeout)
+{
+    const Clock::time_point deadline = Clock::now() + timeout;
+    while (!done())
+    {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+// ###################################
+// Shared memory
+// ###################################
+
+void RunShmBenchmark(std::size_t messages, std::size_t message_bytes, std::size_t rate, std::size_t ring_bytes)
+{
+    const std::string name = "corvid_benchmark_" + std::to_string(::getpid());
+
+    std::error_code ec;
+    std::unique_ptr<utils::ShmRingWriter> writer = utils::ShmRingWriter::Create(name, ring_bytes, ec);
+    if (!writer)
+    {
+        std::cerr << "Could not create ring " << name << ": " << ec.message() << "\n";
+        return;
+    }
+
+    utils::ShmCollector collector;
+    if (!collector.AddRing(name, ec))
+    {
+        std::cerr << "Could not open ring " << name << ": " << ec.message() << "\n";
+        return;
+    }
+
+    LatencyRecorder recorder;
+    std::atomic<bool> is_sending{ true };
+    std::thread collector_thread(
+        [&]()
+        {
+            const auto handler = [&recorder](const std::string &, const char *data, std::size_t size, bool)
+            { recorder.Record(data, size); };
+            while (true)
+            {
+                // Read the flag first, an empty poll after the last send means everything was drained
+                const bool was_sending = is_sending;
+                if (collector.Poll(handler, 256) > 0) continue;
+                if (!was_sending) break;
+
+                // Nothing pending, give the core back like a real collector would
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+
+    const Clock::time_point start = Clock::now();
+    Pacer pacer(rate);
+    for (std::size_t m = 0; m < messages; m++)
+    {
+        pacer.Wait(m);
+        writer->SendBinary(MakePayload(message_bytes));
+    }
+    is_sending = false;
+    collector_thread.join();
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    recorder.Print("shm", messages, writer->GetDroppedMessages(), wall_ms);
+}
+
+// ###################################
+// WebSocket
+// ###################################
+
+class SinkSession : public std::enable_shared_from_this<SinkSession>
+{
+  private:
+    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> m_ws;
+    boost::beast::flat_buffer m_buffer;
+    LatencyRecorder &m_recorder;
+
+    void DoRead()
+    {
+        m_ws.async_read(m_buffer,
+                        [self = shared_from_this()](const boost::system::error_code &ec, std::size_t)
+                        {
+                            if (ec) return;
+
+                            const auto data = self->m_buffer.data();
+                            self->m_recorder.Record(static_cast<const char *>(data.data()), data.size());
+                            self->m_buffer.consume(self->m_buffer.size());
+                            self->DoRead();
+                        });
+    }
+
+  public:
+    SinkSession(boost::asio::ip::tcp::socket socket, LatencyRecorder &recorder)
+        : m_ws(std::move(socket)), m_recorder(recorder)
+    {
+    }
+
+    void Start()
+    {
+        m_ws.async_accept(
+            [self = shared_from_this()](const boost::system::error_code &ec)
+            {
+                if (!ec) self->DoRead();
+            });
+    }
+};
+
+class SinkServer
+{
+  private:
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    LatencyRecorder &m_recorder;
+
+    void DoAccept()
+    {
+        m_acceptor.async_accept(
+            boost::asio::make_strand(m_acceptor.get_executor()),
+            [this](const boost::system::error_code &ec, boost::asio::ip::tcp::socket socket)
+            {
+                if (ec) return;
+
+                std::make_shared<SinkSession>(std::move(socket), m_recorder)->Start();
+                DoAccept();
+            });
+    }
+
+  public:
+    SinkServer(boost::asio::io_context &ioc, LatencyRecorder &recorder)
+        : m_acceptor(ioc, { boost::asio::ip::make_address("127.0.0.1"), 0 }), m_recorder(recorder)
+    {
+        DoAccept();
+    }
+
+    unsigned short GetPort() const { return m_acceptor.local_endpoint().port(); }
+};
+
+void RunWebSocketBenchmark(std::size_t messages, std::size_t message_bytes, std::size_t rate)
+{
+    LatencyRecorder recorder;
+    utils::IoContextPool server_pool(1);
+    SinkServer server(server_pool.GetContext(), recorder);
+    server_pool.Start();
+
+    // Same limits as the ring, a federate should never block on telemetry
+    utils::SendOptions options;
+    options.max_queued_messages = messages;
+    options.overflow_policy = utils::OverflowPolicy::DROP_OLDEST;
+
+    auto client = std::make_shared<utils::WebSocketClient>(options);
+    std::atomic<bool> is_connected{};
+    client->Connect("127.0.0.1", std::to_string(server.GetPort()), "/",
+                    [&is_connected](const boost::system::error_code &ec) { is_connected = !ec; });
+    client->AsyncRun();
+
+    if (!WaitFor([&]() { return is_connected.load(); }, std::chrono::seconds(10)))
+    {
+        std::cerr << "WebSocket client did not connect.\n";
+        client->StopRun();
+        server_pool.Stop();
+        return;
+    }
+
+    const Clock::time_point start = Clock::now();
+    Pacer pacer(rate);
+    for (std::size_t m = 0; m < messages; m++)
+    {
+        pacer.Wait(m);
+        client->SendBinary(MakePayload(message_bytes));
+    }
+
+    WaitFor([&]() { return recorder.GetCount() + client->GetSendStats().dropped_messages >= messages; },
+            std::chrono::seconds(120));
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    recorder.Print("websocket", messages, client->GetSendStats().dropped_messages, wall_ms);
+
+    client->CloseConnection();
+    client->StopRun();
+    server_pool.Stop();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 5)
+    {
+        std::cerr << "Usage: benchmark_shm_telemetry [messages] [message_bytes] [messages_per_second] [ring_bytes]\n"
+                  << "Example:\n"
+                  << "    benchmark_shm_telemetry 200000 256 100000 4194304\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t messages = argc > 1 ? std::stoul(argv[1]) : 200000;
+    const std::size_t message_bytes = argc > 2 ? std::stoul(argv[2]) : 256;
+    const std::size_t rate = argc > 3 ? std::stoul(argv[3]) : 100000;
+    const std::size_t ring_bytes = argc > 4 ? std::stoul(argv[4]) : 4 * 1024 * 1024;
+
+    try
+    {
+        std::cout << "Transport,Sent,Received,Dropped,Wall Time (ms),Messages/s,Mean Latency (us),P99 Latency (us)\n";
+        RunShmBenchmark(messages, message_bytes, rate, ring_bytes);
+        RunWebSocketBenchmark(messages, message_bytes, rate);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
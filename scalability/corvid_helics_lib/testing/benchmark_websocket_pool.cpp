@@ -0,0 +1,211 @@
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io_context_pool.hpp"
+#include "websocket_client.hpp"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Server side of a connection, reads and counts everything the client sends.
+ */
+class SinkSession : public std::enable_shared_from_this<SinkSession>
+{
+  private:
+    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> m_ws;
+    boost::beast::flat_buffer m_buffer;
+    std::atomic<std::uint64_t> &m_received;
+
+    void DoRead()
+    {
+        m_ws.async_read(m_buffer,
+                        [self = shared_from_this()](const boost::system::error_code &ec, std::size_t)
+                        {
+                            if (ec) return;
+
+                            self->m_received++;
+                            self->m_buffer.consume(self->m_buffer.size());
+                            self->DoRead();
+                        });
+    }
+
+  public:
+    SinkSession(boost::asio::ip::tcp::socket socket, std::atomic<std::uint64_t> &received)
+        : m_ws(std::move(socket)), m_received(received)
+    {
+    }
+
+    void Start()
+    {
+        m_ws.async_accept(
+            [self = shared_from_this()](const boost::system::error_code &ec)
+            {
+                if (!ec) self->DoRead();
+            });
+    }
+};
+
+class SinkServer
+{
+  private:
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    std::atomic<std::uint64_t> m_received{};
+
+    void DoAccept()
+    {
+        m_acceptor.async_accept(
+            boost::asio::make_strand(m_acceptor.get_executor()),
+            [this](const boost::system::error_code &ec, boost::asio::ip::tcp::socket socket)
+            {
+                if (ec) return;
+
+                std::make_shared<SinkSession>(std::move(socket), m_received)->Start();
+                DoAccept();
+            });
+    }
+
+  public:
+    explicit SinkServer(boost::asio::io_context &ioc)
+        : m_acceptor(ioc, { boost::asio::ip::make_address("127.0.0.1"), 0 })
+    {
+        DoAccept();
+    }
+
+    unsigned short GetPort() const { return m_acceptor.local_endpoint().port(); }
+};
+
+bool WaitFor(const std::function<bool()> &done, std::chrono::seconds timeout)
+{
+    const Clock::time_point deadline = Clock::now() + timeout;
+    while (!done())
+    {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+void RunBenchmark(unsigned short port, std::size_t threads, std::size_t connections, std::size_t messages,
+                  std::size_t message_bytes)
+{
+    utils::IoContextPool pool(threads);
+    pool.Start();
+
+    std::atomic<std::size_t> connected{};
+    std::vector<std::shared_ptr<utils::WebSocketClient>> clients;
+    for (std::size_t i = 0; i < connections; i++)
+    {
+        auto client = std::make_shared<utils::WebSocketClient>(pool.GetContext());
+        client->SetOnError([](const boost::system::error_code &ec, const std::string &what)
+                           { std::cerr << what << ": " << ec.message() << std::endl; });
+        client->Connect("127.0.0.1", std::to_string(port), "/",
+                        [&connected](const boost::system::error_code &ec)
+                        {
+                            if (!ec) connected++;
+                        });
+        clients.push_back(client);
+    }
+
+    if (!WaitFor([&]() { return connected == connections; }, std::chrono::seconds(10)))
+    {
+        std::cerr << "Only " << connected << " of " << connections << " clients connected.\n";
+        pool.Stop();
+        return;
+    }
+
+    // Every message shares one buffer, Send queues the pointer
+    const auto payload = std::make_shared<const std::string>(message_bytes, 'x');
+    const std::uint64_t expected = static_cast<std::uint64_t>(connections) * messages;
+
+    const Clock::time_point start = Clock::now();
+    for (std::size_t m = 0; m < messages; m++)
+    {
+        for (const std::shared_ptr<utils::WebSocketClient> &client : clients)
+        {
+            client->Send(payload);
+        }
+    }
+
+    const auto sent = [&]()
+    {
+        std::uint64_t total = 0;
+        for (const std::shared_ptr<utils::WebSocketClient> &client : clients)
+        {
+            total += client->GetSendStats().sent_messages;
+        }
+        return total;
+    };
+    const bool is_complete = WaitFor([&]() { return sent() >= expected; }, std::chrono::seconds(120));
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    const double seconds = wall_ms / 1000.0;
+    const double megabytes = static_cast<double>(sent()) * message_bytes / (1024.0 * 1024.0);
+    std::cout << threads << "," << connections << "," << sent() << "," << wall_ms << ","
+              << (seconds > 0.0 ? sent() / seconds : 0.0) << "," << (seconds > 0.0 ? megabytes / seconds : 0.0)
+              << (is_complete ? "" : ",timed out") << "\n";
+
+    for (const std::shared_ptr<utils::WebSocketClient> &client : clients)
+    {
+        client->CloseConnection();
+    }
+    pool.Stop();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 5)
+    {
+        std::cerr << "Usage: benchmark_websocket_pool [connections] [messages] [message_bytes] [max_threads]\n"
+                  << "Example:\n"
+                  << "    benchmark_websocket_pool 16 20000 256 8\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t connections = argc > 1 ? std::stoul(argv[1]) : 16;
+    const std::size_t messages = argc > 2 ? std::stoul(argv[2]) : 20000;
+    const std::size_t message_bytes = argc > 3 ? std::stoul(argv[3]) : 256;
+    const std::size_t max_threads =
+        argc > 4 ? std::stoul(argv[4]) : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+    try
+    {
+        // The sink gets its own threads so it is never the one being measured
+        utils::IoContextPool server_pool(std::max<std::size_t>(max_threads, 2));
+        SinkServer server(server_pool.GetContext());
+        server_pool.Start();
+
+        std::cout << "Threads,Connections,Messages,Wall Time (ms),Messages/s,MB/s\n";
+        for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+        {
+            RunBenchmark(server.GetPort(), threads, connections, messages, message_bytes);
+        }
+
+        server_pool.Stop();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "binary_log.hpp"
+
+namespace
+{
+
+class BinaryLogTest : public ::testing::Test
+{
+  protected:
+    std::filesystem::path m_path{};
+
+    void SetUp() override
+    {
+        const std::string test_name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        m_path = std::filesystem::temp_directory_path() / ("corvid_binary_log_" + test_name + ".bin");
+    }
+
+    void TearDown() override
+    {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+
+    bool Decode(std::vector<std::string> &texts, std::string &error) const
+    {
+        return utils::DecodeBinaryLog(
+            m_path.string(), [&texts](const utils::DecodedBinaryLogStatement &statement)
+            { texts.push_back(statement.text); },
+            error);
+    }
+
+    std::string ReadBytes() const
+    {
+        std::ifstream in(m_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteBytes(const std::string &bytes) const
+    {
+        std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+};
+
+// header: u32 magic | u16 version | u16 reserved | i64 open time
+constexpr std::size_t HEADER_BYTES = 16;
+
+} // namespace
+
+TEST_F(BinaryLogTest, RoundTripsEveryArgumentType)
+{
+    {
+        utils::BinaryLogWriter writer(m_path.string());
+        ASSERT_TRUE(writer.IsOpen());
+        for (int i = 0; i < 3; i++)
+        {
+            CORVID_BINARY_LOG(writer, "Bus Id: {} Power: {} Phase: {} Solved: {} Name: {}", i, 1.5, 'A', true,
+                              std::string("feeder"));
+        }
+        CORVID_BINARY_LOG(writer, "Count: {}\n", std::uint64_t{ 42 }, -7);
+        EXPECT_EQ(writer.GetStatementCount(), 4U);
+    }
+
+    std::vector<std::string> texts;
+    std::string error;
+    ASSERT_TRUE(Decode(texts, error)) << error;
+    ASSERT_EQ(texts.size(), 4U);
+    EXPECT_EQ(texts[0], "Bus Id: 0 Power: 1.5 Phase: A Solved: true Name: feeder");
+    EXPECT_EQ(texts[2], "Bus Id: 2 Power: 1.5 Phase: A Solved: true Name: feeder");
+    // Arguments without a placeholder go on the end of the line, before the newline
+    EXPECT_EQ(texts[3], "Count: 42 -7\n");
+}
+
+TEST_F(BinaryLogTest, TruncatedLogKeepsEarlierStatements)
+{
+    {
+        utils::BinaryLogWriter writer(m_path.string());
+        CORVID_BINARY_LOG(writer, "first {}", 1);
+        CORVID_BINARY_LOG(writer, "second {}", std::string("cut off"));
+    }
+    std::filesystem::resize_file(m_path, std::filesystem::file_size(m_path) - 3);
+
+    std::vector<std::string> texts;
+    std::string error;
+    EXPECT_FALSE(Decode(texts, error));
+    EXPECT_FALSE(error.empty());
+    ASSERT_EQ(texts.size(), 1U);
+    EXPECT_EQ(texts[0], "first 1");
+}
+
+TEST_F(BinaryLogTest, RejectsStringLengthPastEndOfFile)
+{
+    {
+        utils::BinaryLogWriter writer(m_path.string());
+        CORVID_BINARY_LOG(writer, "{}", std::string("payload"));
+    }
+
+    // The last string in the file is the argument, its u32 length sits right before it
+    std::string bytes = ReadBytes();
+    const std::size_t argument = bytes.rfind("payload");
+    ASSERT_NE(argument, std::string::npos);
+    const std::uint32_t huge_length = 0x7FFFFFFF;
+    std::memcpy(bytes.data() + argument - sizeof(huge_length), &huge_length, sizeof(huge_length));
+    WriteBytes(bytes);
+
+    std::vector<std::string> texts;
+    std::string error;
+    EXPECT_FALSE(Decode(texts, error));
+    EXPECT_TRUE(texts.empty());
+}
+
+TEST_F(BinaryLogTest, RejectsFormatIdOutOfRange)
+{
+    {
+        utils::BinaryLogWriter writer(m_path.string());
+    }
+
+    std::string bytes = ReadBytes();
+    ASSERT_EQ(bytes.size(), HEADER_BYTES);
+    const std::uint8_t statement_record = 2;
+    const std::uint32_t id = 0xFFFFFFFF;
+    bytes.append(reinterpret_cast<const char *>(&statement_record), sizeof(statement_record));
+    bytes.append(reinterpret_cast<const char *>(&id), sizeof(id));
+    WriteBytes(bytes);
+
+    std::vector<std::string> texts;
+    std::string error;
+    EXPECT_FALSE(Decode(texts, error));
+    EXPECT_NE(error.find("out of range"), std::string::npos) << error;
+}
+
+TEST_F(BinaryLogTest, RejectsFileWithoutHeader)
+{
+    WriteBytes("not a binary log");
+
+    std::vector<std::string> texts;
+    std::string error;
+    EXPECT_FALSE(Decode(texts, error));
+    EXPECT_TRUE(texts.empty());
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "shm_ring.hpp"
+
+namespace
+{
+
+// Same layout as shm_ring.cpp, the record area starts on the cache line after the header
+constexpr std::size_t RECORD_OFFSET = (sizeof(utils::ShmRingHeader) + 63) & ~std::size_t{ 63 };
+constexpr std::size_t CAPACITY = 4096;
+
+struct DrainedRecord
+{
+    std::string data{};
+    std::uint32_t flags{};
+};
+
+class ShmRingTest : public ::testing::Test
+{
+  protected:
+    std::string m_name{};
+
+    void SetUp() override
+    {
+        const std::string test_name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        m_name = "/corvid_test_" + std::to_string(getpid()) + "_" + test_name;
+    }
+
+    void TearDown() override { shm_unlink(m_name.c_str()); }
+
+    std::unique_ptr<utils::ShmRingWriter> CreateWriter()
+    {
+        std::error_code ec;
+        std::unique_ptr<utils::ShmRingWriter> writer = utils::ShmRingWriter::Create(m_name, CAPACITY, ec);
+        EXPECT_TRUE(writer) << ec.message();
+        return writer;
+    }
+
+    std::unique_ptr<utils::ShmRingReader> OpenReader()
+    {
+        std::error_code ec;
+        std::unique_ptr<utils::ShmRingReader> reader = utils::ShmRingReader::Open(m_name, ec);
+        EXPECT_TRUE(reader) << ec.message();
+        return reader;
+    }
+
+    /**
+     * Overwrites the payload length of the record at offset, as a misbehaving writer process would.
+     */
+    void CorruptLength(std::size_t offset, std::uint32_t length)
+    {
+        const int fd = shm_open(m_name.c_str(), O_RDWR, 0);
+        ASSERT_GE(fd, 0);
+        void *mapping = mmap(nullptr, RECORD_OFFSET + CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        ASSERT_NE(mapping, MAP_FAILED);
+        std::memcpy(static_cast<char *>(mapping) + RECORD_OFFSET + offset, &length, sizeof(length));
+        munmap(mapping, RECORD_OFFSET + CAPACITY);
+    }
+};
+
+std::vector<DrainedRecord> DrainAll(utils::ShmRingReader &reader)
+{
+    std::vector<DrainedRecord> records;
+    reader.Drain([&records](const char *data, std::size_t size, std::uint32_t flags)
+                 { records.push_back({ std::string(data, size), flags }); },
+                 SIZE_MAX);
+    return records;
+}
+
+} // namespace
+
+TEST_F(ShmRingTest, RoundTripsMessagesAndFlags)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    std::unique_ptr<utils::ShmRingReader> reader = OpenReader();
+    ASSERT_TRUE(writer && reader);
+
+    EXPECT_TRUE(writer->Send("text"));
+    EXPECT_TRUE(writer->SendBinary(std::string("\0binary\xff", 8), utils::SendPriority::HIGH));
+    EXPECT_TRUE(writer->Send(std::make_shared<const std::string>("")));
+    EXPECT_EQ(writer->GetSentMessages(), 3U);
+
+    const std::vector<DrainedRecord> records = DrainAll(*reader);
+    ASSERT_EQ(records.size(), 3U);
+    EXPECT_EQ(records[0].data, "text");
+    EXPECT_EQ(records[0].flags, 0U);
+    EXPECT_EQ(records[1].data, std::string("\0binary\xff", 8));
+    EXPECT_EQ(records[1].flags, utils::ShmRingHeader::FLAG_BINARY | utils::ShmRingHeader::FLAG_HIGH_PRIORITY);
+    EXPECT_EQ(records[2].data, "");
+    EXPECT_FALSE(reader->IsFinished());
+
+    writer.reset();
+    EXPECT_TRUE(reader->IsFinished());
+}
+
+TEST_F(ShmRingTest, WrapsAroundInOrder)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    std::unique_ptr<utils::ShmRingReader> reader = OpenReader();
+    ASSERT_TRUE(writer && reader);
+
+    // 300 byte messages do not divide the ring, so some land after a pad record
+    int next_expected = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        std::string message = std::to_string(i);
+        message.resize(300, '.');
+        ASSERT_TRUE(writer->Send(message));
+
+        if (i % 5 == 4)
+        {
+            for (const DrainedRecord &record : DrainAll(*reader))
+            {
+                EXPECT_EQ(std::stoi(record.data), next_expected++);
+                EXPECT_EQ(record.data.size(), 300U);
+            }
+        }
+    }
+    EXPECT_EQ(next_expected, 100);
+    EXPECT_EQ(writer->GetDroppedMessages(), 0U);
+}
+
+TEST_F(ShmRingTest, DropsMessagesThatDoNotFit)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    std::unique_ptr<utils::ShmRingReader> reader = OpenReader();
+    ASSERT_TRUE(writer && reader);
+
+    EXPECT_FALSE(writer->Send(std::string(CAPACITY / 2, 'x')));
+
+    const std::string message(1000, 'y');
+    int sent = 0;
+    while (writer->Send(message))
+    {
+        sent++;
+    }
+    EXPECT_GT(sent, 0);
+    EXPECT_EQ(writer->GetDroppedMessages(), 2U);
+    EXPECT_EQ(reader->GetDroppedMessages(), 2U);
+    EXPECT_EQ(DrainAll(*reader).size(), static_cast<std::size_t>(sent));
+}
+
+TEST_F(ShmRingTest, StopsAtLengthPastWrittenBytes)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    std::unique_ptr<utils::ShmRingReader> reader = OpenReader();
+    ASSERT_TRUE(writer && reader);
+
+    ASSERT_TRUE(writer->Send("first"));
+    ASSERT_TRUE(writer->Send("second"));
+    // The second record starts after the 8 byte header and the padded "first"
+    CorruptLength(16, 1000);
+
+    const std::vector<DrainedRecord> records = DrainAll(*reader);
+    ASSERT_EQ(records.size(), 1U);
+    EXPECT_EQ(records[0].data, "first");
+    EXPECT_TRUE(reader->IsFinished());
+
+    ASSERT_TRUE(writer->Send("third"));
+    EXPECT_TRUE(DrainAll(*reader).empty());
+}
+
+TEST_F(ShmRingTest, StopsAtLengthPastEndOfRing)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    std::unique_ptr<utils::ShmRingReader> reader = OpenReader();
+    ASSERT_TRUE(writer && reader);
+
+    ASSERT_TRUE(writer->Send("first"));
+    CorruptLength(0, 0xFFFFFFF0);
+
+    EXPECT_TRUE(DrainAll(*reader).empty());
+    EXPECT_TRUE(reader->IsFinished());
+}
+
+TEST_F(ShmRingTest, DoesNotTakeOverAnExistingName)
+{
+    std::unique_ptr<utils::ShmRingWriter> writer = CreateWriter();
+    ASSERT_TRUE(writer);
+
+    std::error_code ec;
+    EXPECT_FALSE(utils::ShmRingWriter::Create(m_name, CAPACITY, ec));
+    EXPECT_EQ(ec, std::errc::file_exists);
+}
+
+TEST_F(ShmRingTest, RejectsMissingRing)
+{
+    std::error_code ec;
+    EXPECT_FALSE(utils::ShmRingReader::Open(m_name, ec));
+    EXPECT_TRUE(ec);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "telemetry_frame.hpp"
+
+namespace
+{
+
+const std::string SOURCE = "fed";
+// u32 magic | u16 version | u16 schema id | u16 schema version | u16 source length | source | u32 record count
+const std::size_t FIRST_RECORD_OFFSET = 16 + SOURCE.size();
+
+std::string MakeFrame()
+{
+    utils::TelemetryFrameWriter writer(SOURCE, 7, 2);
+    writer.AddSample("voltage", 1.5, 0.98);
+    writer.AddCounter("messages", 2.0, 123456789012ULL);
+    writer.AddEvent("state", 3.25, "converged");
+    return writer.Finish();
+}
+
+void PatchU32(std::string &frame, std::size_t offset, std::uint32_t value)
+{
+    for (std::size_t i = 0; i < sizeof(value); i++)
+    {
+        frame[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+} // namespace
+
+TEST(TelemetryFrameTest, RoundTripsEveryRecordType)
+{
+    const std::string encoded = MakeFrame();
+    ASSERT_TRUE(utils::IsTelemetryFrame(encoded.data(), encoded.size()));
+
+    const std::optional<utils::TelemetryFrame> frame = utils::DecodeTelemetryFrame(encoded.data(), encoded.size());
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_EQ(frame->schema_id, 7);
+    EXPECT_EQ(frame->schema_version, 2);
+    EXPECT_EQ(frame->source, SOURCE);
+    ASSERT_EQ(frame->records.size(), 3U);
+
+    EXPECT_EQ(frame->records[0].type, utils::TelemetryRecordType::SAMPLE);
+    EXPECT_EQ(frame->records[0].name, "voltage");
+    EXPECT_DOUBLE_EQ(frame->records[0].time, 1.5);
+    EXPECT_DOUBLE_EQ(frame->records[0].value, 0.98);
+
+    EXPECT_EQ(frame->records[1].type, utils::TelemetryRecordType::COUNTER);
+    EXPECT_EQ(frame->records[1].count, 123456789012ULL);
+
+    EXPECT_EQ(frame->records[2].type, utils::TelemetryRecordType::EVENT);
+    EXPECT_DOUBLE_EQ(frame->records[2].time, 3.25);
+    EXPECT_EQ(frame->records[2].text, "converged");
+}
+
+TEST(TelemetryFrameTest, FinishStartsAnEmptyFrame)
+{
+    utils::TelemetryFrameWriter writer(SOURCE, 1, 1);
+    writer.AddSample("a", 0.0, 1.0);
+    writer.Finish();
+    EXPECT_EQ(writer.GetRecordCount(), 0U);
+
+    const std::string encoded = writer.Finish();
+    const std::optional<utils::TelemetryFrame> frame = utils::DecodeTelemetryFrame(encoded.data(), encoded.size());
+    ASSERT_TRUE(frame.has_value());
+    EXPECT_TRUE(frame->records.empty());
+}
+
+TEST(TelemetryFrameTest, RejectsEveryTruncation)
+{
+    const std::string encoded = MakeFrame();
+    for (std::size_t size = 0; size < encoded.size(); size++)
+    {
+        EXPECT_FALSE(utils::DecodeTelemetryFrame(encoded.data(), size).has_value()) << "size " << size;
+    }
+}
+
+TEST(TelemetryFrameTest, RejectsRecordLengthPastEndOfFrame)
+{
+    std::string encoded = MakeFrame();
+    PatchU32(encoded, FIRST_RECORD_OFFSET, 0xFFFFFFFF);
+    EXPECT_FALSE(utils::DecodeTelemetryFrame(encoded.data(), encoded.size()).has_value());
+}
+
+TEST(TelemetryFrameTest, RejectsRecordLengthShorterThanItsFields)
+{
+    std::string encoded = MakeFrame();
+    PatchU32(encoded, FIRST_RECORD_OFFSET, 4);
+    EXPECT_FALSE(utils::DecodeTelemetryFrame(encoded.data(), encoded.size()).has_value());
+}
+
+TEST(TelemetryFrameTest, RejectsRecordCountPastEndOfFrame)
+{
+    std::string encoded = MakeFrame();
+    PatchU32(encoded, FIRST_RECORD_OFFSET - sizeof(std::uint32_t), 4);
+    EXPECT_FALSE(utils::DecodeTelemetryFrame(encoded.data(), encoded.size()).has_value());
+}
+
+TEST(TelemetryFrameTest, SkipsUnknownRecordTypes)
+{
+    std::string encoded = MakeFrame();
+    encoded[FIRST_RECORD_OFFSET + sizeof(std::uint32_t)] = static_cast<char>(200);
+
+    const std::optional<utils::TelemetryFrame> frame = utils::DecodeTelemetryFrame(encoded.data(), encoded.size());
+    ASSERT_TRUE(frame.has_value());
+    ASSERT_EQ(frame->records.size(), 2U);
+    EXPECT_EQ(frame->records[0].name, "messages");
+    EXPECT_EQ(frame->records[1].name, "state");
+}
+
+TEST(TelemetryFrameTest, RejectsOtherMessages)
+{
+    const std::string text = "{\"type\": \"json\"}";
+    EXPECT_FALSE(utils::IsTelemetryFrame(text.data(), text.size()));
+    EXPECT_FALSE(utils::DecodeTelemetryFrame(text.data(), text.size()).has_value());
+}
@@ -3,12 +3,49 @@
 #include <boost/beast/websocket.hpp>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 
+#include "telemetry_frame.hpp"
+
+namespace
+{
+
+void PrintTelemetryFrame(const utils::TelemetryFrame &frame)
+{
+    std::cout << "[Telemetry] source=" << frame.source << " schema=" << frame.schema_id << "."
+              << frame.schema_version << " records=" << frame.records.size() << "\n";
+
+    for (const utils::TelemetryRecord &record : frame.records)
+    {
+        std::cout << "    t=" << record.time << " " << record.name << " = ";
+        switch (record.type)
+        {
+        case utils::TelemetryRecordType::SAMPLE:
+            std::cout << record.value;
+            break;
+        case utils::TelemetryRecordType::COUNTER:
+            std::cout << record.count;
+            break;
+        case utils::TelemetryRecordType::EVENT:
+            std::cout << "\"" << record.text << "\"";
+            break;
+        }
+        std::cout << "\n";
+    }
+}
+
+} // namespace
+
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>
 {
   public:
-    explicit WebSocketSession(boost::asio::ip::tcp::socket socket) : m_ws(std::move(socket)) {}
+    WebSocketSession(boost::asio::ip::tcp::socket socket,
+                     const std::optional<boost::beast::websocket::permessage_deflate> &deflate)
+        : m_ws(std::move(socket))
+    {
+        if (deflate) m_ws.set_option(deflate.value());
+    }
 
     void start()
     {
@@ -45,7 +82,22 @@ class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>
         }
 
         std::string msg = boost::beast::buffers_to_string(m_buffer.data());
-        std::cout << "[Received] " << msg << "\n";
+        if (m_ws.got_binary())
+        {
+            const std::optional<utils::TelemetryFrame> frame = utils::DecodeTelemetryFrame(msg.data(), msg.size());
+            if (frame)
+            {
+                PrintTelemetryFrame(frame.value());
+            }
+            else
+            {
+                std::cout << "[Received] " << msg.size() << " bytes of unrecognized binary data\n";
+            }
+        }
+        else
+        {
+            std::cout << "[Received] " << msg << "\n";
+        }
 
         m_buffer.consume(m_buffer.size());
         doRead();
@@ -55,8 +107,9 @@ class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>
 class WebSocketServer
 {
   public:
-    WebSocketServer(boost::asio::io_context &ioc, const boost::asio::ip::tcp::endpoint &endpoint)
-        : m_ioc(ioc), m_acceptor(ioc), m_socket(ioc)
+    WebSocketServer(boost::asio::io_context &ioc, const boost::asio::ip::tcp::endpoint &endpoint,
+                    const std::optional<boost::beast::websocket::permessage_deflate> &deflate)
+        : m_ioc(ioc), m_acceptor(ioc), m_socket(ioc), m_deflate(deflate)
     {
         m_acceptor.open(endpoint.protocol());
         m_acceptor.set_option(boost::asio::socket_base::reuse_address(true));
@@ -73,13 +126,14 @@ class WebSocketServer
     boost::asio::io_context &m_ioc;
     boost::asio::ip::tcp::acceptor m_acceptor;
     boost::asio::ip::tcp::socket m_socket;
+    std::optional<boost::beast::websocket::permessage_deflate> m_deflate;
 
     void onAccept(const boost::system::error_code &ec)
     {
         if (!ec)
         {
             std::cout << "Client connected\n";
-            std::make_shared<WebSocketSession>(std::move(m_socket))->start();
+            std::make_shared<WebSocketSession>(std::move(m_socket), m_deflate)->start();
         }
         else
         {
@@ -94,9 +148,10 @@ int main(int argc, char *argv[])
 {
     try
     {
-        if (argc != 4)
+        if (argc < 4 || argc > 6)
         {
-            std::cout << "Usage: testing-server <host> <port> <path>\n";
+            std::cout << "Usage: testing-server <host> <port> <path> [deflate_level] [server_max_window_bits]\n"
+                      << "    deflate_level enables permessage-deflate at zlib level 0-9, omit it to disable.\n";
             return 1;
         }
 
@@ -104,11 +159,25 @@ int main(int argc, char *argv[])
         unsigned short port = static_cast<unsigned short>(std::stoi(argv[2]));
         std::string path(argv[3]); // Currently unused
 
+        std::optional<boost::beast::websocket::permessage_deflate> deflate{};
+        if (argc >= 5)
+        {
+            deflate.emplace();
+            deflate->server_enable = true;
+            deflate->compLevel = std::stoi(argv[4]);
+            if (argc >= 6) deflate->server_max_window_bits = std::stoi(argv[5]);
+        }
+
         boost::asio::io_context ioc;
 
-        WebSocketServer server(ioc, { boost::asio::ip::make_address(host), port });
+        WebSocketServer server(ioc, { boost::asio::ip::make_address(host), port }, deflate);
 
         std::cout << "Starting WebSocket server on ws://" << host << ":" << port << std::endl;
+        if (deflate)
+        {
+            std::cout << "permessage-deflate offered, level " << deflate->compLevel << ", window bits "
+                      << deflate->server_max_window_bits << std::endl;
+        }
         server.startAccept();
         std::cout << "Running io_context..." << std::endl;
         ioc.run();
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "time_accountant.hpp"
+
+namespace
+{
+
+std::optional<utils::TimeAccountingReport> ReadReport(const std::string &input_file, std::string &error)
+{
+    std::ifstream in(input_file);
+    if (!in.is_open())
+    {
+        error = "could not open '" + input_file + "'";
+        return std::nullopt;
+    }
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    boost::json::error_code ec;
+    const boost::json::value report = boost::json::parse(text, ec);
+    if (ec || !report.is_object())
+    {
+        error = "'" + input_file + "' is not a time report" + (ec ? ": " + ec.message() : "");
+        return std::nullopt;
+    }
+
+    // A field of the wrong type throws out of value_to, report it like any other unreadable file
+    try
+    {
+        return boost::json::value_to<utils::TimeAccountingReport>(report);
+    }
+    catch (const std::exception &e)
+    {
+        error = "'" + input_file + "' is not a time report: " + e.what();
+        return std::nullopt;
+    }
+}
+
+/**
+ * Granted times are doubles from different federates, key them to the microsecond so the same grant lines up.
+ */
+std::int64_t TimeKey(double granted_time)
+{
+    return std::llround(granted_time * 1e6);
+}
+
+struct CriticalShare
+{
+    std::uint64_t critical_steps{};
+    double critical_compute_ms{};
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> input_files(argv + 1, argv + argc);
+    if (input_files.empty())
+    {
+        std::cerr << "Usage: combine_time_reports <time report>...\n"
+                  << "Combines the per federate time reports of one run and names the federate on the critical "
+                     "path.\n"
+                  << "Example:\n"
+                  << "    combine_time_reports query-federate-time.json gpk_118_time.*.json\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<utils::TimeAccountingReport> reports;
+    for (const std::string &input_file : input_files)
+    {
+        std::string error;
+        std::optional<utils::TimeAccountingReport> report = ReadReport(input_file, error);
+        if (!report)
+        {
+            std::cerr << "Skipping: " << error << "\n";
+            continue;
+        }
+        reports.push_back(std::move(report.value()));
+    }
+    if (reports.empty())
+    {
+        std::cerr << "No reports to combine\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(32) << "federate" << std::right << std::setw(10) << "steps" << std::setw(14)
+              << "wall ms" << std::setw(14) << "blocked ms" << std::setw(14) << "compute ms" << std::setw(10)
+              << "blocked%" << std::setw(12) << "wall/sim" << "\n";
+    for (const utils::TimeAccountingReport &report : reports)
+    {
+        const double accounted_ms = report.blocked_ms + report.compute_ms;
+        std::cout << std::left << std::setw(32) << report.federate << std::right << std::setw(10) << report.step_count
+                  << std::setw(14) << report.wall_ms << std::setw(14) << report.blocked_ms << std::setw(14)
+                  << report.compute_ms << std::setw(10)
+                  << (accounted_ms > 0.0 ? 100.0 * report.blocked_ms / accounted_ms : 0.0) << std::setw(12)
+                  << report.wall_sim_ratio << "\n";
+    }
+
+    // Every federate has to finish computing a granted time before the federation moves past it, so the slowest
+    // compute at each time is the one everyone else waited on. Iterations at one time are summed first.
+    std::map<std::int64_t, std::vector<double>> compute_by_time;
+    for (std::size_t i = 0; i < reports.size(); i++)
+    {
+        for (const utils::TimeAccountingStep &step : reports[i].steps)
+        {
+            std::vector<double> &compute = compute_by_time[TimeKey(step.granted_time)];
+            compute.resize(reports.size());
+            compute[i] += step.compute_ms;
+        }
+    }
+    if (compute_by_time.empty())
+    {
+        std::cout << "\nNo per step data, the critical path needs reports written with their steps kept\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<CriticalShare> shares(reports.size());
+    double critical_path_ms = 0.0;
+    for (const auto &[time_key, compute] : compute_by_time)
+    {
+        const std::size_t slowest =
+            static_cast<std::size_t>(std::max_element(compute.begin(), compute.end()) - compute.begin());
+        shares[slowest].critical_steps++;
+        shares[slowest].critical_compute_ms += compute[slowest];
+        critical_path_ms += compute[slowest];
+    }
+
+    std::cout << "\nCritical path over " << compute_by_time.size() << " granted times: " << critical_path_ms
+              << " ms of compute\n";
+    std::cout << std::left << std::setw(32) << "federate" << std::right << std::setw(16) << "critical steps"
+              << std::setw(12) << "share%" << std::setw(14) << "compute ms" << "\n";
+    std::size_t critical_federate = 0;
+    for (std::size_t i = 0; i < reports.size(); i++)
+    {
+        std::cout << std::left << std::setw(32) << reports[i].federate << std::right << std::setw(16)
+                  << shares[i].critical_steps << std::setw(12)
+                  << (critical_path_ms > 0.0 ? 100.0 * shares[i].critical_compute_ms / critical_path_ms : 0.0)
+                  << std::setw(14) << shares[i].critical_compute_ms << "\n";
+        if (shares[i].critical_compute_ms > shares[critical_federate].critical_compute_ms)
+        {
+            critical_federate = i;
+        }
+    }
+
+    std::cout << "\nOn the critical path: " << reports[critical_federate].federate << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "binary_log.hpp"
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> input_files;
+    bool show_time = true;
+    bool show_source = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--no-time")
+        {
+            show_time = false;
+        }
+        else if (arg == "--source")
+        {
+            show_source = true;
+        }
+        else
+        {
+            input_files.push_back(arg);
+        }
+    }
+
+    if (input_files.empty())
+    {
+        std::cerr << "Usage: decode_binary_log [--no-time] [--source] <binary log>...\n"
+                  << "Example:\n"
+                  << "    decode_binary_log gpk_118_step.0.blog > gpk_118_step.0.txt\n";
+        return EXIT_FAILURE;
+    }
+
+    int ret_val = EXIT_SUCCESS;
+    for (const std::string &input_file : input_files)
+    {
+        if (input_files.size() > 1)
+        {
+            std::cout << "==> " << input_file << " <==\n";
+        }
+
+        std::string error;
+        bool is_complete = false;
+        try
+        {
+            is_complete = utils::DecodeBinaryLog(
+                input_file,
+                [show_time, show_source](const utils::DecodedBinaryLogStatement &statement)
+                {
+                    if (show_time)
+                    {
+                        std::cout << "[" << std::fixed << std::setprecision(6) << statement.elapsed_s << "] "
+                                  << std::defaultfloat;
+                    }
+                    if (show_source)
+                    {
+                        std::cout << statement.file << ":" << statement.line << " ";
+                    }
+                    std::cout << statement.text;
+                },
+                error);
+        }
+        catch (const std::exception &e)
+        {
+            // e.g. bad_alloc from a corrupt format id, the next file may still be fine
+            error = std::string("decode failed: ") + e.what();
+        }
+
+        if (!is_complete)
+        {
+            // A writer that was killed leaves a truncated last block, everything before it was still printed
+            std::cerr << input_file << ": " << error << "\n";
+            ret_val = EXIT_FAILURE;
+        }
+    }
+
+    return ret_val;
+}
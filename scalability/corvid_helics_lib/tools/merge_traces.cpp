@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+namespace
+{
+
+/**
+ * Cuts a trace that ends mid event back to the last event written completely, then closes the brackets still open
+ * around it. Strings are skipped with their escapes, so braces inside names and args do not count.
+ * @return std::nullopt if not even one event is complete.
+ */
+std::optional<std::string> RepairTruncatedTrace(const std::string &text)
+{
+    std::string open_brackets;
+    std::size_t events_depth = 0; // depth of the array holding the events, the first array opened
+    std::size_t cut = std::string::npos;
+    std::string closers;
+    bool is_in_string = false;
+    bool is_escaped = false;
+    for (std::size_t i = 0; i < text.size(); i++)
+    {
+        const char c = text[i];
+        if (is_in_string)
+        {
+            if (is_escaped)
+            {
+                is_escaped = false;
+            }
+            else if (c == '\\')
+            {
+                is_escaped = true;
+            }
+            else if (c == '"')
+            {
+                is_in_string = false;
+            }
+            continue;
+        }
+
+        switch (c)
+        {
+        case '"':
+            is_in_string = true;
+            break;
+        case '[':
+        case '{':
+            open_brackets.push_back(c);
+            if (c == '[' && events_depth == 0) events_depth = open_brackets.size();
+            break;
+        case ']':
+        case '}':
+            if (open_brackets.empty()) return std::nullopt;
+            open_brackets.pop_back();
+            // An event just closed directly inside the events array
+            if (c == '}' && events_depth > 0 && open_brackets.size() == events_depth)
+            {
+                cut = i + 1;
+                closers.clear();
+                for (auto open = open_brackets.rbegin(); open != open_brackets.rend(); ++open)
+                {
+                    closers.push_back(*open == '[' ? ']' : '}');
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (cut == std::string::npos) return std::nullopt;
+    return text.substr(0, cut) + "\n" + closers;
+}
+
+/**
+ * Reads the events of one trace, either the bare array TraceWriter writes or the object form with "traceEvents".
+ * A federate that died before closing its trace leaves the array unterminated, that is patched up here.
+ */
+std::optional<boost::json::array> ReadTrace(const std::string &input_file, std::string &error)
+{
+    std::ifstream in(input_file);
+    if (!in.is_open())
+    {
+        error = "could not open '" + input_file + "'";
+        return std::nullopt;
+    }
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    boost::json::error_code ec;
+    boost::json::value trace = boost::json::parse(text, ec);
+    if (ec)
+    {
+        const std::optional<std::string> repaired = RepairTruncatedTrace(text);
+        if (repaired)
+        {
+            ec.clear();
+            trace = boost::json::parse(repaired.value(), ec);
+        }
+    }
+    if (ec)
+    {
+        error = "'" + input_file + "' is not a trace: " + ec.message();
+        return std::nullopt;
+    }
+
+    if (trace.is_array())
+    {
+        return std::move(trace.as_array());
+    }
+    if (trace.is_object())
+    {
+        boost::json::value *events = trace.as_object().if_contains("traceEvents");
+        if (events != nullptr && events->is_array())
+        {
+            return std::move(events->as_array());
+        }
+    }
+
+    error = "'" + input_file + "' has no trace events";
+    return std::nullopt;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> input_files;
+    std::string output_file;
+    bool keep_absolute_time = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output_file = argv[++i];
+        }
+        else if (arg == "--absolute")
+        {
+            keep_absolute_time = true;
+        }
+        else
+        {
+            input_files.push_back(arg);
+        }
+    }
+
+    if (input_files.empty())
+    {
+        std::cerr << "Usage: merge_traces [--absolute] [-o <merged trace>] <trace>...\n"
+                  << "Merges per federate traces onto one timeline, open the result in ui.perfetto.dev or "
+                     "chrome://tracing.\n"
+                  << "Timestamps are shifted so the earliest event is at 0 unless --absolute is given.\n"
+                  << "Example:\n"
+                  << "    merge_traces -o federation.json query-federate-trace.json gpk_118_trace.*.json\n";
+        return EXIT_FAILURE;
+    }
+
+    boost::json::array merged;
+    std::int64_t next_pid = 1;
+    double earliest_us = std::numeric_limits<double>::max();
+    for (std::size_t file_index = 0; file_index < input_files.size(); file_index++)
+    {
+        std::string error;
+        std::optional<boost::json::array> events = ReadTrace(input_files[file_index], error);
+        if (!events)
+        {
+            std::cerr << "Skipping: " << error << "\n";
+            continue;
+        }
+
+        // Built on the side, so a file that fails half way adds nothing to the merged trace
+        boost::json::array file_events;
+        std::int64_t file_next_pid = next_pid;
+        double file_earliest_us = earliest_us;
+        try
+        {
+            // Two federates on different hosts can share a pid, give every process in every file its own
+            std::map<std::int64_t, std::int64_t> pids;
+            for (boost::json::value &event : events.value())
+            {
+                if (!event.is_object()) continue;
+                boost::json::object &object = event.as_object();
+
+                std::int64_t pid = 0;
+                if (const boost::json::value *found = object.if_contains("pid");
+                    found != nullptr && found->is_number())
+                {
+                    pid = found->to_number<std::int64_t>();
+                }
+                auto [entry, is_new] = pids.try_emplace(pid, file_next_pid);
+                if (is_new)
+                {
+                    file_next_pid++;
+                    file_events.push_back({ { "name", "process_sort_index" },
+                                            { "ph", "M" },
+                                            { "pid", entry->second },
+                                            { "args", { { "sort_index", file_index } } } });
+                }
+                object["pid"] = entry->second;
+
+                if (const boost::json::value *ts = object.if_contains("ts"); ts != nullptr && ts->is_number())
+                {
+                    file_earliest_us = std::min(file_earliest_us, ts->to_number<double>());
+                }
+                file_events.push_back(std::move(event));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // e.g. a pid that is not a whole number
+            std::cerr << "Skipping: '" << input_files[file_index] << "': " << e.what() << "\n";
+            continue;
+        }
+
+        next_pid = file_next_pid;
+        earliest_us = file_earliest_us;
+        for (boost::json::value &event : file_events)
+        {
+            merged.push_back(std::move(event));
+        }
+    }
+
+    if (merged.empty())
+    {
+        std::cerr << "No events to merge\n";
+        return EXIT_FAILURE;
+    }
+
+    const bool has_timestamps = earliest_us != std::numeric_limits<double>::max();
+    if (!keep_absolute_time && has_timestamps)
+    {
+        for (boost::json::value &event : merged)
+        {
+            boost::json::object &object = event.as_object();
+            if (boost::json::value *ts = object.if_contains("ts"); ts != nullptr && ts->is_number())
+            {
+                *ts = ts->to_number<double>() - earliest_us;
+            }
+        }
+    }
+
+    boost::json::object trace;
+    trace["traceEvents"] = std::move(merged);
+    trace["displayTimeUnit"] = "ms";
+    trace["otherData"] = { { "time_origin_epoch_us", keep_absolute_time || !has_timestamps ? 0.0 : earliest_us },
+                           { "source_files", input_files.size() } };
+
+    const std::string output = boost::json::serialize(trace);
+    if (output_file.empty())
+    {
+        std::cout << output << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::ofstream out(output_file, std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Could not open '" << output_file << "'\n";
+        return EXIT_FAILURE;
+    }
+    out << output << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+#include "binary_log.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+
+// "CVBL" read as a little endian u32
+constexpr std::uint32_t BINARY_LOG_MAGIC = 0x4C425643;
+constexpr std::uint16_t BINARY_LOG_VERSION = 1;
+constexpr std::uint8_t DEFINITION_RECORD = 1;
+constexpr std::uint8_t STATEMENT_RECORD = 2;
+// Ids are call site indices, far more than any program has means the id is corrupt
+constexpr std::uint32_t MAX_FORMAT_ID = 1U << 20;
+
+struct FormatRegistry
+{
+    std::mutex mutex;
+    // Index 0 is unused so a site id of 0 can mean unregistered
+    std::vector<utils::BinaryLogFormat> formats{ 1 };
+};
+
+FormatRegistry &GetRegistry()
+{
+    static FormatRegistry registry;
+    return registry;
+}
+
+template <typename V> void WriteValue(std::ofstream &out, const V &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(V));
+}
+
+template <typename V> bool ReadValue(std::ifstream &in, V &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(V)));
+}
+
+std::uint64_t GetRemainingBytes(std::ifstream &in)
+{
+    const std::streampos position = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streampos end = in.tellg();
+    in.seekg(position);
+    return end > position ? static_cast<std::uint64_t>(end - position) : 0;
+}
+
+template <typename Length> bool ReadString(std::ifstream &in, std::string &value)
+{
+    // A corrupt length must not turn into a huge allocation, the string can be no longer than the rest of the file
+    Length length = 0;
+    if (!ReadValue(in, length) || length > GetRemainingBytes(in)) return false;
+
+    value.resize(length);
+    return static_cast<bool>(in.read(value.data(), length));
+}
+
+/**
+ * Reads one argument of the given type code and appends its text.
+ */
+bool ReadArgument(std::ifstream &in, char code, std::ostream &text)
+{
+    switch (code)
+    {
+    case 'b':
+    {
+        char value = 0;
+        if (!ReadValue(in, value)) return false;
+        text << (value != 0 ? "true" : "false");
+        return true;
+    }
+    case 'c':
+    {
+        char value = 0;
+        if (!ReadValue(in, value)) return false;
+        text << value;
+        return true;
+    }
+    case 'i':
+    {
+        std::int64_t value = 0;
+        if (!ReadValue(in, value)) return false;
+        text << value;
+        return true;
+    }
+    case 'u':
+    {
+        std::uint64_t value = 0;
+        if (!ReadValue(in, value)) return false;
+        text << value;
+        return true;
+    }
+    case 'd':
+    {
+        double value = 0.0;
+        if (!ReadValue(in, value)) return false;
+        text << value;
+        return true;
+    }
+    case 's':
+    {
+        std::string value;
+        if (!ReadString<std::uint32_t>(in, value)) return false;
+        text << value;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+// ###################################
+// Format Registry
+// ###################################
+
+std::uint32_t utils::RegisterBinaryLogFormat(utils::BinaryLogSite &site, const char *format,
+                                             const std::string &signature)
+{
+    FormatRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // Another thread may have registered the site while we waited
+    std::uint32_t id = site.id.load(std::memory_order_acquire);
+    if (id != 0)
+    {
+        return id;
+    }
+
+    id = static_cast<std::uint32_t>(registry.formats.size());
+    registry.formats.push_back({ format != nullptr ? format : "", signature, site.file, site.line });
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
+
+utils::BinaryLogFormat utils::GetBinaryLogFormat(std::uint32_t id)
+{
+    FormatRegistry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return id < registry.formats.size() ? registry.formats[id] : utils::BinaryLogFormat{};
+}
+
+// ###################################
+// BinaryLogWriter Implementation
+// ###################################
+
+utils::BinaryLogWriter::BinaryLogWriter(const std::string &output_file, std::size_t buffer_bytes)
+    : m_output_stream(output_file, std::ios::binary | std::ios::trunc), m_buffer(buffer_bytes),
+      m_open_time(std::chrono::steady_clock::now())
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    const std::int64_t open_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::system_clock::now().time_since_epoch())
+                                          .count();
+    WriteValue(m_output_stream, BINARY_LOG_MAGIC);
+    WriteValue(m_output_stream, BINARY_LOG_VERSION);
+    WriteValue(m_output_stream, std::uint16_t{ 0 });
+    WriteValue(m_output_stream, open_time_ns);
+}
+
+utils::BinaryLogWriter::~BinaryLogWriter()
+{
+    if (IsOpen())
+    {
+        Flush();
+        m_output_stream.close();
+    }
+}
+
+void utils::BinaryLogWriter::Flush()
+{
+    if (!IsOpen()) return;
+
+    m_output_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_used));
+    m_output_stream.flush();
+    m_used = 0;
+}
+
+char *utils::BinaryLogWriter::Reserve(std::size_t bytes)
+{
+    if (m_used + bytes > m_buffer.size())
+    {
+        Flush();
+
+        // A single statement larger than the buffer, a long string argument
+        if (bytes > m_buffer.size()) m_buffer.resize(bytes);
+    }
+
+    char *out = m_buffer.data() + m_used;
+    m_used += bytes;
+    return out;
+}
+
+void utils::BinaryLogWriter::WriteDefinition(std::uint32_t id)
+{
+    const utils::BinaryLogFormat format = utils::GetBinaryLogFormat(id);
+
+    const std::size_t bytes = sizeof(std::uint8_t) + sizeof(std::uint32_t) + sizeof(std::uint16_t) +
+                              format.signature.size() + sizeof(std::uint32_t) + format.format.size() +
+                              sizeof(std::uint16_t) + format.file.size() + sizeof(std::int32_t);
+    char *out = Reserve(bytes);
+    out = binary_log_detail::Put(out, DEFINITION_RECORD);
+    out = binary_log_detail::Put(out, id);
+    out = binary_log_detail::Put(out, static_cast<std::uint16_t>(format.signature.size()));
+    out = std::copy(format.signature.begin(), format.signature.end(), out);
+    out = binary_log_detail::Put(out, static_cast<std::uint32_t>(format.format.size()));
+    out = std::copy(format.format.begin(), format.format.end(), out);
+    out = binary_log_detail::Put(out, static_cast<std::uint16_t>(format.file.size()));
+    out = std::copy(format.file.begin(), format.file.end(), out);
+    binary_log_detail::Put(out, static_cast<std::int32_t>(format.line));
+
+    if (id >= m_defined.size()) m_defined.resize(id + 1);
+    m_defined[id] = true;
+}
+
+// ###################################
+// Decoding
+// ###################################
+
+bool utils::DecodeBinaryLog(const std::string &input_file,
+                            const std::function<void(const utils::DecodedBinaryLogStatement &)> &on_statement,
+                            std::string &error)
+{
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in.is_open())
+    {
+        error = "could not open '" + input_file + "'";
+        return false;
+    }
+
+    std::uint32_t magic = 0;
+    std::uint16_t version = 0;
+    std::uint16_t reserved = 0;
+    std::int64_t open_time_ns = 0;
+    if (!ReadValue(in, magic) || !ReadValue(in, version) || !ReadValue(in, reserved) || !ReadValue(in, open_time_ns) ||
+        magic != BINARY_LOG_MAGIC || version != BINARY_LOG_VERSION)
+    {
+        error = "'" + input_file + "' is not a binary log";
+        return false;
+    }
+
+    // Keyed by id, a log only defines the call sites it used so the ids can be sparse
+    std::unordered_map<std::uint32_t, utils::BinaryLogFormat> formats;
+    std::uint8_t kind = 0;
+    while (ReadValue(in, kind))
+    {
+        std::uint32_t id = 0;
+        if (!ReadValue(in, id))
+        {
+            error = "truncated record";
+            return false;
+        }
+        if (id == 0 || id > MAX_FORMAT_ID)
+        {
+            error = "format id " + std::to_string(id) + " out of range";
+            return false;
+        }
+
+        if (kind == DEFINITION_RECORD)
+        {
+            utils::BinaryLogFormat format;
+            std::int32_t line = 0;
+            if (!ReadString<std::uint16_t>(in, format.signature) || !ReadString<std::uint32_t>(in, format.format) ||
+                !ReadString<std::uint16_t>(in, format.file) || !ReadValue(in, line))
+            {
+                error = "truncated or corrupt format definition";
+                return false;
+            }
+            format.line = line;
+
+            formats[id] = std::move(format);
+            continue;
+        }
+
+        std::uint64_t elapsed_ns = 0;
+        const auto found = formats.find(id);
+        if (kind != STATEMENT_RECORD || found == formats.end() || !ReadValue(in, elapsed_ns))
+        {
+            error = "unexpected or truncated record";
+            return false;
+        }
+
+        // Substitute the arguments for the "{}" in order, any left over go on the end of the line
+        const utils::BinaryLogFormat &format = found->second;
+        std::ostringstream text;
+        std::ostringstream extra;
+        std::size_t position = 0;
+        for (const char code : format.signature)
+        {
+            const std::size_t placeholder = format.format.find("{}", position);
+            if (placeholder != std::string::npos)
+            {
+                text << format.format.substr(position, placeholder - position);
+                position = placeholder + 2;
+            }
+            else
+            {
+                extra << " ";
+            }
+
+            if (!ReadArgument(in, code, placeholder != std::string::npos ? text : extra))
+            {
+                error = "truncated or corrupt statement";
+                return false;
+            }
+        }
+
+        const std::string rest = format.format.substr(position);
+        if (!rest.empty() && rest.back() == '\n')
+        {
+            text << rest.substr(0, rest.size() - 1) << extra.str() << "\n";
+        }
+        else
+        {
+            text << rest << extra.str();
+        }
+
+        utils::DecodedBinaryLogStatement statement;
+        statement.elapsed_s = static_cast<double>(elapsed_ns) / 1e9;
+        statement.open_time_ns = open_time_ns;
+        statement.text = text.str();
+        statement.file = format.file;
+        statement.line = format.line;
+        on_statement(statement);
+    }
+
+    return true;
+}
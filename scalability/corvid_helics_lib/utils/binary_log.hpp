@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Logs a statement to a utils::BinaryLogWriter. The format is a string literal with a "{}" per argument, it is
+ * registered once per call site and only its id and the raw argument bytes are written per call, e.g.
+ *
+ *   CORVID_BINARY_LOG(binary_log, "Bus Id: {} Power A: {}", bus_id, power.a);
+ */
+#define CORVID_BINARY_LOG(writer, ...)                                                                               \
+    do                                                                                                               \
+    {                                                                                                                \
+        static ::utils::BinaryLogSite corvid_binary_log_site{ __FILE__, __LINE__ };                                  \
+        (writer).Write(corvid_binary_log_site, __VA_ARGS__);                                                         \
+    } while (false)
+
+namespace utils
+{
+
+/**
+ * One per call site, the id is assigned the first time the site logs and shared by every writer in the process.
+ */
+struct BinaryLogSite
+{
+    const char *file;
+    int line;
+    std::atomic<std::uint32_t> id{};
+
+    BinaryLogSite(const char *site_file, int site_line) : file(site_file), line(site_line) {}
+};
+
+struct BinaryLogFormat
+{
+    std::string format{};
+    // One type code per argument, see binary_log_detail::TypeCode
+    std::string signature{};
+    std::string file{};
+    int line{};
+};
+
+/**
+ * @brief Assigns the site an id for this format and argument signature, safe to call from several threads.
+ */
+std::uint32_t RegisterBinaryLogFormat(BinaryLogSite &site, const char *format, const std::string &signature);
+BinaryLogFormat GetBinaryLogFormat(std::uint32_t id);
+
+namespace binary_log_detail
+{
+
+template <typename T> constexpr bool IS_STRING_V =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, const char *> ||
+    std::is_same_v<T, char *>;
+
+template <typename T> constexpr char TypeCode()
+{
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) return 'b';
+    else if constexpr (std::is_same_v<D, char>) return 'c';
+    else if constexpr (std::is_enum_v<D>) return TypeCode<std::underlying_type_t<D>>();
+    else if constexpr (std::is_integral_v<D>) return std::is_signed_v<D> ? 'i' : 'u';
+    else if constexpr (std::is_floating_point_v<D>) return 'd';
+    else
+    {
+        static_assert(IS_STRING_V<D>, "Binary logs only take numbers, bools, chars, enums and strings.");
+        return 's';
+    }
+}
+
+template <typename T> std::string_view AsString(const T &value)
+{
+    using D = std::decay_t<T>;
+    if constexpr (std::is_array_v<T>)
+    {
+        return std::string_view(value);
+    }
+    else if constexpr (std::is_same_v<D, const char *> || std::is_same_v<D, char *>)
+    {
+        return value != nullptr ? std::string_view(value) : std::string_view();
+    }
+    else
+    {
+        return std::string_view(value);
+    }
+}
+
+template <typename T> std::size_t EncodedSize(const T &value)
+{
+    constexpr char code = TypeCode<T>();
+    if constexpr (code == 'b' || code == 'c') return 1;
+    else if constexpr (code == 's') return sizeof(std::uint32_t) + AsString(value).size();
+    else return 8;
+}
+
+template <typename V> char *Put(char *out, const V &value)
+{
+    std::memcpy(out, &value, sizeof(V));
+    return out + sizeof(V);
+}
+
+template <typename T> char *Encode(char *out, const T &value)
+{
+    using D = std::decay_t<T>;
+    constexpr char code = TypeCode<T>();
+    if constexpr (code == 'b' || code == 'c') return Put(out, static_cast<char>(value));
+    else if constexpr (code == 'i') return Put(out, static_cast<std::int64_t>(value));
+    else if constexpr (code == 'u') return Put(out, static_cast<std::uint64_t>(value));
+    else if constexpr (code == 'd') return Put(out, static_cast<double>(value));
+    else
+    {
+        static_assert(IS_STRING_V<D>);
+        const std::string_view text = AsString(value);
+        out = Put(out, static_cast<std::uint32_t>(text.size()));
+        std::memcpy(out, text.data(), text.size());
+        return out + text.size();
+    }
+}
+
+} // namespace binary_log_detail
+
+/**
+ * Binary log file, nanolog style. Every call site is written as a format definition the first time it is used in
+ * the file, after that a statement is a format id, a timestamp and the raw argument bytes copied into a buffer that
+ * is written out in large blocks. Formatting is left to DecodeBinaryLog, usually offline with decode_binary_log.
+ *
+ *   header:     u32 magic "CVBL" | u16 version | u16 reserved | i64 system clock ns at open
+ *   definition: u8 1 | u32 id | u16 signature length | signature | u32 format length | format
+ *               | u16 file length | file | i32 line
+ *   statement:  u8 2 | u32 id | u64 ns since open | arguments
+ *   arguments:  i/u/d 8 bytes, b/c 1 byte, s u32 length + bytes
+ *
+ * Values are written in host byte order. Not thread safe, use one writer per thread.
+ */
+class BinaryLogWriter
+{
+  private:
+    std::ofstream m_output_stream{};
+    std::vector<char> m_buffer{};
+    std::size_t m_used{};
+    std::vector<bool> m_defined{};
+    std::chrono::steady_clock::time_point m_open_time{};
+    std::uint64_t m_statements{};
+
+    void WriteDefinition(std::uint32_t id);
+    char *Reserve(std::size_t bytes);
+
+  public:
+    /**
+     * @param buffer_bytes statements are buffered in memory until this many bytes build up.
+     */
+    explicit BinaryLogWriter(const std::string &output_file, std::size_t buffer_bytes = 256 * 1024);
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter &) = delete;
+    BinaryLogWriter &operator=(const BinaryLogWriter &) = delete;
+
+    bool IsOpen() const { return m_output_stream.is_open(); }
+    void Flush();
+    std::uint64_t GetStatementCount() const { return m_statements; }
+
+    /**
+     * Use CORVID_BINARY_LOG instead of calling this directly, it supplies the per call site state.
+     * Must remain in header because it is a template.
+     */
+    template <typename... Args> void Write(BinaryLogSite &site, const char *format, const Args &...args)
+    {
+        if (!IsOpen()) return;
+
+        std::uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0)
+        {
+            id = RegisterBinaryLogFormat(site, format, std::string{ binary_log_detail::TypeCode<Args>()... });
+        }
+        if (id >= m_defined.size() || !m_defined[id]) WriteDefinition(id);
+
+        const std::uint64_t elapsed_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_open_time)
+                .count());
+
+        const std::size_t bytes = sizeof(std::uint8_t) + sizeof(std::uint32_t) + sizeof(std::uint64_t) +
+                                  (std::size_t{ 0 } + ... + binary_log_detail::EncodedSize(args));
+        char *out = Reserve(bytes);
+        out = binary_log_detail::Put(out, std::uint8_t{ 2 });
+        out = binary_log_detail::Put(out, id);
+        out = binary_log_detail::Put(out, elapsed_ns);
+        ((out = binary_log_detail::Encode(out, args)), ...);
+
+        m_statements++;
+    }
+};
+
+struct DecodedBinaryLogStatement
+{
+    // Seconds since the writer opened the file, add open_time_ns for the wall clock
+    double elapsed_s{};
+    std::int64_t open_time_ns{};
+    std::string text{};
+    std::string file{};
+    int line{};
+};
+
+/**
+ * @brief Reads a binary log and calls on_statement with each statement formatted back into text.
+ * @return false with error set if the file could not be read or is truncated, statements before that point have
+ *         already been passed to on_statement.
+ */
+bool DecodeBinaryLog(const std::string &input_file,
+                     const std::function<void(const DecodedBinaryLogStatement &)> &on_statement, std::string &error);
+
+} // namespace utils
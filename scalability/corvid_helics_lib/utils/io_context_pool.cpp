@@ -0,0 +1,39 @@
+#include "io_context_pool.hpp"
+
+#include <algorithm>
+
+utils::IoContextPool::IoContextPool(std::size_t thread_count)
+    : m_ioc(static_cast<int>(std::max<std::size_t>(thread_count, 1))), m_work_guard(), m_threads(),
+      m_thread_count(std::max<std::size_t>(thread_count, 1))
+{
+}
+
+utils::IoContextPool::~IoContextPool() { Stop(); }
+
+void utils::IoContextPool::Start()
+{
+    if (!m_threads.empty())
+    {
+        return;
+    }
+
+    m_work_guard.emplace(boost::asio::make_work_guard(m_ioc));
+    for (std::size_t i = 0; i < m_thread_count; i++)
+    {
+        m_threads.emplace_back([this]() { m_ioc.run(); });
+    }
+}
+
+void utils::IoContextPool::Stop()
+{
+    m_work_guard.reset(); // Allow run() to exit if out of work
+    m_ioc.stop();         // Force stop
+
+    for (std::thread &thread : m_threads)
+    {
+        if (thread.joinable()) thread.join();
+    }
+    m_threads.clear();
+
+    m_ioc.restart(); // Reset for potential reuse
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace utils
+{
+
+/**
+ * One io_context run by a fixed number of threads, meant to be handed to many WebSocketClient instances so N
+ * connections share M threads. Each client serializes its own handlers on a strand, the pool only provides threads.
+ */
+class IoContextPool
+{
+  private:
+    boost::asio::io_context m_ioc;
+    std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> m_work_guard;
+    std::vector<std::thread> m_threads;
+    std::size_t m_thread_count{};
+
+  public:
+    explicit IoContextPool(std::size_t thread_count);
+    ~IoContextPool();
+
+    IoContextPool(const IoContextPool &) = delete;
+    IoContextPool &operator=(const IoContextPool &) = delete;
+
+    boost::asio::io_context &GetContext() { return m_ioc; }
+    std::size_t GetThreadCount() const { return m_thread_count; }
+
+    /**
+     * @brief Spawns the threads. Returns immediately, calling it again while running does nothing.
+     */
+    void Start();
+
+    /**
+     * @brief Stops the context and joins the threads. The pool can be started again afterwards.
+     */
+    void Stop();
+};
+
+} // namespace utils
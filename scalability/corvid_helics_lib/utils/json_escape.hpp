@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+
+/**
+ * @brief Escapes text for use inside a JSON string, for the files written by hand without building a boost::json
+ *        value per record.
+ */
+inline std::string EscapeJson(std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                escaped += code;
+            }
+            else
+            {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+} // namespace utils
@@ -5,13 +5,19 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <memory>
+#include <algorithm>
+#include <system_error>
 
 #include <boost/json.hpp>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include "mapped_file.hpp"
+
 namespace utils
 {
 /**
@@ -290,37 +296,86 @@ template <typename T> bool ToJsonFile(const T &input, const std::string &output_
     return was_write_successful;
 }
 
+/**
+ * @brief Parses json text into a value whose nodes all come from sp. The parser's own scratch stack lives on this
+ *        function's stack, only configs nested deeper than it fits spill over to the heap.
+ *
+ * @param json_text is the complete json document, it does not need to be null terminated.
+ * @param sp is the storage the returned value allocates from, typically a boost::json::monotonic_resource.
+ * @param ec is set if json_text is not valid json, in which case null is returned.
+ * @return The parsed value, only valid for as long as the storage behind sp.
+ */
+inline boost::json::value ParseJson(std::string_view json_text, boost::json::storage_ptr sp,
+                                    boost::json::error_code &ec)
+{
+    unsigned char scratch[4096];
+    boost::json::parser parser(boost::json::storage_ptr(), boost::json::parse_options(), scratch, sizeof(scratch));
+    parser.reset(std::move(sp));
+    parser.write(json_text.data(), json_text.size(), ec);
+    if (ec)
+    {
+        return nullptr;
+    }
+    return parser.release();
+}
+
+/**
+ * @brief First block size for the arena a document of json_size bytes is parsed into. The tree is usually about the
+ *        size of the text, so the arena starts there and grows from it rather than from a few hundred bytes.
+ */
+inline std::size_t GetJsonArenaSize(std::size_t json_size)
+{
+    return std::max<std::size_t>(json_size, 4096);
+}
+
 /**
  * @brief Given some propery json string that can be mapped to an
  *        object of type T, instantiate an instance of T created using
  *        this particular string.
+ *
+ *        The intermediate tree is built in a monotonic arena that is dropped in one go once T is filled, instead
+ *        of allocating and freeing every node on the heap. Nothing of the tree outlives this call, tag_invoke
+ *        copies what it keeps into T.
+ *
  * @tparam T is some type that can be created from a Json string.
-
+ * @throws boost::system::system_error if json_string is not valid json.
  */
-template <typename T> T FromJsonString(const std::string &json_string)
+template <typename T> T FromJsonString(std::string_view json_string)
 {
-    return boost::json::value_to<T>(boost::json::parse(json_string));
+    boost::json::monotonic_resource arena(GetJsonArenaSize(json_string.size()));
+    boost::json::error_code ec;
+    const boost::json::value json = ParseJson(json_string, &arena, ec);
+    if (ec)
+    {
+        throw boost::system::system_error(ec);
+    }
+
+    return boost::json::value_to<T>(json);
 }
 
 /**
  * @brief Given some json file that can be mapped to object of type T,
  *        instantiate an instance of T created using the particular file.
  *
- *        We could probably do more to make this safer to use from a file
- *        access perspective.
+ *        The file is memory mapped and parsed in place, so a large generated
+ *        config is never copied into a string first.
  *
  * @tparam T is some type that can be created from a Json file.
  * @param input_file is the full filepath of the json file.
  * @return T is the newly created instance from the given file.
+ * @throws std::filesystem::filesystem_error if the file cannot be mapped, boost::system::system_error if it is not
+ *         valid json.
  */
 template <typename T> T FromJsonFile(const std::string &input_file)
 {
-    auto size = std::filesystem::file_size(input_file);
-    std::string json_content(size, '\0');
-    std::ifstream in(input_file);
-    in.read(&json_content[0], size);
+    std::error_code ec;
+    const std::unique_ptr<MappedFile> file = MappedFile::Open(input_file, ec);
+    if (!file)
+    {
+        throw std::filesystem::filesystem_error("Could not map json file", input_file, ec);
+    }
 
-    return FromJsonString<T>(json_content);
+    return FromJsonString<T>(file->GetView());
 }
 
 /**
@@ -0,0 +1,108 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+unsigned HighestBit(std::uint64_t value)
+{
+    unsigned bit = 0;
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+} // namespace
+
+utils::LatencyHistogram::LatencyHistogram()
+    : m_counts(GetBucketIndex(~std::uint64_t{ 0 }) + 1, 0)
+{
+}
+
+std::size_t utils::LatencyHistogram::GetBucketIndex(std::uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+    {
+        return static_cast<std::size_t>(value);
+    }
+
+    // Keep the top SUB_BUCKET_BITS + 1 bits, the leading one picks the power of two and the rest the linear bucket
+    const unsigned shift = HighestBit(value) - SUB_BUCKET_BITS;
+    const std::uint64_t sub_bucket = (value >> shift) & (SUB_BUCKET_COUNT - 1);
+    return static_cast<std::size_t>((shift + 1) * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+std::uint64_t utils::LatencyHistogram::GetBucketUpperBound(std::size_t index)
+{
+    if (index < SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+
+    const unsigned shift = static_cast<unsigned>(index / SUB_BUCKET_COUNT) - 1;
+    const std::uint64_t sub_bucket = index % SUB_BUCKET_COUNT;
+    const std::uint64_t lower = (SUB_BUCKET_COUNT + sub_bucket) << shift;
+    return lower + ((std::uint64_t{ 1 } << shift) - 1);
+}
+
+void utils::LatencyHistogram::Record(std::uint64_t value)
+{
+    m_counts[GetBucketIndex(value)]++;
+    m_min = m_count == 0 ? value : std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_sum += static_cast<double>(value);
+    m_count++;
+}
+
+void utils::LatencyHistogram::Merge(const utils::LatencyHistogram &other)
+{
+    if (other.m_count == 0)
+    {
+        return;
+    }
+
+    for (std::size_t i = 0; i < m_counts.size(); i++)
+    {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+void utils::LatencyHistogram::Reset()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0.0;
+}
+
+std::uint64_t utils::LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const std::uint64_t rank =
+        std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * m_count)));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_counts.size(); i++)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+        {
+            return std::min(GetBucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
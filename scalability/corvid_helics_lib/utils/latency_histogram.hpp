@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * HDR style histogram of non-negative integer values, usually nanoseconds. Values below 32 are counted exactly, above
+ * that every power of two is split into 32 linear buckets, so any recorded value is reported within about 3% over the
+ * whole 64 bit range at a fixed 15 KiB. Recording is a couple of shifts and an increment, no allocation.
+ */
+class LatencyHistogram
+{
+  private:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr std::uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_count{};
+    std::uint64_t m_min{};
+    std::uint64_t m_max{};
+    double m_sum{};
+
+    static std::size_t GetBucketIndex(std::uint64_t value);
+    static std::uint64_t GetBucketUpperBound(std::size_t index);
+
+  public:
+    LatencyHistogram();
+
+    void Record(std::uint64_t value);
+    void Merge(const LatencyHistogram &other);
+    void Reset();
+
+    std::uint64_t GetCount() const { return m_count; }
+    std::uint64_t GetMin() const { return m_min; }
+    std::uint64_t GetMax() const { return m_max; }
+    double GetSum() const { return m_sum; }
+    double GetMean() const { return m_count > 0 ? m_sum / m_count : 0.0; }
+
+    /**
+     * @param percentile in [0, 100].
+     * @return the upper bound of the bucket holding that percentile, clamped to the recorded maximum.
+     */
+    std::uint64_t GetPercentile(double percentile) const;
+};
+
+} // namespace utils
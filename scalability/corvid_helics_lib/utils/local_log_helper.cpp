@@ -1,11 +1,29 @@
 #include "local_log_helper.hpp"
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
 // --- LocalLogHelper Implementation ---
 
-utils::LocalLogHelper::LocalLogHelper(const std::string &output_file) : m_output_stream(output_file) {}
+utils::LocalLogHelper::LocalLogHelper(const std::string &output_file, const utils::AsyncLogOptions &async_options)
+    : m_output_stream(output_file), m_async_options(async_options)
+{
+    if (m_async_options.enabled)
+    {
+        m_writer = std::thread([this]() { WriterLoop(); });
+    }
+}
 
 utils::LocalLogHelper::~LocalLogHelper()
 {
+    if (m_writer.joinable())
+    {
+        m_is_stopping = true;
+        m_wake_cv.notify_one();
+        m_writer.join();
+    }
+
     if (IsOpen()) m_output_stream.close();
 }
 
@@ -13,11 +31,13 @@ bool utils::LocalLogHelper::IsOpen() const { return m_output_stream.is_open(); }
 
 void utils::LocalLogHelper::SetOnWriteCallback(std::function<void(const std::string &)> on_write)
 {
+    std::lock_guard<std::mutex> lock(m_sink_mutex);
     m_on_write = on_write;
 }
 
 void utils::LocalLogHelper::SetOutputFile(const std::string &output_file)
 {
+    std::lock_guard<std::mutex> lock(m_sink_mutex);
     if (IsOpen())
     {
         m_output_stream.close();
@@ -43,6 +63,138 @@ void utils::LocalLogHelper::FlushToCallback()
     m_formatting_stream.clear();
 }
 
+void utils::LocalLogHelper::Flush()
+{
+    if (!m_async_options.enabled)
+    {
+        if (IsOpen()) m_output_stream.flush();
+        return;
+    }
+
+    const std::uint64_t target = m_enqueued.load();
+    m_is_flush_requested = true;
+    m_wake_cv.notify_one();
+
+    std::unique_lock<std::mutex> lock(m_sink_mutex);
+    m_written_cv.wait(lock, [this, target]() { return m_written >= target; });
+}
+
+std::uint64_t utils::LocalLogHelper::GetBatchCount()
+{
+    std::lock_guard<std::mutex> lock(m_sink_mutex);
+    return m_batches;
+}
+
+namespace
+{
+
+// Buffers of finished statements, kept for reuse by the next statement on the same thread
+std::vector<std::unique_ptr<std::ostringstream>> &GetFreeThreadBuffers()
+{
+    thread_local std::vector<std::unique_ptr<std::ostringstream>> buffers;
+    return buffers;
+}
+
+} // namespace
+
+std::ostringstream *utils::LocalLogHelper::AcquireThreadBuffer()
+{
+    std::vector<std::unique_ptr<std::ostringstream>> &buffers = GetFreeThreadBuffers();
+    if (buffers.empty())
+    {
+        return new std::ostringstream();
+    }
+
+    std::ostringstream *buffer = buffers.back().release();
+    buffers.pop_back();
+    return buffer;
+}
+
+void utils::LocalLogHelper::ReleaseThreadBuffer(std::ostringstream *buffer)
+{
+    buffer->str(std::string());
+    buffer->clear();
+    GetFreeThreadBuffers().emplace_back(buffer);
+}
+
+void utils::LocalLogHelper::Enqueue(std::string &&text)
+{
+    // Count the bytes first so the writer never subtracts more than was added
+    const std::size_t pending_bytes = m_pending_bytes.fetch_add(text.size()) + text.size();
+    m_pending.Push(std::move(text));
+    m_enqueued++;
+
+    // The writer also wakes on its own every max_batch_delay_ms, a missed notify only delays a full batch
+    if (pending_bytes >= m_async_options.max_batch_bytes) m_wake_cv.notify_one();
+}
+
+void utils::LocalLogHelper::WriterLoop()
+{
+    const auto max_delay = std::chrono::duration<double, std::milli>(m_async_options.max_batch_delay_ms);
+
+    std::string batch;
+    std::uint64_t statements = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_wake_mutex);
+            m_wake_cv.wait_for(lock, max_delay,
+                               [this]()
+                               {
+                                   return m_is_stopping || m_is_flush_requested ||
+                                          m_pending_bytes >= m_async_options.max_batch_bytes;
+                               });
+        }
+
+        // Read before draining, everything logged before the destructor ran is then written
+        const bool is_stopping = m_is_stopping;
+        m_is_flush_requested = false;
+
+        std::string text;
+        while (m_pending.TryPop(text))
+        {
+            m_pending_bytes -= text.size();
+            batch += text;
+            statements++;
+
+            if (batch.size() >= m_async_options.max_batch_bytes)
+            {
+                WriteBatch(batch, statements);
+                batch.clear();
+                statements = 0;
+            }
+        }
+
+        if (statements > 0)
+        {
+            WriteBatch(batch, statements);
+            batch.clear();
+            statements = 0;
+        }
+
+        if (is_stopping) break;
+    }
+}
+
+void utils::LocalLogHelper::WriteBatch(const std::string &batch, std::uint64_t statements)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sink_mutex);
+        if (!batch.empty())
+        {
+            if (m_output_stream.is_open())
+            {
+                m_output_stream.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                m_output_stream.flush();
+            }
+            if (m_on_write) m_on_write(batch);
+            m_batches++;
+        }
+        m_written += statements;
+    }
+    m_written_cv.notify_all();
+}
+
 // Note: The return type LogStream must be qualified as it is nested inside the class and namespace
 utils::LocalLogHelper::LogStream utils::LocalLogHelper::operator<<(StreamManipulator manip)
 {
@@ -53,21 +205,40 @@ utils::LocalLogHelper::LogStream utils::LocalLogHelper::operator<<(StreamManipul
 
 // --- LogStream Proxy Implementation ---
 
-utils::LocalLogHelper::LogStream::LogStream(LocalLogHelper &parent) : m_parent(parent), m_should_flush(true) {}
+utils::LocalLogHelper::LogStream::LogStream(LocalLogHelper &parent)
+    : m_parent(parent), m_buffer(parent.IsAsync() ? AcquireThreadBuffer() : nullptr), m_should_flush(true)
+{
+}
 
 utils::LocalLogHelper::LogStream::LogStream(LogStream &&other) noexcept
-    : m_parent(other.m_parent), m_should_flush(other.m_should_flush)
+    : m_parent(other.m_parent), m_buffer(other.m_buffer), m_should_flush(other.m_should_flush)
 {
+    other.m_buffer = nullptr;
     other.m_should_flush = false;
 }
 
 utils::LocalLogHelper::LogStream::~LogStream()
 {
+    if (m_buffer)
+    {
+        if (m_should_flush) m_parent.Enqueue(m_buffer->str());
+        ReleaseThreadBuffer(m_buffer);
+        return;
+    }
+
     if (m_should_flush) m_parent.FlushToCallback();
 }
 
 utils::LocalLogHelper::LogStream &utils::LocalLogHelper::LogStream::operator<<(StreamManipulator manip)
 {
-    m_parent.AppendManip(manip);
+    if (m_buffer)
+    {
+        // std::endl only needs to end the line here, the writer flushes the file after every batch
+        *m_buffer << manip;
+    }
+    else
+    {
+        m_parent.AppendManip(manip);
+    }
     return *this;
 }
\ No newline at end of file
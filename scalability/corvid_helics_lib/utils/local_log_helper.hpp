@@ -1,15 +1,37 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <ios>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <functional>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 
+#include "mpsc_queue.hpp"
+
 namespace utils
 {
+
+/**
+ * In async mode every log statement is formatted into its own buffer, taken from a pool owned by the calling
+ * thread, and queued when the statement ends. A background thread concatenates queued statements and writes them to the file and the callback
+ * once max_batch_bytes have built up or max_batch_delay_ms has passed, so the callback sees a few large messages
+ * instead of one per statement.
+ */
+struct AsyncLogOptions
+{
+    bool enabled{};
+    std::size_t max_batch_bytes{ 64 * 1024 };
+    double max_batch_delay_ms{ 50.0 };
+};
+
 class LocalLogHelper
 {
   private:
@@ -17,8 +39,23 @@ class LocalLogHelper
     std::stringstream m_formatting_stream{};
     std::function<void(const std::string &)> m_on_write;
 
+    // Async mode, the file and callback are only touched by m_writer while it runs, under m_sink_mutex
+    AsyncLogOptions m_async_options{};
+    MpscQueue<std::string> m_pending{};
+    std::atomic<std::size_t> m_pending_bytes{};
+    std::atomic<std::uint64_t> m_enqueued{};
+    std::uint64_t m_written{};
+    std::uint64_t m_batches{};
+    std::atomic<bool> m_is_flush_requested{};
+    std::atomic<bool> m_is_stopping{};
+    std::mutex m_sink_mutex;
+    std::condition_variable m_written_cv;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    std::thread m_writer;
+
     /**
-     * Appends data to both the file (if open) and internal buffer.
+     * Appends data to both the file (if open) and internal buffer. Async statements format into their own buffer.
      * Must remain in header because it is a template.
      */
     template <typename T> void Append(const T &msg)
@@ -30,14 +67,35 @@ class LocalLogHelper
     void AppendManip(std::ostream &(*manip)(std::ostream &));
     void FlushToCallback();
 
+    /**
+     * Formatting buffers of the calling thread. Each async statement holds one until it ends, so a statement logged
+     * while another is still being built, to this logger or any other, gets a buffer of its own.
+     */
+    static std::ostringstream *AcquireThreadBuffer();
+    static void ReleaseThreadBuffer(std::ostringstream *buffer);
+    void Enqueue(std::string &&text);
+    void WriterLoop();
+    void WriteBatch(const std::string &batch, std::uint64_t statements);
+
   public:
-    LocalLogHelper(const std::string &output_file);
+    LocalLogHelper(const std::string &output_file, const AsyncLogOptions &async_options = {});
     ~LocalLogHelper();
 
     bool IsOpen() const;
+    bool IsAsync() const { return m_async_options.enabled; }
     void SetOnWriteCallback(std::function<void(const std::string &)> on_write);
     void SetOutputFile(const std::string &output_file);
 
+    /**
+     * @brief Blocks until every statement logged before the call has reached the file and the callback.
+     */
+    void Flush();
+
+    /**
+     * @brief Number of writes made to the file and callback in async mode.
+     */
+    std::uint64_t GetBatchCount();
+
     using StreamManipulator = std::ostream &(*)(std::ostream &);
 
     // --- PROXY CLASS DEFINITION ---
@@ -45,6 +103,7 @@ class LocalLogHelper
     {
       private:
         LocalLogHelper &m_parent;
+        std::ostringstream *m_buffer{}; // async mode only
         bool m_should_flush{};
 
       public:
@@ -61,7 +120,14 @@ class LocalLogHelper
          */
         template <typename T> LogStream &operator<<(const T &msg)
         {
-            m_parent.Append(msg);
+            if (m_buffer)
+            {
+                *m_buffer << msg;
+            }
+            else
+            {
+                m_parent.Append(msg);
+            }
             return *this;
         }
 
@@ -0,0 +1,67 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace
+{
+
+std::error_code LastError()
+{
+    return std::error_code(errno, std::generic_category());
+}
+
+} // namespace
+
+std::unique_ptr<utils::MappedFile> utils::MappedFile::Open(const std::string &path, std::error_code &ec)
+{
+    ec.clear();
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ec = LastError();
+        return nullptr;
+    }
+
+    struct stat file_stat
+    {
+    };
+    if (fstat(fd, &file_stat) != 0)
+    {
+        ec = LastError();
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<utils::MappedFile> file(new utils::MappedFile());
+    file->m_size = static_cast<std::size_t>(file_stat.st_size);
+    if (file->m_size > 0)
+    {
+        void *mapping = mmap(nullptr, file->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ec = LastError();
+            close(fd);
+            return nullptr;
+        }
+        // The parser reads front to back exactly once
+        madvise(mapping, file->m_size, MADV_SEQUENTIAL);
+        file->m_mapping = mapping;
+    }
+
+    // The mapping keeps the file contents reachable, the descriptor is no longer needed
+    close(fd);
+    return file;
+}
+
+utils::MappedFile::~MappedFile()
+{
+    if (m_mapping != nullptr)
+    {
+        munmap(m_mapping, m_size);
+    }
+}
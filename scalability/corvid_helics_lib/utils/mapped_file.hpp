@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace utils
+{
+
+/**
+ * Read only view of a whole file mapped into memory, for parsing large configs without copying them into a string
+ * first. The pages are read in by the kernel as the parser walks them.
+ */
+class MappedFile
+{
+  private:
+    void *m_mapping{};
+    std::size_t m_size{};
+
+    MappedFile() = default;
+
+  public:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /**
+     * @return nullptr with ec set if the file could not be opened or mapped. An empty file maps to an empty view.
+     */
+    static std::unique_ptr<MappedFile> Open(const std::string &path, std::error_code &ec);
+
+    std::string_view GetView() const { return { static_cast<const char *>(m_mapping), m_size }; }
+    std::size_t GetSize() const { return m_size; }
+};
+
+} // namespace utils
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace utils
+{
+
+/**
+ * HIGH messages (errors, command acknowledgements) go out ahead of BULK ones where the transport can reorder.
+ */
+enum class SendPriority
+{
+    HIGH,
+    BULK
+};
+
+/**
+ * What a federate needs from a telemetry transport, so the same logging and metrics code can feed a WebSocketClient
+ * or a shared memory ring. Send carries text, SendBinary carries encoded frames such as a TelemetryFrame. Both return
+ * false when the transport dropped the message instead of queueing it.
+ */
+class MessageSink
+{
+  public:
+    virtual ~MessageSink() = default;
+
+    virtual bool Send(std::shared_ptr<const std::string> message, SendPriority priority) = 0;
+    virtual bool SendBinary(std::shared_ptr<const std::string> message, SendPriority priority) = 0;
+};
+
+} // namespace utils
@@ -0,0 +1,259 @@
+#include "metrics_registry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+/**
+ * Lock free add for the atomic doubles, fetch_add on floating point atomics only arrives in C++20.
+ */
+void AtomicAdd(std::atomic<double> &target, double amount)
+{
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + amount, std::memory_order_relaxed))
+    {
+    }
+}
+
+std::string FormatValue(double value)
+{
+    if (std::isnan(value)) return "NaN";
+    if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+
+    // 15 digits reads back exactly for most values and keeps bounds like 0.1 short, fall back to full precision
+    std::ostringstream ss;
+    ss << std::setprecision(std::numeric_limits<double>::digits10) << value;
+    if (std::strtod(ss.str().c_str(), nullptr) != value)
+    {
+        ss.str("");
+        ss << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    }
+    return ss.str();
+}
+
+std::string EscapeLabelValue(const std::string &value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (c == '\n')
+        {
+            escaped += "\\n";
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * The collectors get their own lock so ClearCollectors waits for a render that is still running them.
+ */
+std::mutex &GetCollectorMutex()
+{
+    static std::mutex collector_mutex;
+    return collector_mutex;
+}
+
+} // namespace
+
+// ###################################
+// Counter, Gauge and Histogram Implementation
+// ###################################
+
+void utils::Counter::Advance(std::uint64_t total)
+{
+    std::uint64_t current = m_value.load(std::memory_order_relaxed);
+    while (current < total && !m_value.compare_exchange_weak(current, total, std::memory_order_relaxed))
+    {
+    }
+}
+
+void utils::Gauge::Add(double amount)
+{
+    AtomicAdd(m_value, amount);
+}
+
+utils::Histogram::Histogram(std::vector<double> bounds)
+    : m_bounds(std::move(bounds)), m_buckets(std::make_unique<std::atomic<std::uint64_t>[]>(m_bounds.size() + 1))
+{
+    std::sort(m_bounds.begin(), m_bounds.end());
+    for (std::size_t i = 0; i <= m_bounds.size(); i++)
+    {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void utils::Histogram::Observe(double value)
+{
+    const std::size_t index =
+        static_cast<std::size_t>(std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin());
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    AtomicAdd(m_sum, value);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ###################################
+// MetricsRegistry Implementation
+// ###################################
+
+utils::MetricsRegistry &utils::MetricsRegistry::Get()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+utils::MetricsRegistry::Metric &utils::MetricsRegistry::GetMetric(const std::string &name, const std::string &help,
+                                                                  utils::MetricsRegistry::Type type)
+{
+    std::string key = name;
+    auto found = m_metrics.find(key);
+    if (found != m_metrics.end() && found->second.type != type)
+    {
+        // Keep both rather than fail, the clash shows up in the scrape under the suffixed name
+        key += type == Type::COUNTER ? "_counter" : type == Type::GAUGE ? "_gauge" : "_histogram";
+        found = m_metrics.find(key);
+    }
+    if (found != m_metrics.end())
+    {
+        return found->second;
+    }
+
+    Metric &metric = m_metrics[key];
+    metric.type = type;
+    metric.help = help;
+    return metric;
+}
+
+utils::Counter &utils::MetricsRegistry::GetCounter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Metric &metric = GetMetric(name, help, Type::COUNTER);
+    if (!metric.counter)
+    {
+        metric.counter = std::make_unique<Counter>();
+    }
+    return *metric.counter;
+}
+
+utils::Gauge &utils::MetricsRegistry::GetGauge(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Metric &metric = GetMetric(name, help, Type::GAUGE);
+    if (!metric.gauge)
+    {
+        metric.gauge = std::make_unique<Gauge>();
+    }
+    return *metric.gauge;
+}
+
+utils::Histogram &utils::MetricsRegistry::GetHistogram(const std::string &name, const std::string &help,
+                                                       const std::vector<double> &bounds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Metric &metric = GetMetric(name, help, Type::HISTOGRAM);
+    if (!metric.histogram)
+    {
+        metric.histogram = std::make_unique<Histogram>(bounds.empty() ? GetDefaultMillisecondBounds() : bounds);
+    }
+    return *metric.histogram;
+}
+
+void utils::MetricsRegistry::SetConstantLabels(const std::vector<std::pair<std::string, std::string>> &labels)
+{
+    std::string rendered;
+    for (const auto &[name, value] : labels)
+    {
+        rendered += (rendered.empty() ? "" : ",") + name + "=\"" + EscapeLabelValue(value) + "\"";
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_labels = std::move(rendered);
+}
+
+void utils::MetricsRegistry::AddCollector(std::function<void()> collector)
+{
+    std::lock_guard<std::mutex> collector_lock(GetCollectorMutex());
+    m_collectors.push_back(std::move(collector));
+}
+
+void utils::MetricsRegistry::ClearCollectors()
+{
+    std::lock_guard<std::mutex> collector_lock(GetCollectorMutex());
+    m_collectors.clear();
+}
+
+std::string utils::MetricsRegistry::Render()
+{
+    {
+        // Collectors look gauges up, so they run before m_mutex is taken
+        std::lock_guard<std::mutex> collector_lock(GetCollectorMutex());
+        for (const std::function<void()> &collector : m_collectors)
+        {
+            collector();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::string labels = m_labels.empty() ? "" : "{" + m_labels + "}";
+    const std::string label_prefix = m_labels.empty() ? "" : m_labels + ",";
+
+    std::ostringstream ss;
+    for (const auto &[name, metric] : m_metrics)
+    {
+        ss << "# HELP " << name << " " << metric.help << "\n";
+        switch (metric.type)
+        {
+        case Type::COUNTER:
+            ss << "# TYPE " << name << " counter\n" << name << labels << " " << metric.counter->Get() << "\n";
+            break;
+        case Type::GAUGE:
+            ss << "# TYPE " << name << " gauge\n" << name << labels << " " << FormatValue(metric.gauge->Get())
+               << "\n";
+            break;
+        case Type::HISTOGRAM:
+        {
+            const Histogram &histogram = *metric.histogram;
+            ss << "# TYPE " << name << " histogram\n";
+
+            // The buckets are read one at a time while observers keep adding, so the total is summed from them
+            // rather than read from the count to keep the +Inf bucket and _count equal
+            std::uint64_t cumulative = 0;
+            const std::vector<double> &bounds = histogram.GetBounds();
+            for (std::size_t i = 0; i < bounds.size(); i++)
+            {
+                cumulative += histogram.GetBucketCount(i);
+                ss << name << "_bucket{" << label_prefix << "le=\"" << FormatValue(bounds[i]) << "\"} " << cumulative
+                   << "\n";
+            }
+            cumulative += histogram.GetBucketCount(bounds.size());
+            ss << name << "_bucket{" << label_prefix << "le=\"+Inf\"} " << cumulative << "\n";
+            ss << name << "_sum" << labels << " " << FormatValue(histogram.GetSum()) << "\n";
+            ss << name << "_count" << labels << " " << cumulative << "\n";
+            break;
+        }
+        }
+    }
+
+    return ss.str();
+}
+
+std::vector<double> utils::MetricsRegistry::GetDefaultMillisecondBounds()
+{
+    return { 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0, 50.0, 100.0, 250.0, 500.0, 1000.0, 2500.0, 5000.0, 10000.0 };
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * Monotonic count, e.g. messages sent. Rates are left to the scraper (Prometheus rate()).
+ */
+class Counter
+{
+  private:
+    std::atomic<std::uint64_t> m_value{};
+
+  public:
+    void Increment(std::uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+
+    /**
+     * @brief Mirrors a total counted elsewhere, e.g. SendStats in a collector. Never moves the counter backwards.
+     */
+    void Advance(std::uint64_t total);
+    std::uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Value that goes up and down, e.g. a queue depth or the last granted time.
+ */
+class Gauge
+{
+  private:
+    std::atomic<double> m_value{};
+
+  public:
+    void Set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(double amount);
+    double Get() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Fixed bucket histogram in the Prometheus layout, every bucket counts the observations at or below its bound.
+ * Observing is lock free so the federate loops can record into it while the server renders.
+ */
+class Histogram
+{
+  private:
+    std::vector<double> m_bounds;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_buckets;
+    std::atomic<std::uint64_t> m_count{};
+    std::atomic<double> m_sum{};
+
+  public:
+    /**
+     * @param bounds bucket upper bounds, sorted here. The +Inf bucket is implied.
+     */
+    explicit Histogram(std::vector<double> bounds);
+
+    void Observe(double value);
+
+    const std::vector<double> &GetBounds() const { return m_bounds; }
+    // Observations in the bucket alone, not cumulative. Index GetBounds().size() is the +Inf bucket.
+    std::uint64_t GetBucketCount(std::size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    std::uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+    double GetSum() const { return m_sum.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Process wide set of named metrics rendered in the Prometheus text exposition format. Metrics are created on first
+ * lookup and live as long as the process, so callers look them up once and keep the reference. Values that already
+ * live elsewhere (queue depths, send stats) are copied into gauges by collectors run just before each render.
+ */
+class MetricsRegistry
+{
+  private:
+    enum class Type
+    {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    struct Metric
+    {
+        Type type{};
+        std::string help{};
+        std::unique_ptr<Counter> counter{};
+        std::unique_ptr<Gauge> gauge{};
+        std::unique_ptr<Histogram> histogram{};
+    };
+
+    std::mutex m_mutex{};
+    std::map<std::string, Metric> m_metrics{};
+    std::vector<std::function<void()>> m_collectors{};
+    std::string m_labels{};
+
+    MetricsRegistry() = default;
+
+    Metric &GetMetric(const std::string &name, const std::string &help, Type type);
+
+  public:
+    static MetricsRegistry &Get();
+
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+    /**
+     * Looking a name up again returns the same metric. Names should follow the Prometheus rules,
+     * [a-zA-Z_:][a-zA-Z0-9_:]*, and a name already registered as another type gets the type appended rather than
+     * failing.
+     */
+    Counter &GetCounter(const std::string &name, const std::string &help);
+    Gauge &GetGauge(const std::string &name, const std::string &help);
+
+    /**
+     * @param bounds bucket upper bounds, only used when the histogram is created. Empty uses
+     *        GetDefaultMillisecondBounds.
+     */
+    Histogram &GetHistogram(const std::string &name, const std::string &help, const std::vector<double> &bounds = {});
+
+    /**
+     * @brief Labels added to every series, e.g. { { "federate", "gpk_118" }, { "rank", "0" } }.
+     */
+    void SetConstantLabels(const std::vector<std::pair<std::string, std::string>> &labels);
+
+    /**
+     * @brief Runs before every render, on the thread rendering. Must stay valid for the life of the process or until
+     *        ClearCollectors.
+     */
+    void AddCollector(std::function<void()> collector);
+    void ClearCollectors();
+
+    std::string Render();
+
+    /**
+     * @brief 0.1 ms to 10 s, roughly three buckets per decade.
+     */
+    static std::vector<double> GetDefaultMillisecondBounds();
+};
+
+} // namespace utils
@@ -0,0 +1,176 @@
+#include "metrics_server.hpp"
+
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <memory>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = boost::asio::ip::tcp;
+
+namespace
+{
+
+// A scraper that stalls mid request is dropped rather than holding the connection
+constexpr std::chrono::seconds SESSION_TIMEOUT{ 5 };
+
+/**
+ * One request and response per connection, Prometheus reconnects per scrape anyway.
+ */
+class MetricsSession : public std::enable_shared_from_this<MetricsSession>
+{
+  private:
+    beast::tcp_stream m_stream;
+    beast::flat_buffer m_buffer{};
+    http::request<http::string_body> m_request{};
+    http::response<http::string_body> m_response{};
+    utils::MetricsRegistry &m_registry;
+    std::atomic<std::uint64_t> &m_scrapes;
+
+    void OnRead(beast::error_code ec)
+    {
+        if (ec)
+        {
+            return;
+        }
+
+        m_response.version(m_request.version());
+        m_response.keep_alive(false);
+        m_response.set(http::field::server, "corvid-metrics");
+
+        const bool is_metrics = m_request.target() == "/metrics";
+        if (m_request.method() != http::verb::get)
+        {
+            m_response.result(http::status::method_not_allowed);
+            m_response.set(http::field::content_type, "text/plain");
+            m_response.body() = "Only GET is supported\n";
+        }
+        else if (!is_metrics)
+        {
+            m_response.result(http::status::not_found);
+            m_response.set(http::field::content_type, "text/plain");
+            m_response.body() = "Metrics are served at /metrics\n";
+        }
+        else
+        {
+            m_response.result(http::status::ok);
+            m_response.set(http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+            m_response.body() = m_registry.Render();
+            m_scrapes.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_response.prepare_payload();
+
+        http::async_write(m_stream, m_response,
+                          [self = shared_from_this()](beast::error_code write_ec, std::size_t)
+                          {
+                              beast::error_code close_ec;
+                              self->m_stream.socket().shutdown(tcp::socket::shutdown_send, close_ec);
+                              (void)write_ec;
+                          });
+    }
+
+  public:
+    MetricsSession(tcp::socket &&socket, utils::MetricsRegistry &registry, std::atomic<std::uint64_t> &scrapes)
+        : m_stream(std::move(socket)), m_registry(registry), m_scrapes(scrapes)
+    {
+    }
+
+    void Run()
+    {
+        m_stream.expires_after(SESSION_TIMEOUT);
+        http::async_read(m_stream, m_buffer, m_request,
+                         [self = shared_from_this()](beast::error_code ec, std::size_t) { self->OnRead(ec); });
+    }
+};
+
+} // namespace
+
+utils::MetricsServer::MetricsServer(utils::MetricsRegistry &registry)
+    : m_registry(registry), m_acceptor(m_ioc), m_retry_timer(m_ioc)
+{
+}
+
+utils::MetricsServer::~MetricsServer()
+{
+    Stop();
+}
+
+bool utils::MetricsServer::Start(const std::string &address, unsigned short port, boost::system::error_code &ec)
+{
+    if (m_io_thread.joinable())
+    {
+        ec = boost::asio::error::already_started;
+        return false;
+    }
+
+    const boost::asio::ip::address bind_address = boost::asio::ip::make_address(address, ec);
+    if (ec) return false;
+
+    const tcp::endpoint endpoint(bind_address, port);
+    m_acceptor.open(endpoint.protocol(), ec);
+    if (ec) return false;
+    m_acceptor.set_option(boost::asio::socket_base::reuse_address(true), ec);
+    if (ec) return false;
+    m_acceptor.bind(endpoint, ec);
+    if (ec) return false;
+    m_acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+    if (ec) return false;
+
+    DoAccept();
+    m_io_thread = std::thread([this]() { m_ioc.run(); });
+    return true;
+}
+
+void utils::MetricsServer::Stop()
+{
+    if (!m_io_thread.joinable())
+    {
+        return;
+    }
+
+    // The acceptor belongs to the io thread, close it there so the pending accept completes before the stop
+    boost::asio::post(m_ioc,
+                      [this]()
+                      {
+                          boost::system::error_code ec;
+                          m_acceptor.close(ec);
+                          m_retry_timer.cancel();
+                          m_ioc.stop();
+                      });
+    m_io_thread.join();
+}
+
+unsigned short utils::MetricsServer::GetPort() const
+{
+    boost::system::error_code ec;
+    const tcp::endpoint endpoint = m_acceptor.local_endpoint(ec);
+    return ec ? 0 : endpoint.port();
+}
+
+void utils::MetricsServer::DoAccept()
+{
+    m_acceptor.async_accept(
+        [this](boost::system::error_code ec, tcp::socket socket)
+        {
+            if (ec)
+            {
+                // operation_aborted once Stop closes the acceptor. Anything else, e.g. EMFILE, is retried after a
+                // pause, retrying at once would spin for as long as the error lasts.
+                if (ec == boost::asio::error::operation_aborted) return;
+
+                m_retry_timer.expires_after(std::chrono::milliseconds(100));
+                m_retry_timer.async_wait(
+                    [this](boost::system::error_code wait_ec)
+                    {
+                        if (!wait_ec) DoAccept();
+                    });
+                return;
+            }
+
+            std::make_shared<MetricsSession>(std::move(socket), m_registry, m_scrapes)->Run();
+            DoAccept();
+        });
+}
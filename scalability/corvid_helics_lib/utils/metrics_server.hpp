@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "metrics_registry.hpp"
+
+namespace utils
+{
+
+/**
+ * Minimal HTTP server for Prometheus scrapes, GET /metrics returns the registry in the text exposition format and
+ * anything else gets a 404. It runs on its own thread and io_context so a slow scraper never touches the federate's
+ * WebSocket or HELICS threads, and renders once per request so an idle server costs nothing.
+ */
+class MetricsServer
+{
+  private:
+    MetricsRegistry &m_registry;
+    boost::asio::io_context m_ioc{ 1 };
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    boost::asio::steady_timer m_retry_timer; // backs off a failed accept, e.g. out of file descriptors
+    std::thread m_io_thread{};
+    std::atomic<std::uint64_t> m_scrapes{};
+
+    void DoAccept();
+
+  public:
+    explicit MetricsServer(MetricsRegistry &registry = MetricsRegistry::Get());
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    /**
+     * @brief Binds and starts serving on a background thread.
+     * @param port 0 picks a free port, see GetPort.
+     * @return false with ec set if the address could not be bound.
+     */
+    bool Start(const std::string &address, unsigned short port, boost::system::error_code &ec);
+
+    /**
+     * @brief Closes the listener and joins the thread. Called by the destructor.
+     */
+    void Stop();
+
+    unsigned short GetPort() const;
+    std::uint64_t GetScrapeCount() const { return m_scrapes.load(std::memory_order_relaxed); }
+};
+
+} // namespace utils
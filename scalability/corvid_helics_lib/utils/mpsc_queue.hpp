@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace utils
+{
+
+/**
+ * Unbounded multiple producer, single consumer queue. Push is wait free, one exchange and one store, so producers
+ * never contend on a lock. Only one thread may call TryPop.
+ *
+ * A push that has exchanged the head but not yet linked its node is invisible to TryPop until the link lands, the
+ * consumer simply sees the queue as empty for that moment and picks the value up on its next pass.
+ */
+template <typename T> class MpscQueue
+{
+  private:
+    struct Node
+    {
+        std::atomic<Node *> next{};
+        T value{};
+    };
+
+    // Producers swap themselves in at the head, the consumer owns the tail which always points at a spent node
+    std::atomic<Node *> m_head;
+    Node *m_tail;
+
+  public:
+    MpscQueue() : m_head(new Node()), m_tail(m_head.load(std::memory_order_relaxed)) {}
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    ~MpscQueue()
+    {
+        while (m_tail != nullptr)
+        {
+            Node *next = m_tail->next.load(std::memory_order_relaxed);
+            delete m_tail;
+            m_tail = next;
+        }
+    }
+
+    void Push(T value)
+    {
+        Node *node = new Node();
+        node->value = std::move(value);
+
+        Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool TryPop(T &value)
+    {
+        Node *next = m_tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+
+        value = std::move(next->value);
+        delete m_tail;
+        m_tail = next;
+        return true;
+    }
+};
+
+} // namespace utils
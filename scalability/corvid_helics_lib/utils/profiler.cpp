@@ -0,0 +1,290 @@
+#include "profiler.hpp"
+#include "json_escape.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+// ###################################
+// ThreadProfile Definition
+// ###################################
+
+namespace utils
+{
+
+/**
+ * Zone tree for a single thread. Node 0 is the root, every other node is one zone reached through a particular chain
+ * of parents, so the same zone called from two places gets two nodes.
+ */
+class ThreadProfile
+{
+  public:
+    struct Node
+    {
+        std::uint32_t zone_id{};
+        std::size_t parent{};
+        std::vector<std::size_t> children{};
+        LatencyHistogram histogram{};
+    };
+
+    std::vector<Node> nodes{ 1 };
+    std::size_t current{};
+
+    void Enter(std::uint32_t zone_id)
+    {
+        for (const std::size_t child : nodes[current].children)
+        {
+            if (nodes[child].zone_id == zone_id)
+            {
+                current = child;
+                return;
+            }
+        }
+
+        const std::size_t child = nodes.size();
+        nodes.emplace_back();
+        nodes[child].zone_id = zone_id;
+        nodes[child].parent = current;
+        nodes[current].children.push_back(child);
+        current = child;
+    }
+
+    void Exit(std::uint64_t elapsed_ns)
+    {
+        nodes[current].histogram.Record(elapsed_ns);
+        current = nodes[current].parent;
+    }
+};
+
+} // namespace utils
+
+namespace
+{
+
+// Sorts below every printable character so sorting full paths gives depth first order
+constexpr char PATH_SEPARATOR = '\x01';
+
+std::string DisplayPath(std::string path)
+{
+    std::replace(path.begin(), path.end(), PATH_SEPARATOR, '/');
+    return path;
+}
+
+double ToMicroseconds(std::uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+} // namespace
+
+// ###################################
+// Profiler Implementation
+// ###################################
+
+utils::Profiler &utils::Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+std::uint32_t utils::Profiler::RegisterZone(utils::ProfileZone &zone)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have registered the zone while we waited
+    std::uint32_t id = zone.id.load(std::memory_order_acquire);
+    if (id != 0)
+    {
+        return id;
+    }
+
+    // Index 0 is unused so a zone id of 0 can mean unregistered
+    if (m_zone_names.empty())
+    {
+        m_zone_names.emplace_back();
+    }
+    id = static_cast<std::uint32_t>(m_zone_names.size());
+    m_zone_names.emplace_back(zone.name != nullptr ? zone.name : "");
+    zone.id.store(id, std::memory_order_release);
+    return id;
+}
+
+utils::ThreadProfile &utils::Profiler::GetThreadProfile()
+{
+    thread_local ThreadProfile *thread_profile = nullptr;
+    if (thread_profile == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.push_back(std::make_unique<ThreadProfile>());
+        thread_profile = m_threads.back().get();
+    }
+    return *thread_profile;
+}
+
+std::vector<utils::Profiler::ZoneReport> utils::Profiler::MergeThreads()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::string, ZoneReport> merged;
+    for (const std::unique_ptr<ThreadProfile> &thread : m_threads)
+    {
+        // Parents always precede their children so their paths are already built
+        std::vector<std::string> paths(thread->nodes.size());
+        for (std::size_t i = 1; i < thread->nodes.size(); i++)
+        {
+            const ThreadProfile::Node &node = thread->nodes[i];
+            const std::string &name = m_zone_names[node.zone_id];
+            paths[i] = node.parent == 0 ? name : paths[node.parent] + PATH_SEPARATOR + name;
+
+            ZoneReport &report = merged[paths[i]];
+            report.path = paths[i];
+            report.name = name;
+            report.depth = static_cast<std::size_t>(std::count(paths[i].begin(), paths[i].end(), PATH_SEPARATOR));
+            report.histogram.Merge(node.histogram);
+        }
+    }
+
+    std::vector<ZoneReport> reports;
+    reports.reserve(merged.size());
+    for (auto &[path, report] : merged)
+    {
+        reports.push_back(std::move(report));
+    }
+    return reports;
+}
+
+std::string utils::Profiler::GetSummaryTable()
+{
+    const std::vector<ZoneReport> reports = MergeThreads();
+
+    std::size_t name_width = 4;
+    for (const ZoneReport &report : reports)
+    {
+        name_width = std::max(name_width, report.depth * 2 + report.name.size());
+    }
+
+    std::stringstream ss;
+    ss << std::left << std::setw(static_cast<int>(name_width)) << "Zone" << std::right << std::setw(10) << "Calls"
+       << std::setw(14) << "Total (ms)" << std::setw(12) << "Mean (us)" << std::setw(12) << "p50 (us)"
+       << std::setw(12) << "p99 (us)" << std::setw(12) << "Max (us)" << "\n";
+
+    ss << std::fixed << std::setprecision(1);
+    for (const ZoneReport &report : reports)
+    {
+        const LatencyHistogram &histogram = report.histogram;
+        ss << std::left << std::setw(static_cast<int>(name_width)) << std::string(report.depth * 2, ' ') + report.name
+           << std::right << std::setw(10) << histogram.GetCount() << std::setw(14) << histogram.GetSum() / 1e6
+           << std::setw(12) << histogram.GetMean() / 1e3 << std::setw(12)
+           << ToMicroseconds(histogram.GetPercentile(50.0)) << std::setw(12)
+           << ToMicroseconds(histogram.GetPercentile(99.0)) << std::setw(12) << ToMicroseconds(histogram.GetMax())
+           << "\n";
+    }
+
+    return ss.str();
+}
+
+std::string utils::Profiler::GetJson()
+{
+    const std::vector<ZoneReport> reports = MergeThreads();
+
+    std::size_t thread_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        thread_count = m_threads.size();
+    }
+
+    std::stringstream ss;
+    ss << "{\"threads\":" << thread_count << ",\"zones\":[";
+    for (std::size_t i = 0; i < reports.size(); i++)
+    {
+        const LatencyHistogram &histogram = reports[i].histogram;
+        ss << (i > 0 ? "," : "") << "\n{\"path\":\"" << EscapeJson(DisplayPath(reports[i].path)) << "\",\"name\":\""
+           << EscapeJson(reports[i].name) << "\",\"depth\":" << reports[i].depth
+           << ",\"calls\":" << histogram.GetCount() << ",\"total_ms\":" << histogram.GetSum() / 1e6
+           << ",\"mean_us\":" << histogram.GetMean() / 1e3 << ",\"min_us\":" << ToMicroseconds(histogram.GetMin())
+           << ",\"p50_us\":" << ToMicroseconds(histogram.GetPercentile(50.0))
+           << ",\"p90_us\":" << ToMicroseconds(histogram.GetPercentile(90.0))
+           << ",\"p99_us\":" << ToMicroseconds(histogram.GetPercentile(99.0))
+           << ",\"p999_us\":" << ToMicroseconds(histogram.GetPercentile(99.9))
+           << ",\"max_us\":" << ToMicroseconds(histogram.GetMax()) << "}";
+    }
+    ss << "\n]}\n";
+
+    return ss.str();
+}
+
+bool utils::Profiler::WriteJson(const std::string &output_file)
+{
+    std::ofstream output_stream(output_file, std::ios::trunc);
+    if (!output_stream.is_open())
+    {
+        return false;
+    }
+
+    output_stream << GetJson();
+    return static_cast<bool>(output_stream);
+}
+
+// ###################################
+// ProfileScope Implementation
+// ###################################
+
+utils::ProfileScope::ProfileScope(utils::ProfileZone &zone)
+    : m_thread(utils::Profiler::Get().GetThreadProfile()), m_name(zone.name),
+      m_trace_writer(utils::Profiler::Get().GetTraceWriter())
+{
+    std::uint32_t id = zone.id.load(std::memory_order_acquire);
+    if (id == 0)
+    {
+        id = utils::Profiler::Get().RegisterZone(zone);
+    }
+    m_thread.Enter(id);
+
+    // Last so the bookkeeping above is not counted
+    m_start_time = std::chrono::steady_clock::now();
+}
+
+utils::ProfileScope::~ProfileScope()
+{
+    Stop();
+}
+
+double utils::ProfileScope::ElapsedMilliseconds() const
+{
+    if (m_is_stopped)
+    {
+        return m_stopped_ms;
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start_time;
+    return elapsed.count();
+}
+
+void utils::ProfileScope::SetLabel(std::string label)
+{
+    if (IsTracing())
+    {
+        m_label = std::move(label);
+    }
+}
+
+double utils::ProfileScope::Stop()
+{
+    if (m_is_stopped)
+    {
+        return m_stopped_ms;
+    }
+
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - m_start_time;
+    m_thread.Exit(static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(0, elapsed.count())));
+    if (m_trace_writer != nullptr)
+    {
+        m_trace_writer->AddComplete(m_name, m_start_time, elapsed, m_label);
+    }
+
+    m_is_stopped = true;
+    m_stopped_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    return m_stopped_ms;
+}
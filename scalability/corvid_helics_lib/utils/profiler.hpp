@@ -0,0 +1,145 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include "trace_writer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define CORVID_PROFILE_CONCAT_INNER(a, b) a##b
+#define CORVID_PROFILE_CONCAT(a, b) CORVID_PROFILE_CONCAT_INNER(a, b)
+
+/**
+ * Times the rest of the enclosing scope as a zone nested under whichever zone is open on this thread, e.g.
+ *
+ *   CORVID_PROFILE_ZONE("publish_voltages");
+ */
+#define CORVID_PROFILE_ZONE(name)                                                                                    \
+    static ::utils::ProfileZone CORVID_PROFILE_CONCAT(corvid_profile_zone_, __LINE__){ name };                       \
+    ::utils::ProfileScope CORVID_PROFILE_CONCAT(corvid_profile_scope_, __LINE__)(                                    \
+        CORVID_PROFILE_CONCAT(corvid_profile_zone_, __LINE__))
+
+/**
+ * Same as CORVID_PROFILE_ZONE but names the scope so the caller can read or stop it early, e.g.
+ *
+ *   CORVID_PROFILE_SCOPE(grant_scope, "request_time");
+ *   granted_time = fed.requestTime(next_time);
+ *   const double grant_wait_ms = grant_scope.Stop();
+ */
+#define CORVID_PROFILE_SCOPE(variable, name)                                                                         \
+    static ::utils::ProfileZone CORVID_PROFILE_CONCAT(variable, _zone){ name };                                      \
+    ::utils::ProfileScope variable(CORVID_PROFILE_CONCAT(variable, _zone))
+
+namespace utils
+{
+
+/**
+ * One per zone declaration, the id is assigned the first time the zone is entered.
+ */
+struct ProfileZone
+{
+    const char *name;
+    std::atomic<std::uint32_t> id{};
+
+    explicit ProfileZone(const char *zone_name) : name(zone_name) {}
+};
+
+class ThreadProfile;
+
+/**
+ * Process wide zone registry and report. Each thread records into its own tree of zones so entering and leaving a
+ * zone takes no lock, the trees are merged by zone path when a report is made. Reports read the other threads'
+ * trees unsynchronised, make them once the profiled threads are idle or finished, e.g. at exit.
+ */
+class Profiler
+{
+  private:
+    std::mutex m_mutex{};
+    std::vector<std::string> m_zone_names{};
+    std::vector<std::unique_ptr<ThreadProfile>> m_threads{};
+    std::atomic<TraceWriter *> m_trace_writer{};
+
+    Profiler() = default;
+
+    struct ZoneReport
+    {
+        std::string path{};
+        std::string name{};
+        std::size_t depth{};
+        LatencyHistogram histogram{};
+    };
+    std::vector<ZoneReport> MergeThreads();
+
+  public:
+    static Profiler &Get();
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    std::uint32_t RegisterZone(ProfileZone &zone);
+
+    /**
+     * @brief Also writes every zone entered from now on as a trace event, nullptr stops. The writer must outlive
+     *        any scope opened while it was set.
+     */
+    void SetTraceWriter(TraceWriter *trace_writer) { m_trace_writer.store(trace_writer, std::memory_order_release); }
+    TraceWriter *GetTraceWriter() const { return m_trace_writer.load(std::memory_order_acquire); }
+
+    /**
+     * @brief The calling thread's zone tree, created on first use and owned by the profiler.
+     */
+    ThreadProfile &GetThreadProfile();
+
+    /**
+     * @brief Fixed width table of every zone path with call count, total, mean, p50, p99 and max.
+     */
+    std::string GetSummaryTable();
+    std::string GetJson();
+    bool WriteJson(const std::string &output_file);
+};
+
+/**
+ * RAII timer for one entry into a zone, use CORVID_PROFILE_ZONE or CORVID_PROFILE_SCOPE. Scopes on a thread must be
+ * stopped in reverse order of creation, which the destructor does on its own.
+ */
+class ProfileScope
+{
+  private:
+    ThreadProfile &m_thread;
+    const char *m_name;
+    TraceWriter *m_trace_writer;
+    std::string m_label{};
+    std::chrono::steady_clock::time_point m_start_time;
+    bool m_is_stopped{};
+    double m_stopped_ms{};
+
+  public:
+    explicit ProfileScope(ProfileZone &zone);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+    double ElapsedMilliseconds() const;
+
+    bool IsTracing() const { return m_trace_writer != nullptr; }
+
+    /**
+     * @brief Detail for the trace event, such as the query or bus the zone ran for. Ignored when not tracing, check
+     *        IsTracing first if the label is costly to build.
+     */
+    void SetLabel(std::string label);
+
+    /**
+     * @brief Records the zone now instead of at the end of the scope.
+     * @return the elapsed time in milliseconds, later calls return the same value without recording again.
+     */
+    double Stop();
+};
+
+} // namespace utils
@@ -0,0 +1,394 @@
+#include "shm_ring.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <new>
+
+namespace
+{
+
+constexpr std::size_t RECORD_ALIGNMENT = 8;
+constexpr std::size_t RECORD_HEADER_BYTES = 2 * sizeof(std::uint32_t);
+constexpr std::size_t MIN_CAPACITY = 4096;
+
+// Keep the record area on its own cache line after the header
+constexpr std::size_t RECORD_OFFSET = (sizeof(utils::ShmRingHeader) + 63) & ~std::size_t{ 63 };
+
+std::string GetObjectName(const std::string &name)
+{
+    return !name.empty() && name.front() == '/' ? name : "/" + name;
+}
+
+std::size_t AlignRecord(std::size_t size)
+{
+    return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+std::size_t RoundUpPowerOfTwo(std::size_t value)
+{
+    std::size_t result = MIN_CAPACITY;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::uint32_t GetFlags(bool is_binary, utils::SendPriority priority)
+{
+    std::uint32_t flags = 0;
+    if (is_binary) flags |= utils::ShmRingHeader::FLAG_BINARY;
+    if (priority == utils::SendPriority::HIGH) flags |= utils::ShmRingHeader::FLAG_HIGH_PRIORITY;
+    return flags;
+}
+
+std::error_code LastError()
+{
+    return std::error_code(errno, std::generic_category());
+}
+
+} // namespace
+
+// ###################################
+// ShmRingWriter Implementation
+// ###################################
+
+std::unique_ptr<utils::ShmRingWriter> utils::ShmRingWriter::Create(const std::string &name,
+                                                                   std::size_t capacity_bytes, std::error_code &ec,
+                                                                   bool replace_stale)
+{
+    ec.clear();
+    const std::string object_name = GetObjectName(name);
+    const std::size_t capacity = RoundUpPowerOfTwo(capacity_bytes);
+    const std::size_t mapping_bytes = RECORD_OFFSET + capacity;
+
+    // A reader may still have the stale object mapped, unlinking leaves it intact for them
+    if (replace_stale)
+    {
+        shm_unlink(object_name.c_str());
+    }
+
+    const int fd = shm_open(object_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        ec = LastError();
+        return nullptr;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(mapping_bytes)) != 0)
+    {
+        ec = LastError();
+        close(fd);
+        shm_unlink(object_name.c_str());
+        return nullptr;
+    }
+
+    void *mapping = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ec = LastError();
+        close(fd);
+        shm_unlink(object_name.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<utils::ShmRingWriter> writer(new utils::ShmRingWriter());
+    writer->m_name = object_name;
+    writer->m_fd = fd;
+    writer->m_mapping = mapping;
+    writer->m_mapping_bytes = mapping_bytes;
+    writer->m_header = new (mapping) utils::ShmRingHeader{};
+    writer->m_records = static_cast<char *>(mapping) + RECORD_OFFSET;
+
+    writer->m_header->version = utils::ShmRingHeader::VERSION;
+    writer->m_header->capacity = capacity;
+
+    // Readers check the magic before anything else, publish it last
+    writer->m_header->magic.store(utils::ShmRingHeader::MAGIC, std::memory_order_release);
+    return writer;
+}
+
+utils::ShmRingWriter::~ShmRingWriter()
+{
+    if (m_header != nullptr)
+    {
+        m_header->is_writer_closed.store(1, std::memory_order_release);
+        munmap(m_mapping, m_mapping_bytes);
+    }
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        shm_unlink(m_name.c_str());
+    }
+}
+
+bool utils::ShmRingWriter::Write(const void *data, std::size_t size, std::uint32_t flags)
+{
+    const std::uint64_t capacity = m_header->capacity;
+    const std::size_t record_bytes = AlignRecord(RECORD_HEADER_BYTES + size);
+
+    // Anything over half the ring could need the whole ring once a pad record is added, never let it in
+    if (record_bytes > capacity / 2)
+    {
+        m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    const std::uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+
+    const std::size_t offset = static_cast<std::size_t>(head & (capacity - 1));
+    const std::size_t contiguous = static_cast<std::size_t>(capacity) - offset;
+    const std::size_t needed = record_bytes + (contiguous < record_bytes ? contiguous : 0);
+    if (capacity - (head - tail) < needed)
+    {
+        m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (contiguous < record_bytes)
+    {
+        const std::uint32_t pad = utils::ShmRingHeader::PAD_RECORD;
+        std::memcpy(m_records + offset, &pad, sizeof(pad));
+        head += contiguous;
+    }
+
+    char *record = m_records + (head & (capacity - 1));
+    const std::uint32_t length = static_cast<std::uint32_t>(size);
+    std::memcpy(record, &length, sizeof(length));
+    std::memcpy(record + sizeof(length), &flags, sizeof(flags));
+    std::memcpy(record + RECORD_HEADER_BYTES, data, size);
+
+    m_header->head.store(head + record_bytes, std::memory_order_release);
+
+    m_sent_messages++;
+    m_sent_bytes += size;
+    return true;
+}
+
+bool utils::ShmRingWriter::Send(std::shared_ptr<const std::string> message, utils::SendPriority priority)
+{
+    return message && Write(message->data(), message->size(), GetFlags(false, priority));
+}
+
+bool utils::ShmRingWriter::SendBinary(std::shared_ptr<const std::string> message, utils::SendPriority priority)
+{
+    return message && Write(message->data(), message->size(), GetFlags(true, priority));
+}
+
+bool utils::ShmRingWriter::Send(const std::string &message, utils::SendPriority priority)
+{
+    return Write(message.data(), message.size(), GetFlags(false, priority));
+}
+
+bool utils::ShmRingWriter::SendBinary(const std::string &message, utils::SendPriority priority)
+{
+    return Write(message.data(), message.size(), GetFlags(true, priority));
+}
+
+std::uint64_t utils::ShmRingWriter::GetDroppedMessages() const
+{
+    return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+// ###################################
+// ShmRingReader Implementation
+// ###################################
+
+std::unique_ptr<utils::ShmRingReader> utils::ShmRingReader::Open(const std::string &name, std::error_code &ec)
+{
+    ec.clear();
+    const std::string object_name = GetObjectName(name);
+
+    const int fd = shm_open(object_name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        ec = LastError();
+        return nullptr;
+    }
+
+    struct stat status
+    {
+    };
+    if (fstat(fd, &status) != 0)
+    {
+        ec = LastError();
+        close(fd);
+        return nullptr;
+    }
+
+    const std::size_t mapping_bytes = static_cast<std::size_t>(status.st_size);
+    if (mapping_bytes < RECORD_OFFSET + MIN_CAPACITY)
+    {
+        // Either not a ring or the writer has not sized it yet
+        ec = std::make_error_code(std::errc::invalid_argument);
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping keeps the object alive, the descriptor is not needed past this point
+    void *mapping = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        ec = LastError();
+        return nullptr;
+    }
+
+    auto *header = static_cast<utils::ShmRingHeader *>(mapping);
+    if (header->magic.load(std::memory_order_acquire) != utils::ShmRingHeader::MAGIC ||
+        header->version != utils::ShmRingHeader::VERSION || header->capacity + RECORD_OFFSET != mapping_bytes)
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        munmap(mapping, mapping_bytes);
+        return nullptr;
+    }
+
+    std::unique_ptr<utils::ShmRingReader> reader(new utils::ShmRingReader());
+    reader->m_name = object_name;
+    reader->m_mapping = mapping;
+    reader->m_mapping_bytes = mapping_bytes;
+    reader->m_header = header;
+    reader->m_records = static_cast<const char *>(mapping) + RECORD_OFFSET;
+    return reader;
+}
+
+utils::ShmRingReader::~ShmRingReader()
+{
+    if (m_mapping != nullptr)
+    {
+        munmap(m_mapping, m_mapping_bytes);
+    }
+}
+
+std::size_t utils::ShmRingReader::Drain(const utils::ShmRingReader::Handler &handler, std::size_t max_messages)
+{
+    const std::uint64_t capacity = m_header->capacity;
+    std::uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    const std::uint64_t head = m_header->head.load(std::memory_order_acquire);
+
+    std::size_t handled = 0;
+    while (!m_is_corrupted && tail < head && handled < max_messages)
+    {
+        const std::size_t offset = static_cast<std::size_t>(tail & (capacity - 1));
+        const char *record = m_records + offset;
+
+        std::uint32_t length = 0;
+        std::memcpy(&length, record, sizeof(length));
+        if (length == utils::ShmRingHeader::PAD_RECORD)
+        {
+            tail += capacity - offset;
+            continue;
+        }
+
+        // The length comes from another process, never hand out bytes it did not write
+        const std::uint64_t record_bytes = AlignRecord(RECORD_HEADER_BYTES + static_cast<std::uint64_t>(length));
+        if (record_bytes > head - tail || offset + RECORD_HEADER_BYTES + length > capacity)
+        {
+            m_is_corrupted = true;
+            break;
+        }
+
+        std::uint32_t flags = 0;
+        std::memcpy(&flags, record + sizeof(length), sizeof(flags));
+        handler(record + RECORD_HEADER_BYTES, length, flags);
+
+        // Only give the space back once the handler is done with the pointer
+        tail += record_bytes;
+        m_header->tail.store(tail, std::memory_order_release);
+        handled++;
+    }
+
+    // Publish a trailing pad record skip as well
+    m_header->tail.store(tail, std::memory_order_release);
+    return handled;
+}
+
+bool utils::ShmRingReader::IsFinished() const
+{
+    if (m_is_corrupted)
+    {
+        return true;
+    }
+
+    // Check closed first, a writer cannot advance head after closing
+    return m_header->is_writer_closed.load(std::memory_order_acquire) != 0 &&
+           m_header->tail.load(std::memory_order_relaxed) == m_header->head.load(std::memory_order_acquire);
+}
+
+std::uint64_t utils::ShmRingReader::GetDroppedMessages() const
+{
+    return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+// ###################################
+// ShmCollector Implementation
+// ###################################
+
+bool utils::ShmCollector::AddRing(const std::string &name, std::error_code &ec)
+{
+    std::unique_ptr<utils::ShmRingReader> reader = utils::ShmRingReader::Open(name, ec);
+    if (!reader)
+    {
+        return false;
+    }
+
+    m_readers.push_back(std::move(reader));
+    return true;
+}
+
+std::size_t utils::ShmCollector::AddRingsWithPrefix(const std::string &prefix)
+{
+    std::error_code ec;
+    std::filesystem::directory_iterator it("/dev/shm", ec);
+    if (ec)
+    {
+        return 0;
+    }
+
+    const std::string object_prefix = GetObjectName(prefix);
+    std::size_t added = 0;
+    for (const std::filesystem::directory_entry &entry : it)
+    {
+        const std::string name = "/" + entry.path().filename().string();
+        if (name.compare(0, object_prefix.size(), object_prefix) != 0)
+        {
+            continue;
+        }
+
+        const bool is_known = std::any_of(m_readers.begin(), m_readers.end(),
+                                          [&name](const std::unique_ptr<utils::ShmRingReader> &reader)
+                                          { return reader->GetName() == name; });
+        if (!is_known && AddRing(name, ec))
+        {
+            added++;
+        }
+    }
+
+    return added;
+}
+
+std::size_t utils::ShmCollector::Poll(const utils::ShmCollector::Handler &handler, std::size_t max_per_ring)
+{
+    std::size_t handled = 0;
+    for (const std::unique_ptr<utils::ShmRingReader> &reader : m_readers)
+    {
+        const std::string &ring = reader->GetName();
+        handled += reader->Drain([&](const char *data, std::size_t size, std::uint32_t flags)
+                                 { handler(ring, data, size, (flags & utils::ShmRingHeader::FLAG_BINARY) != 0); },
+                                 max_per_ring);
+    }
+
+    m_readers.erase(std::remove_if(m_readers.begin(), m_readers.end(),
+                                   [](const std::unique_ptr<utils::ShmRingReader> &reader)
+                                   { return reader->IsFinished(); }),
+                    m_readers.end());
+    return handled;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "message_sink.hpp"
+
+namespace utils
+{
+
+/**
+ * Layout at the start of the shared memory object, the record area follows at RECORD_OFFSET. head and tail are
+ * monotonically increasing byte counts, only the writer stores head and only the reader stores tail, each on its own
+ * cache line so the two sides do not false share.
+ *
+ *   record: u32 payload length | u32 flags | payload bytes | padding to 8 bytes
+ *
+ * A record never wraps, when it does not fit before the end of the ring the writer stores a length of PAD_RECORD
+ * and starts again at offset 0.
+ */
+struct ShmRingHeader
+{
+    static constexpr std::uint32_t MAGIC = 0x52535643; // "CVSR" read as a little endian u32
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t PAD_RECORD = 0xFFFFFFFF;
+    static constexpr std::uint32_t FLAG_BINARY = 1U << 0;
+    static constexpr std::uint32_t FLAG_HIGH_PRIORITY = 1U << 1;
+
+    std::atomic<std::uint32_t> magic;
+    std::uint32_t version;
+    std::uint64_t capacity;
+    std::atomic<std::uint32_t> is_writer_closed;
+
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+    alignas(64) std::atomic<std::uint64_t> dropped;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory rings need lock free 64 bit atomics.");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Shared memory rings need lock free 32 bit atomics.");
+
+/**
+ * Producer side of a ring in /dev/shm, for federates running on the same host as the collector. Send never blocks,
+ * a message that does not fit is dropped and counted. Only one thread may send on a ring, use one ring per thread.
+ *
+ * The ring is FIFO, SendPriority is carried in the record flags for the collector but does not reorder anything.
+ */
+class ShmRingWriter : public MessageSink
+{
+  private:
+    std::string m_name;
+    int m_fd{ -1 };
+    void *m_mapping{};
+    std::size_t m_mapping_bytes{};
+    ShmRingHeader *m_header{};
+    char *m_records{};
+
+    std::uint64_t m_sent_messages{};
+    std::uint64_t m_sent_bytes{};
+
+    ShmRingWriter() = default;
+
+    bool Write(const void *data, std::size_t size, std::uint32_t flags);
+
+  public:
+    ShmRingWriter(const ShmRingWriter &) = delete;
+    ShmRingWriter &operator=(const ShmRingWriter &) = delete;
+
+    /**
+     * @brief Marks the ring closed and unlinks it, a collector that already mapped it can still drain what is left.
+     */
+    ~ShmRingWriter() override;
+
+    /**
+     * @brief Creates the ring. An object with the same name is never taken over unless asked for, it may belong to
+     *        a writer that is still running.
+     * @param name shared memory object name, a leading '/' is added when missing.
+     * @param capacity_bytes size of the record area, rounded up to a power of two.
+     * @param replace_stale unlinks an existing object with this name first, for a ring known to be left behind by a
+     *        crashed process.
+     * @return nullptr with ec set if the object could not be created or mapped, ec is
+     *         std::errc::file_exists when the name is taken.
+     */
+    static std::unique_ptr<ShmRingWriter> Create(const std::string &name, std::size_t capacity_bytes,
+                                                 std::error_code &ec, bool replace_stale = false);
+
+    bool Send(std::shared_ptr<const std::string> message, SendPriority priority = SendPriority::BULK) override;
+    bool SendBinary(std::shared_ptr<const std::string> message, SendPriority priority = SendPriority::BULK) override;
+
+    /**
+     * @brief Copies the message into the ring without going through a shared_ptr.
+     */
+    bool Send(const std::string &message, SendPriority priority = SendPriority::BULK);
+    bool SendBinary(const std::string &message, SendPriority priority = SendPriority::BULK);
+
+    const std::string &GetName() const { return m_name; }
+    std::uint64_t GetSentMessages() const { return m_sent_messages; }
+    std::uint64_t GetSentBytes() const { return m_sent_bytes; }
+    std::uint64_t GetDroppedMessages() const;
+};
+
+/**
+ * Consumer side of one ring. Drain hands out pointers into the shared mapping, they are valid until the handler
+ * returns, after which the space is released back to the writer.
+ */
+class ShmRingReader
+{
+  public:
+    using Handler = std::function<void(const char *data, std::size_t size, std::uint32_t flags)>;
+
+  private:
+    std::string m_name;
+    void *m_mapping{};
+    std::size_t m_mapping_bytes{};
+    ShmRingHeader *m_header{};
+    const char *m_records{};
+    bool m_is_corrupted{}; // a record overran the ring or the written bytes, nothing more is read from it
+
+    ShmRingReader() = default;
+
+  public:
+    ShmRingReader(const ShmRingReader &) = delete;
+    ShmRingReader &operator=(const ShmRingReader &) = delete;
+    ~ShmRingReader();
+
+    /**
+     * @return nullptr with ec set if the object does not exist or is not an initialised ring.
+     */
+    static std::unique_ptr<ShmRingReader> Open(const std::string &name, std::error_code &ec);
+
+    /**
+     * @brief Calls handler for up to max_messages records in the order they were written.
+     * A record whose length runs past the bytes written or the end of the ring marks the ring corrupted, nothing is
+     * drained from it anymore.
+     * @return the number of records handled.
+     */
+    std::size_t Drain(const Handler &handler, std::size_t max_messages);
+
+    /**
+     * @brief True once the writer is gone and every record it wrote has been drained, or the ring is corrupted.
+     */
+    bool IsFinished() const;
+
+    const std::string &GetName() const { return m_name; }
+    std::uint64_t GetDroppedMessages() const;
+};
+
+/**
+ * Drains many rings from one thread, typically one ring per co-located federate.
+ */
+class ShmCollector
+{
+  public:
+    using Handler =
+        std::function<void(const std::string &ring, const char *data, std::size_t size, bool is_binary)>;
+
+  private:
+    std::vector<std::unique_ptr<ShmRingReader>> m_readers;
+
+  public:
+    bool AddRing(const std::string &name, std::error_code &ec);
+
+    /**
+     * @brief Opens every ring in /dev/shm whose name starts with prefix that is not already being drained.
+     * @return the number of rings added.
+     */
+    std::size_t AddRingsWithPrefix(const std::string &prefix);
+
+    /**
+     * @brief Drains up to max_per_ring records from each ring, round robin so one busy federate cannot starve the
+     * others, and forgets rings whose writer has finished.
+     * @return the number of records handled.
+     */
+    std::size_t Poll(const Handler &handler, std::size_t max_per_ring);
+
+    std::size_t GetRingCount() const { return m_readers.size(); }
+};
+
+} // namespace utils
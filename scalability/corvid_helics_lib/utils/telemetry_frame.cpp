@@ -0,0 +1,246 @@
+#include "telemetry_frame.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+// "CVTF" read as a little endian u32
+constexpr std::uint32_t FRAME_MAGIC = 0x46545643;
+constexpr std::uint16_t FRAME_VERSION = 1;
+
+template <typename T> void WriteInt(std::string &out, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        out.push_back(static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xFF));
+    }
+}
+
+void WriteDouble(std::string &out, double value)
+{
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    WriteInt(out, bits);
+}
+
+void PatchU32(std::string &out, std::size_t offset, std::uint32_t value)
+{
+    for (std::size_t i = 0; i < sizeof(value); i++)
+    {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// Bounds checked little endian reader over a received message
+class Reader
+{
+  private:
+    const unsigned char *m_data;
+    std::size_t m_size;
+    std::size_t m_offset{};
+
+  public:
+    Reader(const void *data, std::size_t size) : m_data(static_cast<const unsigned char *>(data)), m_size(size) {}
+
+    std::size_t GetOffset() const { return m_offset; }
+    std::size_t GetRemaining() const { return m_size - m_offset; }
+
+    template <typename T> bool ReadInt(T &value)
+    {
+        if (GetRemaining() < sizeof(T)) return false;
+
+        std::uint64_t result = 0;
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            result |= static_cast<std::uint64_t>(m_data[m_offset + i]) << (8 * i);
+        }
+        value = static_cast<T>(result);
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool ReadDouble(double &value)
+    {
+        std::uint64_t bits = 0;
+        if (!ReadInt(bits)) return false;
+
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool ReadString(std::size_t length, std::string &value)
+    {
+        if (GetRemaining() < length) return false;
+
+        value.assign(reinterpret_cast<const char *>(m_data + m_offset), length);
+        m_offset += length;
+        return true;
+    }
+
+    bool Skip(std::size_t length)
+    {
+        if (GetRemaining() < length) return false;
+
+        m_offset += length;
+        return true;
+    }
+};
+
+} // namespace
+
+// ###################################
+// TelemetryFrameWriter Implementation
+// ###################################
+
+utils::TelemetryFrameWriter::TelemetryFrameWriter(const std::string &source, std::uint16_t schema_id,
+                                                  std::uint16_t schema_version)
+    : m_source(source.substr(0, std::numeric_limits<std::uint16_t>::max())), m_schema_id(schema_id),
+      m_schema_version(schema_version)
+{
+    BeginFrame();
+}
+
+void utils::TelemetryFrameWriter::BeginFrame()
+{
+    m_buffer.clear();
+    m_record_count = 0;
+
+    WriteInt(m_buffer, FRAME_MAGIC);
+    WriteInt(m_buffer, FRAME_VERSION);
+    WriteInt(m_buffer, m_schema_id);
+    WriteInt(m_buffer, m_schema_version);
+    WriteInt(m_buffer, static_cast<std::uint16_t>(m_source.size()));
+    m_buffer += m_source;
+
+    m_count_offset = m_buffer.size();
+    WriteInt(m_buffer, std::uint32_t{ 0 });
+}
+
+void utils::TelemetryFrameWriter::BeginRecord(utils::TelemetryRecordType type, const std::string &name, double time,
+                                              std::size_t payload_bytes)
+{
+    const std::size_t name_length = std::min<std::size_t>(name.size(), std::numeric_limits<std::uint16_t>::max());
+    const std::size_t record_length = sizeof(std::uint8_t) + sizeof(std::uint16_t) + name_length + sizeof(double) +
+                                      payload_bytes;
+
+    WriteInt(m_buffer, static_cast<std::uint32_t>(record_length));
+    WriteInt(m_buffer, static_cast<std::uint8_t>(type));
+    WriteInt(m_buffer, static_cast<std::uint16_t>(name_length));
+    m_buffer.append(name, 0, name_length);
+    WriteDouble(m_buffer, time);
+
+    m_record_count++;
+}
+
+void utils::TelemetryFrameWriter::AddSample(const std::string &name, double time, double value)
+{
+    BeginRecord(utils::TelemetryRecordType::SAMPLE, name, time, sizeof(double));
+    WriteDouble(m_buffer, value);
+}
+
+void utils::TelemetryFrameWriter::AddCounter(const std::string &name, double time, std::uint64_t count)
+{
+    BeginRecord(utils::TelemetryRecordType::COUNTER, name, time, sizeof(std::uint64_t));
+    WriteInt(m_buffer, count);
+}
+
+void utils::TelemetryFrameWriter::AddEvent(const std::string &name, double time, const std::string &text)
+{
+    BeginRecord(utils::TelemetryRecordType::EVENT, name, time, sizeof(std::uint32_t) + text.size());
+    WriteInt(m_buffer, static_cast<std::uint32_t>(text.size()));
+    m_buffer += text;
+}
+
+std::string utils::TelemetryFrameWriter::Finish()
+{
+    PatchU32(m_buffer, m_count_offset, m_record_count);
+
+    std::string frame = std::move(m_buffer);
+    BeginFrame();
+    return frame;
+}
+
+// ###################################
+// Decoding
+// ###################################
+
+bool utils::IsTelemetryFrame(const void *data, std::size_t size)
+{
+    Reader reader(data, size);
+    std::uint32_t magic = 0;
+    std::uint16_t version = 0;
+    return reader.ReadInt(magic) && reader.ReadInt(version) && magic == FRAME_MAGIC && version == FRAME_VERSION;
+}
+
+std::optional<utils::TelemetryFrame> utils::DecodeTelemetryFrame(const void *data, std::size_t size)
+{
+    std::optional<utils::TelemetryFrame> result{};
+    if (!IsTelemetryFrame(data, size))
+    {
+        return result;
+    }
+
+    Reader reader(data, size);
+    reader.Skip(sizeof(std::uint32_t) + sizeof(std::uint16_t));
+
+    utils::TelemetryFrame frame;
+    std::uint16_t source_length = 0;
+    std::uint32_t record_count = 0;
+    if (!reader.ReadInt(frame.schema_id) || !reader.ReadInt(frame.schema_version) ||
+        !reader.ReadInt(source_length) || !reader.ReadString(source_length, frame.source) ||
+        !reader.ReadInt(record_count))
+    {
+        return result;
+    }
+
+    for (std::uint32_t i = 0; i < record_count; i++)
+    {
+        std::uint32_t record_length = 0;
+        if (!reader.ReadInt(record_length) || reader.GetRemaining() < record_length) return result;
+        const std::size_t record_end = reader.GetOffset() + record_length;
+
+        std::uint8_t type = 0;
+        std::uint16_t name_length = 0;
+        utils::TelemetryRecord record;
+        if (!reader.ReadInt(type) || !reader.ReadInt(name_length) || !reader.ReadString(name_length, record.name) ||
+            !reader.ReadDouble(record.time))
+        {
+            return result;
+        }
+
+        bool is_known = true;
+        switch (static_cast<utils::TelemetryRecordType>(type))
+        {
+        case utils::TelemetryRecordType::SAMPLE:
+            if (!reader.ReadDouble(record.value)) return result;
+            break;
+        case utils::TelemetryRecordType::COUNTER:
+            if (!reader.ReadInt(record.count)) return result;
+            break;
+        case utils::TelemetryRecordType::EVENT:
+        {
+            std::uint32_t text_length = 0;
+            if (!reader.ReadInt(text_length) || !reader.ReadString(text_length, record.text)) return result;
+            break;
+        }
+        default:
+            is_known = false;
+            break;
+        }
+
+        // Step over unknown types and any trailing fields a newer producer appended
+        if (reader.GetOffset() > record_end || !reader.Skip(record_end - reader.GetOffset())) return result;
+
+        if (is_known)
+        {
+            record.type = static_cast<utils::TelemetryRecordType>(type);
+            frame.records.push_back(std::move(record));
+        }
+    }
+
+    result = std::move(frame);
+    return result;
+}
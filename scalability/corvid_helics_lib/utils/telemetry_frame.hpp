@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * Binary telemetry frame, sent as a single WebSocket binary message. All integers are little endian.
+ *
+ *   header:  u32 magic "CVTF" | u16 format version | u16 schema id | u16 schema version | u16 source length
+ *            | source bytes | u32 record count
+ *   record:  u32 record length (everything after this field) | u8 type | u16 name length | name bytes
+ *            | f64 time | payload
+ *   payload: SAMPLE f64 value, COUNTER u64 value, EVENT u32 text length + text bytes
+ *
+ * The record length lets a decoder skip record types it does not know, so types can be added without bumping the
+ * format version. The schema id and version describe what the producer puts in the names and are not interpreted
+ * here.
+ */
+enum class TelemetryRecordType : std::uint8_t
+{
+    SAMPLE = 1,
+    COUNTER = 2,
+    EVENT = 3
+};
+
+struct TelemetryRecord
+{
+    TelemetryRecordType type{ TelemetryRecordType::SAMPLE };
+    std::string name{};
+    double time{};
+    double value{};         // SAMPLE
+    std::uint64_t count{};  // COUNTER
+    std::string text{};     // EVENT
+};
+
+struct TelemetryFrame
+{
+    std::uint16_t schema_id{};
+    std::uint16_t schema_version{};
+    std::string source{};
+    std::vector<TelemetryRecord> records{};
+};
+
+/**
+ * Accumulates records and encodes them into a frame. Records are encoded as they are added, so Finish() only patches
+ * the record count.
+ */
+class TelemetryFrameWriter
+{
+  private:
+    std::string m_source;
+    std::uint16_t m_schema_id{};
+    std::uint16_t m_schema_version{};
+
+    std::string m_buffer;
+    std::uint32_t m_record_count{};
+    std::size_t m_count_offset{};
+
+    void BeginFrame();
+    void BeginRecord(TelemetryRecordType type, const std::string &name, double time, std::size_t payload_bytes);
+
+  public:
+    TelemetryFrameWriter(const std::string &source, std::uint16_t schema_id, std::uint16_t schema_version);
+
+    void AddSample(const std::string &name, double time, double value);
+    void AddCounter(const std::string &name, double time, std::uint64_t count);
+    void AddEvent(const std::string &name, double time, const std::string &text);
+
+    std::uint32_t GetRecordCount() const { return m_record_count; }
+
+    /**
+     * @brief Returns the encoded frame and starts a new, empty one.
+     */
+    std::string Finish();
+};
+
+/**
+ * @brief Checks the magic and format version without decoding the rest.
+ */
+bool IsTelemetryFrame(const void *data, std::size_t size);
+
+/**
+ * @brief Decodes a frame, skipping records of unknown type.
+ * @return std::nullopt if the frame is not a telemetry frame or is truncated.
+ */
+std::optional<TelemetryFrame> DecodeTelemetryFrame(const void *data, std::size_t size);
+
+} // namespace utils
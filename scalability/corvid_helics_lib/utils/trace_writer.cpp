@@ -0,0 +1,120 @@
+#include "trace_writer.hpp"
+#include "json_escape.hpp"
+
+#include <iomanip>
+
+#include <unistd.h>
+
+namespace
+{
+
+/**
+ * Small stable id per thread for the trace tracks, shared by every writer in the process.
+ */
+std::uint32_t GetTraceThreadId()
+{
+    static std::atomic<std::uint32_t> next_id{ 1 };
+    thread_local const std::uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+} // namespace
+
+utils::TraceWriter::TraceWriter(const std::string &output_file, const std::string &process_name)
+    : m_output_stream(output_file, std::ios::trunc), m_open_time(std::chrono::steady_clock::now()),
+      m_pid(static_cast<std::int64_t>(::getpid()))
+{
+    m_open_epoch_us = std::chrono::duration<double, std::micro>(std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    // Enough digits for microseconds since the epoch with a fraction left over
+    m_output_stream << std::fixed << std::setprecision(3);
+    m_output_stream << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << m_pid
+                    << ",\"tid\":0,\"args\":{\"name\":\"" << EscapeJson(process_name) << "\"}}";
+}
+
+utils::TraceWriter::~TraceWriter()
+{
+    if (IsOpen())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_output_stream << "\n]\n";
+        m_output_stream.close();
+    }
+}
+
+void utils::TraceWriter::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_output_stream.flush();
+}
+
+std::uint64_t utils::TraceWriter::GetEventCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events;
+}
+
+double utils::TraceWriter::ToEpochMicroseconds(std::chrono::steady_clock::time_point time) const
+{
+    return m_open_epoch_us + std::chrono::duration<double, std::micro>(time - m_open_time).count();
+}
+
+void utils::TraceWriter::BeginEvent(const char *name, const char *phase, double epoch_us, std::uint32_t tid)
+{
+    if (tid >= m_named_threads.size() || !m_named_threads[tid])
+    {
+        if (tid >= m_named_threads.size()) m_named_threads.resize(tid + 1);
+        m_named_threads[tid] = true;
+        m_output_stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << m_pid << ",\"tid\":" << tid
+                        << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+    }
+
+    m_output_stream << ",\n{\"name\":\"" << EscapeJson(name != nullptr ? name : "") << "\",\"ph\":\"" << phase
+                    << "\",\"ts\":" << epoch_us << ",\"pid\":" << m_pid << ",\"tid\":" << tid;
+}
+
+void utils::TraceWriter::EndEvent(const std::string &label)
+{
+    const double simulated_time = m_simulated_time.load(std::memory_order_relaxed);
+    m_output_stream << ",\"args\":{\"sim_time\":" << simulated_time;
+    if (!label.empty())
+    {
+        m_output_stream << ",\"label\":\"" << EscapeJson(label) << "\"";
+    }
+    m_output_stream << "}}";
+    m_events++;
+}
+
+void utils::TraceWriter::AddComplete(const char *name, std::chrono::steady_clock::time_point start,
+                                     std::chrono::nanoseconds duration, const std::string &label)
+{
+    if (!IsOpen()) return;
+
+    const double start_us = ToEpochMicroseconds(start);
+    const double duration_us = std::chrono::duration<double, std::micro>(duration).count();
+    const std::uint32_t tid = GetTraceThreadId();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    BeginEvent(name, "X", start_us, tid);
+    m_output_stream << ",\"dur\":" << duration_us;
+    EndEvent(label);
+}
+
+void utils::TraceWriter::AddInstant(const char *name, const std::string &label)
+{
+    if (!IsOpen()) return;
+
+    const double now_us = ToEpochMicroseconds(std::chrono::steady_clock::now());
+    const std::uint32_t tid = GetTraceThreadId();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    BeginEvent(name, "i", now_us, tid);
+    // Thread scoped so the instant sits on the track of the thread that saw it
+    m_output_stream << ",\"s\":\"t\"";
+    EndEvent(label);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * Writes Chrome Trace Event JSON (the array form), which loads in chrome://tracing and ui.perfetto.dev. Timestamps
+ * are microseconds since the Unix epoch: the system clock is read once at open and a steady clock offset added per
+ * event, so a process never goes backwards and traces from different federates line up as well as their hosts'
+ * clocks do. Merge the per federate files onto one timeline with merge_traces.
+ *
+ * Events are tagged with the simulated time last set with SetSimulatedTime. Safe to use from several threads.
+ */
+class TraceWriter
+{
+  private:
+    std::mutex m_mutex{};
+    std::ofstream m_output_stream{};
+    std::chrono::steady_clock::time_point m_open_time{};
+    double m_open_epoch_us{};
+    std::int64_t m_pid{};
+    std::atomic<double> m_simulated_time{ -1.0 };
+    std::vector<bool> m_named_threads{};
+    std::uint64_t m_events{};
+
+    double ToEpochMicroseconds(std::chrono::steady_clock::time_point time) const;
+    // Called with m_mutex held
+    void BeginEvent(const char *name, const char *phase, double epoch_us, std::uint32_t tid);
+    void EndEvent(const std::string &label);
+
+  public:
+    /**
+     * @param process_name shown as the track name, usually the federate name.
+     */
+    TraceWriter(const std::string &output_file, const std::string &process_name);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    bool IsOpen() const { return m_output_stream.is_open(); }
+    void Flush();
+    std::uint64_t GetEventCount();
+
+    void SetSimulatedTime(double simulated_time) { m_simulated_time.store(simulated_time, std::memory_order_relaxed); }
+
+    /**
+     * @brief A span on the calling thread's track, e.g. a zone from the profiler.
+     * @param label optional detail shown with the event, such as the query or bus it was for.
+     */
+    void AddComplete(const char *name, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration,
+                     const std::string &label = {});
+
+    /**
+     * @brief A point in time on the calling thread's track, e.g. a time grant.
+     */
+    void AddInstant(const char *name, const std::string &label = {});
+};
+
+} // namespace utils
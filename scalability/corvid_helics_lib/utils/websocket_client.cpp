@@ -7,30 +7,89 @@
 #include <boost/beast/core/error.hpp>
 #include <boost/beast/websocket/rfc6455.hpp>
 #include <boost/beast/websocket/stream.hpp>
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/beast/zlib/error.hpp>
 #include <boost/system/error_code.hpp>
+#include <boost/version.hpp>
 #include <cstddef>
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <future>
+#include <iterator>
 
-utils::WebSocketClient::WebSocketClient()
-    : m_ioc(), m_work_guard(boost::asio::make_work_guard(m_ioc)), m_resolver(m_ioc), m_ws(m_ioc)
+std::optional<utils::OverflowPolicy> utils::OverflowPolicyFromString(const std::string &policy)
 {
+    std::optional<utils::OverflowPolicy> result{};
+
+    if (policy == "block")
+    {
+        result = utils::OverflowPolicy::BLOCK;
+    }
+    else if (policy == "drop_oldest")
+    {
+        result = utils::OverflowPolicy::DROP_OLDEST;
+    }
+    else if (policy == "drop_newest")
+    {
+        result = utils::OverflowPolicy::DROP_NEWEST;
+    }
+
+    return result;
+}
+
+utils::WebSocketClient::WebSocketClient() : WebSocketClient(utils::SendOptions{}) {}
+
+double utils::SendStats::GetCompressionRatio() const
+{
+    return sampled_compressed_bytes > 0 ? static_cast<double>(sampled_bytes) / sampled_compressed_bytes : 1.0;
+}
+
+double utils::SendStats::GetCompressMsPerMegabyte() const
+{
+    return sampled_bytes > 0 ? sampled_compress_ms / (sampled_bytes / (1024.0 * 1024.0)) : 0.0;
+}
+
+utils::WebSocketClient::WebSocketClient(const utils::SendOptions &send_options,
+                                        const utils::ReconnectOptions &reconnect_options,
+                                        const utils::CompressionOptions &compression_options)
+    : WebSocketClient(std::make_unique<boost::asio::io_context>(1), nullptr, send_options, reconnect_options,
+                      compression_options)
+{
+}
+
+utils::WebSocketClient::WebSocketClient(boost::asio::io_context &shared_ioc, const utils::SendOptions &send_options,
+                                        const utils::ReconnectOptions &reconnect_options,
+                                        const utils::CompressionOptions &compression_options)
+    : WebSocketClient(nullptr, &shared_ioc, send_options, reconnect_options, compression_options)
+{
+}
+
+utils::WebSocketClient::WebSocketClient(std::unique_ptr<boost::asio::io_context> owned_ioc,
+                                        boost::asio::io_context *shared_ioc, const utils::SendOptions &send_options,
+                                        const utils::ReconnectOptions &reconnect_options,
+                                        const utils::CompressionOptions &compression_options)
+    : m_owned_ioc(std::move(owned_ioc)), m_ioc(m_owned_ioc ? *m_owned_ioc : *shared_ioc),
+      m_strand(boost::asio::make_strand(m_ioc)), m_work_guard(), m_resolver(m_strand), m_ws(),
+      m_reconnect_options(reconnect_options), m_reconnect_timer(m_strand),
+      m_backoff_ms(reconnect_options.initial_backoff_ms), m_send_options(send_options),
+      m_compression_options(compression_options)
+{
+    // Only a context we own is kept alive by us, a shared one belongs to its pool
+    if (m_owned_ioc)
+    {
+        m_work_guard.emplace(boost::asio::make_work_guard(m_ioc));
+    }
+
     // Initialize last error to success (0)
     m_last_error = boost::system::error_code();
-
-    // Set User-Agent
-    m_ws.set_option(boost::beast::websocket::stream_base::decorator(
-        [](boost::beast::websocket::request_type &req)
-        {
-            req.set(boost::beast::http::field::user_agent,
-                    std::string(BOOST_BEAST_VERSION_STRING) + "websocket-client-async");
-        }));
 }
 
 utils::WebSocketClient::~WebSocketClient() { StopRun(); }
 
 void utils::WebSocketClient::AsyncRun()
 {
-    if (!m_io_thread.joinable())
+    if (m_owned_ioc && !m_io_thread.joinable())
     {
         m_io_thread = std::thread([this]() { m_ioc.run(); });
     }
@@ -38,6 +97,18 @@ void utils::WebSocketClient::AsyncRun()
 
 void utils::WebSocketClient::StopRun()
 {
+    // Release any sender blocked on a full queue, the IO thread will not drain it anymore
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_is_stopping = true;
+    }
+    m_queue_space.notify_all();
+
+    if (!m_owned_ioc)
+    {
+        return;
+    }
+
     m_work_guard.reset(); // Allow run() to exit if out of work
     m_ioc.stop();         // Force stop
 
@@ -50,67 +121,228 @@ void utils::WebSocketClient::StopRun()
     m_work_guard.emplace(boost::asio::make_work_guard(m_ioc)); // Re-acquire work guard
 }
 
-void utils::WebSocketClient::BlockingRun() { m_ioc.run(); }
+void utils::WebSocketClient::BlockingRun()
+{
+    if (m_owned_ioc) m_ioc.run();
+}
 
 void utils::WebSocketClient::Connect(const std::string &host, const std::string &port, const std::string &target,
                                      std::function<void(const boost::system::error_code &)> on_connect)
 {
-    m_host = host;
-    m_target = target;
-    m_on_connect = on_connect;
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_is_stopping = false;
+        m_is_connection_lost = false;
+    }
+
+    // Everything else about the connection lives on the strand
+    boost::asio::post(m_strand,
+                      [this, self = shared_from_this(), host, port, target, on_connect]()
+                      {
+                          m_host = host;
+                          m_port = port;
+                          m_target = target;
+                          m_on_connect = on_connect;
+                          m_is_closing = false;
+                          m_backoff_ms = m_reconnect_options.initial_backoff_ms;
+
+                          ClearErrorState(); // Reset on new connection attempt
+                          StartConnect();
+                      });
+}
+
+void utils::WebSocketClient::StartConnect()
+{
+    m_is_reconnect_pending = false;
+    m_buffer.consume(m_buffer.size());
+
+    m_ws.emplace(m_strand);
+    m_connection_generation++;
+
+    // Set User-Agent
+    m_ws->set_option(boost::beast::websocket::stream_base::decorator(
+        [](boost::beast::websocket::request_type &req)
+        {
+            req.set(boost::beast::http::field::user_agent,
+                    std::string(BOOST_BEAST_VERSION_STRING) + "websocket-client-async");
+        }));
 
-    ClearErrorState(); // Reset on new connection attempt
+    if (m_compression_options.enabled)
+    {
+        boost::beast::websocket::permessage_deflate deflate;
+        deflate.client_enable = true;
+        deflate.client_max_window_bits = m_compression_options.client_max_window_bits;
+        deflate.server_max_window_bits = m_compression_options.server_max_window_bits;
+        deflate.client_no_context_takeover = m_compression_options.no_context_takeover;
+        deflate.server_no_context_takeover = m_compression_options.no_context_takeover;
+        deflate.compLevel = m_compression_options.level;
+        deflate.memLevel = m_compression_options.mem_level;
+#if BOOST_VERSION >= 107500
+        deflate.msg_size_threshold = m_compression_options.min_message_bytes;
+#endif
+        m_ws->set_option(deflate);
+    }
 
     // Start resolution
-    m_resolver.async_resolve(
-        host, port,
-        std::bind(&WebSocketClient::OnResolve, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    m_resolver.async_resolve(m_host, m_port,
+                             std::bind(&WebSocketClient::OnResolve, shared_from_this(), m_connection_generation,
+                                       std::placeholders::_1, std::placeholders::_2));
 }
 
-void utils::WebSocketClient::OnResolve(boost::beast::error_code ec,
+void utils::WebSocketClient::OnResolve(std::uint64_t generation, boost::beast::error_code ec,
                                        boost::asio::ip::tcp::resolver::results_type results)
 {
+    if (generation != m_connection_generation) return;
+
     if (ec)
     {
-        if (m_on_connect) m_on_connect(ec);
+        HandleConnectError(ec, "Resolve Error");
         return;
     }
 
     // Connect via TCP
-    boost::asio::async_connect(
-        m_ws.next_layer(), results,
-        std::bind(&WebSocketClient::OnConnect, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    boost::asio::async_connect(m_ws->next_layer(), results,
+                               std::bind(&WebSocketClient::OnConnect, shared_from_this(), generation,
+                                         std::placeholders::_1, std::placeholders::_2));
 }
 
-void utils::WebSocketClient::OnConnect(boost::beast::error_code ec,
+void utils::WebSocketClient::OnConnect(std::uint64_t generation, boost::beast::error_code ec,
                                        boost::asio::ip::tcp::resolver::results_type::endpoint_type)
 {
+    if (generation != m_connection_generation) return;
+
     if (ec)
     {
-        if (m_on_connect) m_on_connect(ec);
+        HandleConnectError(ec, "Connect Error");
         return;
     }
 
     // Perform WebSocket Handshake
-    m_ws.async_handshake(m_host, m_target,
-                         std::bind(&WebSocketClient::OnHandshake, shared_from_this(), std::placeholders::_1));
+    m_ws->async_handshake(
+        m_host, m_target,
+        std::bind(&WebSocketClient::OnHandshake, shared_from_this(), generation, std::placeholders::_1));
 }
 
-void utils::WebSocketClient::OnHandshake(boost::beast::error_code ec)
+void utils::WebSocketClient::OnHandshake(std::uint64_t generation, boost::beast::error_code ec)
 {
+    if (generation != m_connection_generation) return;
+
     if (ec)
     {
-        if (m_on_connect) m_on_connect(ec);
+        HandleConnectError(ec, "Handshake Error");
         return;
     }
 
     // Connection successful!
     ClearErrorState();
+    m_backoff_ms = m_reconnect_options.initial_backoff_ms;
 
     if (m_on_connect) m_on_connect(ec); // ec is success (0) here
 
     // Start the Read Loop immediately
     DoRead();
+
+    // Anything sent before the handshake, or kept from a lost connection, goes out now
+    bool start_write = false;
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_is_connected = true;
+        const bool has_queued = std::any_of(m_lanes.begin(), m_lanes.end(),
+                                            [](const std::deque<OutgoingMessage> &lane) { return !lane.empty(); });
+        start_write = !m_write_in_progress && has_queued;
+        m_write_in_progress = m_write_in_progress || start_write;
+    }
+
+    if (start_write)
+    {
+        DoWrite();
+    }
+}
+
+void utils::WebSocketClient::HandleConnectError(boost::beast::error_code ec, const std::string &context)
+{
+    if (!m_reconnect_options.enabled)
+    {
+        MarkConnectionLost();
+        if (m_on_connect) m_on_connect(ec);
+        return;
+    }
+
+    ReportError(ec, context);
+    ScheduleReconnect();
+}
+
+void utils::WebSocketClient::ScheduleReconnect()
+{
+    if (m_is_reconnect_pending)
+    {
+        return;
+    }
+    if (!m_reconnect_options.enabled || m_is_closing)
+    {
+        MarkConnectionLost();
+        return;
+    }
+    m_is_reconnect_pending = true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_is_connected = false;
+    }
+    m_queue_space.notify_all();
+
+    // Abort whatever is still pending on the old stream, its handlers see the error and return
+    boost::beast::error_code ignored;
+    if (m_ws) m_ws->next_layer().close(ignored);
+
+    m_reconnect_timer.expires_after(std::chrono::microseconds(static_cast<long long>(m_backoff_ms * 1000.0)));
+    m_backoff_ms = std::min(m_backoff_ms * 2.0, m_reconnect_options.max_backoff_ms);
+
+    m_reconnect_timer.async_wait(
+        [this, self = shared_from_this()](boost::beast::error_code ec)
+        {
+            if (ec || m_is_closing) return;
+
+            m_reconnects++;
+            StartConnect();
+        });
+}
+
+void utils::WebSocketClient::MarkConnectionLost()
+{
+    // Nothing will drain the queue again, so what is queued is dropped and Send drops until the next Connect
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_is_connected = false;
+        m_is_connection_lost = true;
+        for (std::size_t lane_index = 0; lane_index < LANE_COUNT; lane_index++)
+        {
+            m_dropped_messages += m_lanes[lane_index].size();
+            m_lanes[lane_index].clear();
+            m_lane_depths[lane_index] = 0;
+        }
+    }
+    m_queue_space.notify_all();
+}
+
+void utils::WebSocketClient::RequeueInflight()
+{
+    // Put the unsent frame back in front of the queue, keeping only the newest messages that fit the ring
+    if (m_inflight.empty()) return;
+
+    const std::size_t lane_index = static_cast<std::size_t>(m_inflight.front().priority);
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    std::deque<OutgoingMessage> &lane = m_lanes[lane_index];
+    lane.insert(lane.begin(), std::make_move_iterator(m_inflight.begin()), std::make_move_iterator(m_inflight.end()));
+    m_inflight.clear();
+
+    const std::size_t capacity = m_reconnect_options.replay_buffer_messages;
+    while (capacity > 0 && lane.size() > capacity)
+    {
+        lane.pop_front();
+        m_dropped_messages++;
+    }
+    m_lane_depths[lane_index] = lane.size();
 }
 
 void utils::WebSocketClient::SetOnMessage(std::function<void(const std::string &)> callback)
@@ -126,21 +358,37 @@ void utils::WebSocketClient::SetOnError(
 
 void utils::WebSocketClient::DoRead()
 {
-    m_ws.async_read(m_buffer, std::bind(&WebSocketClient::OnRead, shared_from_this(), std::placeholders::_1,
-                                        std::placeholders::_2));
+    m_ws->async_read(m_buffer, std::bind(&WebSocketClient::OnRead, shared_from_this(), m_connection_generation,
+                                        std::placeholders::_1, std::placeholders::_2));
 }
 
-void utils::WebSocketClient::OnRead(boost::beast::error_code ec, std::size_t bytes_transferred)
+void utils::WebSocketClient::OnRead(std::uint64_t generation, boost::beast::error_code ec,
+                                    std::size_t bytes_transferred)
 {
+    // A read on a stream that has since been replaced, the reconnect already dealt with it
+    if (generation != m_connection_generation) return;
+
     if (ec == boost::beast::websocket::error::closed)
     {
-        // Normal closure, stop reading
+        // Normal closure, stop reading. If the server closed on us (e.g. a restart), try to get back.
+        ScheduleReconnect();
         return;
     }
 
     if (ec)
     {
+        // Our own reconnect ended this read
+        if (m_is_reconnect_pending) return;
+
+        // Our own close ended this read
+        if (m_is_closing)
+        {
+            MarkConnectionLost();
+            return;
+        }
+
         ReportError(ec, "Read Error");
+        ScheduleReconnect();
         return;
     }
 
@@ -158,83 +406,375 @@ void utils::WebSocketClient::OnRead(boost::beast::error_code ec, std::size_t byt
     DoRead();
 }
 
-void utils::WebSocketClient::Send(const std::string &message)
+bool utils::WebSocketClient::Send(const std::string &message, utils::SendPriority priority)
 {
-    // Post to the IO context to ensure thread safety
-    boost::asio::post(m_ioc,
-                      [this, message, self = shared_from_this()]()
-                      {
-                          bool write_in_progress = !m_write_queue.empty();
-                          m_write_queue.push(message);
+    return Send(std::make_shared<const std::string>(message), priority);
+}
 
-                          // If not currently writing, kick off the write loop
-                          if (!write_in_progress)
-                          {
-                              DoWrite();
-                          }
-                      });
+bool utils::WebSocketClient::Send(std::string &&message, utils::SendPriority priority)
+{
+    return Send(std::make_shared<const std::string>(std::move(message)), priority);
+}
+
+bool utils::WebSocketClient::Send(std::shared_ptr<const std::string> message, utils::SendPriority priority)
+{
+    return Enqueue({ std::move(message), false, priority, std::chrono::steady_clock::now() });
+}
+
+bool utils::WebSocketClient::SendBinary(std::string &&message, utils::SendPriority priority)
+{
+    return SendBinary(std::make_shared<const std::string>(std::move(message)), priority);
+}
+
+bool utils::WebSocketClient::SendBinary(std::shared_ptr<const std::string> message, utils::SendPriority priority)
+{
+    return Enqueue({ std::move(message), true, priority, std::chrono::steady_clock::now() });
+}
+
+bool utils::WebSocketClient::Enqueue(utils::WebSocketClient::OutgoingMessage message)
+{
+    const std::size_t lane_index = static_cast<std::size_t>(message.priority);
+
+    bool start_write = false;
+    {
+        std::unique_lock<std::mutex> lock(m_queue_mutex);
+        std::deque<OutgoingMessage> &lane = m_lanes[lane_index];
+
+        // Disconnected with no reconnect coming, queueing would only grow the lane until the next Connect
+        if (m_is_connection_lost)
+        {
+            m_dropped_messages++;
+            return false;
+        }
+
+        // While disconnected nothing drains the queue, so it acts as a ring where the newest messages win instead of
+        // blocking the sender. With reconnect enabled the ring has its own size.
+        const bool is_disconnected = !m_is_connected;
+        const std::size_t max_queued = is_disconnected && m_reconnect_options.enabled
+                                           ? m_reconnect_options.replay_buffer_messages
+                                           : m_send_options.max_queued_messages;
+        if (max_queued > 0 && lane.size() >= max_queued)
+        {
+            OverflowPolicy policy = is_disconnected ? OverflowPolicy::DROP_OLDEST : m_send_options.overflow_policy;
+
+            // Blocking on the strand would wait on ourselves, e.g. a log line written from a read callback
+            if (policy == OverflowPolicy::BLOCK && m_strand.running_in_this_thread())
+            {
+                policy = OverflowPolicy::DROP_OLDEST;
+            }
+
+            switch (policy)
+            {
+            case OverflowPolicy::BLOCK:
+                // A lost connection turns the queue into the ring, which never blocks
+                m_queue_space.wait(lock, [this, &lane, max_queued]()
+                                   { return m_is_stopping || !m_is_connected || lane.size() < max_queued; });
+                if (m_is_stopping || m_is_connection_lost)
+                {
+                    m_dropped_messages++;
+                    return false;
+                }
+                if (lane.size() >= max_queued)
+                {
+                    // Woken by a lost connection, fall back to the ring
+                    lane.pop_front();
+                    m_dropped_messages++;
+                }
+                break;
+            case OverflowPolicy::DROP_OLDEST:
+                lane.pop_front();
+                m_dropped_messages++;
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+                m_dropped_messages++;
+                return false;
+            }
+        }
+
+        lane.push_back(std::move(message));
+        m_lane_depths[lane_index] = lane.size();
+
+        // If not currently writing, kick off the write loop. Until the handshake completes the message just waits
+        // in the queue, OnHandshake starts the writes.
+        start_write = m_is_connected && !m_write_in_progress;
+        m_write_in_progress = m_write_in_progress || start_write;
+    }
+
+    if (start_write)
+    {
+        boost::asio::post(m_strand, [this, self = shared_from_this()]() { DoWrite(); });
+    }
+
+    return true;
+}
+
+void utils::WebSocketClient::LaneLatency::Record(std::chrono::steady_clock::duration latency)
+{
+    const std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+
+    count++;
+    total_ns += ns;
+
+    std::uint64_t previous_max = max_ns;
+    while (ns > previous_max && !max_ns.compare_exchange_weak(previous_max, ns))
+    {
+    }
+
+    // Bucket i holds latencies below 2^(i + 1) microseconds
+    std::size_t bucket = 0;
+    for (std::uint64_t us = ns / 1000; us > 1 && bucket + 1 < BUCKET_COUNT; us >>= 1)
+    {
+        bucket++;
+    }
+    buckets[bucket]++;
+}
+
+void utils::WebSocketClient::LaneLatency::Fill(utils::LaneStats &stats) const
+{
+    const std::uint64_t total = count;
+    stats.sent_messages = total;
+    if (total == 0) return;
+
+    stats.mean_latency_ms = total_ns / 1.0e6 / total;
+    stats.max_latency_ms = max_ns / 1.0e6;
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += buckets[i];
+        if (seen * 100 >= total * 99)
+        {
+            stats.p99_latency_ms = static_cast<double>(1ULL << (i + 1)) / 1000.0;
+            break;
+        }
+    }
+}
+
+utils::SendStats utils::WebSocketClient::GetSendStats() const
+{
+    utils::SendStats stats;
+    stats.high_priority.queue_depth = m_lane_depths[static_cast<std::size_t>(utils::SendPriority::HIGH)];
+    stats.bulk.queue_depth = m_lane_depths[static_cast<std::size_t>(utils::SendPriority::BULK)];
+    stats.queue_depth = stats.high_priority.queue_depth + stats.bulk.queue_depth;
+    m_lane_latencies[static_cast<std::size_t>(utils::SendPriority::HIGH)].Fill(stats.high_priority);
+    m_lane_latencies[static_cast<std::size_t>(utils::SendPriority::BULK)].Fill(stats.bulk);
+    stats.dropped_messages = m_dropped_messages;
+    stats.sent_messages = m_sent_messages;
+    stats.sent_frames = m_sent_frames;
+    stats.sent_bytes = m_sent_bytes;
+    stats.reconnects = m_reconnects;
+    stats.sampled_bytes = m_sampled_bytes;
+    stats.sampled_compressed_bytes = m_sampled_compressed_bytes;
+    stats.sampled_compress_ms = m_sampled_compress_ns / 1.0e6;
+    return stats;
 }
 
 void utils::WebSocketClient::DoWrite()
 {
-    // Note: We are already in the io_context strand here because DoWrite
-    // is called from Send's post() or OnWrite
+    // Note: Only the strand gets here, through the post in Send or from OnWrite, so m_inflight and
+    // m_frame_buffers need no locking. The queue itself is shared with the sending threads.
 
-    if (m_write_queue.empty())
+    m_inflight.clear();
     {
-        return;
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+
+        // Lanes are declared in priority order, the first one with anything queued goes next
+        std::size_t lane_index = 0;
+        while (lane_index < LANE_COUNT && m_lanes[lane_index].empty())
+        {
+            lane_index++;
+        }
+
+        if (lane_index == LANE_COUNT || !m_is_connected)
+        {
+            // Nothing is left on the wire, wake Drain
+            m_write_in_progress = false;
+            m_queue_space.notify_all();
+            return;
+        }
+        std::deque<OutgoingMessage> &lane = m_lanes[lane_index];
+
+        // Take at least one message, then keep joining text while the frame stays under the limit. Binary messages
+        // carry their own framing and always go out alone.
+        std::size_t frame_bytes = 0;
+        do
+        {
+            const OutgoingMessage &next = lane.front();
+            if (!m_inflight.empty() &&
+                (next.is_binary || frame_bytes + next.data->size() > m_send_options.max_frame_bytes))
+            {
+                break;
+            }
+
+            frame_bytes += next.data->size();
+            m_inflight.push_back(std::move(lane.front()));
+            lane.pop_front();
+        } while (m_send_options.max_frame_bytes > 0 && !m_inflight.front().is_binary && !lane.empty());
+
+        m_lane_depths[lane_index] = lane.size();
     }
+    m_queue_space.notify_all();
 
-    m_ws.async_write(
-        boost::asio::buffer(m_write_queue.front()),
-        std::bind(&WebSocketClient::OnWrite, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    std::size_t frame_bytes = 0;
+    m_frame_buffers.clear();
+    for (const OutgoingMessage &message : m_inflight)
+    {
+        m_frame_buffers.push_back(boost::asio::buffer(*message.data));
+        frame_bytes += message.data->size();
+    }
+    m_ws->binary(m_inflight.front().is_binary);
+
+    if (m_compression_options.enabled && m_compression_options.sample_every > 0 &&
+        frame_bytes >= m_compression_options.min_message_bytes &&
+        ++m_frames_since_sample >= m_compression_options.sample_every)
+    {
+        m_frames_since_sample = 0;
+        SampleCompression(frame_bytes);
+    }
+
+    m_ws->async_write(m_frame_buffers, std::bind(&WebSocketClient::OnWrite, shared_from_this(),
+                                                 m_connection_generation, std::placeholders::_1,
+                                                 std::placeholders::_2));
 }
 
-void utils::WebSocketClient::OnWrite(boost::beast::error_code ec, std::size_t)
+void utils::WebSocketClient::SampleCompression(std::size_t frame_bytes)
 {
-    if (ec)
+    // Deflate the frame the way the extension would, one message with a fresh dictionary
+    boost::beast::zlib::deflate_stream deflate;
+    deflate.reset(m_compression_options.level, m_compression_options.client_max_window_bits,
+                  m_compression_options.mem_level, boost::beast::zlib::Strategy::normal);
+
+    m_sample_buffer.resize(deflate.upper_bound(frame_bytes) + 16);
+
+    boost::beast::zlib::z_params zs;
+    zs.next_out = m_sample_buffer.data();
+    zs.avail_out = m_sample_buffer.size();
+
+    const auto start = std::chrono::steady_clock::now();
+    boost::beast::error_code ec;
+    for (std::size_t i = 0; i < m_frame_buffers.size() && !ec; i++)
     {
-        ReportError(ec, "Write Error");
+        zs.next_in = m_frame_buffers[i].data();
+        zs.avail_in = m_frame_buffers[i].size();
+        const bool is_last = i + 1 == m_frame_buffers.size();
+        deflate.write(zs, is_last ? boost::beast::zlib::Flush::sync : boost::beast::zlib::Flush::none, ec);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (ec && ec != boost::beast::zlib::error::need_buffers)
+    {
+        return;
+    }
+
+    m_sampled_bytes += frame_bytes;
+    m_sampled_compressed_bytes += zs.total_out;
+    m_sampled_compress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
 
-        // Even on error, we usually pop the failed message and try the next,
-        // or clear the queue depending on desired robustness.
-        // Here we pop and try to continue.
-        m_write_queue.pop();
-        if (!m_write_queue.empty())
+void utils::WebSocketClient::OnWrite(std::uint64_t generation, boost::beast::error_code ec,
+                                     std::size_t bytes_transferred)
+{
+    if (generation != m_connection_generation)
+    {
+        // The frame went to a stream that has since been replaced. Keep it for the new connection, DoWrite picks
+        // the queue up again once that one is connected.
+        if (m_reconnect_options.enabled && !m_is_closing)
+        {
+            RequeueInflight();
+        }
+        else
         {
-            DoWrite();
+            m_dropped_messages += m_inflight.size();
         }
+        DoWrite();
+        return;
+    }
 
+    if (ec && m_reconnect_options.enabled && !m_is_closing)
+    {
+        // Keep the frame for replay and let the reconnect restart the writes
+        if (!m_is_reconnect_pending) ReportError(ec, "Write Error");
+        RequeueInflight();
+        {
+            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            m_write_in_progress = false;
+        }
+        ScheduleReconnect();
         return;
     }
 
-    // Success - clear error state
-    ClearErrorState();
+    if (ec)
+    {
+        // The failed frame is dropped and we move on to the rest of the queue
+        ReportError(ec, "Write Error");
+        m_dropped_messages += m_inflight.size();
+    }
+    else
+    {
+        // Success - clear error state
+        ClearErrorState();
+        m_sent_messages += m_inflight.size();
+        m_sent_frames++;
 
-    // Success, remove the sent message
-    m_write_queue.pop();
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (const OutgoingMessage &message : m_inflight)
+        {
+            m_lane_latencies[static_cast<std::size_t>(message.priority)].Record(now - message.enqueued);
+        }
+        m_sent_bytes += bytes_transferred;
+    }
+
+    // If more messages, send the next frame
+    DoWrite();
+}
 
-    // If more messages, send the next one
-    if (!m_write_queue.empty())
+bool utils::WebSocketClient::Drain(std::chrono::milliseconds timeout)
+{
+    if (m_strand.running_in_this_thread())
     {
-        DoWrite();
+        return false;
     }
+
+    std::unique_lock<std::mutex> lock(m_queue_mutex);
+    const auto is_drained = [this]()
+    {
+        return !m_write_in_progress &&
+               std::all_of(m_lanes.begin(), m_lanes.end(),
+                           [](const std::deque<OutgoingMessage> &lane) { return lane.empty(); });
+    };
+    m_queue_space.wait_for(lock, timeout,
+                           [this, &is_drained]() { return is_drained() || m_is_stopping || m_is_connection_lost; });
+    return is_drained();
 }
 
-void utils::WebSocketClient::CloseConnection()
+bool utils::WebSocketClient::CloseConnection(std::chrono::milliseconds timeout)
 {
-    boost::asio::post(m_ioc,
-                      [this, self = shared_from_this()]()
+    // Waited on below, so neither handler is left queued for StopRun to drop while it holds on to the client
+    const std::shared_ptr<std::promise<void>> closed = std::make_shared<std::promise<void>>();
+    std::future<void> closed_future = closed->get_future();
+
+    boost::asio::post(m_strand,
+                      [this, self = shared_from_this(), closed]()
                       {
-                          if (m_ws.is_open())
+                          m_is_closing = true;
+                          m_reconnect_timer.cancel();
+
+                          if (!m_ws || !m_ws->is_open())
                           {
-                              m_ws.async_close(boost::beast::websocket::close_code::normal,
-                                               [self](boost::beast::error_code ec)
-                                               {
-                                                   // Optional: Handle close completion
-                                               });
+                              closed->set_value();
+                              return;
                           }
+
+                          m_ws->async_close(boost::beast::websocket::close_code::normal,
+                                            [self, closed](boost::beast::error_code) { closed->set_value(); });
                       });
+
+    if (m_strand.running_in_this_thread())
+    {
+        return false;
+    }
+
+    return closed_future.wait_for(timeout) == std::future_status::ready;
 }
 
 void utils::WebSocketClient::ReportError(boost::system::error_code ec, const std::string &context)
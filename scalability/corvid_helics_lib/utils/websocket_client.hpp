@@ -3,23 +3,147 @@
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/core/error.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/system/error_code.hpp>
 #include <string>
 #include <functional>
-#include <queue>
+#include <deque>
+#include <vector>
 #include <memory>
 #include <thread>
 #include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <chrono>
+
+#include "message_sink.hpp"
 
 namespace utils
 {
-class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
+
+/**
+ * What Send does when the write queue is full.
+ */
+enum class OverflowPolicy
+{
+    BLOCK,       // wait for the writer to drain a frame (never blocks when called from a client callback)
+    DROP_OLDEST, // discard the oldest queued message to make room
+    DROP_NEWEST  // discard the message being sent
+};
+
+/**
+ * @brief Parses "block", "drop_oldest" or "drop_newest".
+ * @return std::nullopt for anything else.
+ */
+std::optional<OverflowPolicy> OverflowPolicyFromString(const std::string &policy);
+
+/**
+ * Defaults keep the original behaviour: an unbounded queue and one frame per message.
+ */
+struct SendOptions
+{
+    // 0 leaves the queue unbounded
+    std::size_t max_queued_messages{};
+    // Queued text messages are joined into one frame up to this many bytes, 0 sends every message as its own frame.
+    // The messages are concatenated as they are, with no delimiter added, so only enable this when the receiver
+    // reads the text frames as one stream, e.g. log lines that already end in a newline.
+    std::size_t max_frame_bytes{};
+    OverflowPolicy overflow_policy{ OverflowPolicy::BLOCK };
+};
+
+/**
+ * Reconnect is off by default. When enabled, a lost or refused connection is retried with exponential backoff and
+ * messages sent meanwhile wait in a ring buffer that keeps the newest replay_buffer_messages, replayed in order once
+ * the handshake completes. Send never blocks while disconnected.
+ */
+struct ReconnectOptions
+{
+    bool enabled{};
+    double initial_backoff_ms{ 250.0 };
+    double max_backoff_ms{ 10000.0 };
+    std::size_t replay_buffer_messages{ 1024 };
+};
+
+/**
+ * permessage-deflate settings offered in the handshake, the server may still decline. Beast does not report the bytes
+ * it puts on the wire, so every sample_every-th frame is also deflated on the side with the same level and window to
+ * estimate the ratio and the CPU cost. The estimate compresses each sampled frame on its own, with context takeover
+ * the real stream compresses at least as well.
+ */
+struct CompressionOptions
+{
+    bool enabled{};
+    int level{ 6 };                   // zlib level, 0 (store) to 9 (best)
+    int client_max_window_bits{ 15 }; // 9 to 15, smaller windows use less memory per connection
+    int server_max_window_bits{ 15 };
+    int mem_level{ 8 };               // 1 to 9
+    bool no_context_takeover{};       // reset the dictionary after every message, trades ratio for memory
+    std::size_t min_message_bytes{};  // frames smaller than this are sent uncompressed
+    std::uint32_t sample_every{ 16 }; // 0 disables the ratio estimate
+};
+
+/**
+ * Per lane view of the send queue. Latency runs from Send to the write completing. The p99 comes from power of two
+ * microsecond buckets and is the upper edge of the bucket it falls in.
+ */
+struct LaneStats
+{
+    std::size_t queue_depth{};
+    std::uint64_t sent_messages{};
+    double mean_latency_ms{};
+    double max_latency_ms{};
+    double p99_latency_ms{};
+};
+
+struct SendStats
+{
+    std::size_t queue_depth{};
+    std::uint64_t dropped_messages{};
+    std::uint64_t sent_messages{};
+    std::uint64_t sent_frames{};
+    std::uint64_t sent_bytes{};
+    std::uint64_t reconnects{};
+
+    // Compression estimate over the sampled frames
+    std::uint64_t sampled_bytes{};
+    std::uint64_t sampled_compressed_bytes{};
+    double sampled_compress_ms{};
+
+    LaneStats high_priority{};
+    LaneStats bulk{};
+
+    double GetCompressionRatio() const;
+    double GetCompressMsPerMegabyte() const;
+};
+
+/**
+ * HIGH messages are always written before any queued BULK message. Beast cannot interleave frames, so a HIGH message
+ * still waits for the frame already on the wire, max_frame_bytes bounds that.
+ */
+class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>, public MessageSink
 {
   public:
     WebSocketClient();
+    explicit WebSocketClient(const SendOptions &send_options, const ReconnectOptions &reconnect_options = {},
+                             const CompressionOptions &compression_options = {});
+
+    /**
+     * @brief Runs the connection on a context owned by someone else, e.g. an IoContextPool shared by many clients.
+     * All handlers of this client go through its own strand, so the context may be run by any number of threads.
+     * AsyncRun and BlockingRun do nothing for these clients and StopRun only releases blocked senders, running and
+     * stopping the context is up to its owner.
+     */
+    explicit WebSocketClient(boost::asio::io_context &shared_ioc, const SendOptions &send_options = {},
+                             const ReconnectOptions &reconnect_options = {},
+                             const CompressionOptions &compression_options = {});
     ~WebSocketClient();
 
     // Prevent copying, allow moving
@@ -31,16 +155,33 @@ class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
      * @param host The hostname (e.g., "localhost")
      * @param port The port (e.g., "8080")
      * @param target The path (e.g., "/api/ws")
-     * @param on_connect Callback fired when connection succeeds or fails.
+     * @param on_connect Callback fired when connection succeeds or fails. With reconnect enabled it fires on every
+     *        successful (re)connect, and failed attempts are reported through the error callback instead.
      */
     void Connect(const std::string &host, const std::string &port, const std::string &target,
                  std::function<void(const boost::system::error_code &)> on_connect);
 
     /**
      * @brief Queues a message to be sent asynchronously.
-     * Thread-safe.
+     * Thread-safe. The const reference overload copies the message once, the rvalue and shared overloads queue the
+     * buffer itself. Queued messages are never copied again, coalesced frames are written as a buffer sequence.
+     * Each priority has its own lane, the queue limits and overflow policy apply to every lane separately.
+     * @return false if the message was dropped because the queue is full, or because the connection is gone and no
+     *         reconnect is coming.
      */
-    void Send(const std::string &message);
+    bool Send(const std::string &message, SendPriority priority = SendPriority::BULK);
+    bool Send(std::string &&message, SendPriority priority = SendPriority::BULK);
+    bool Send(std::shared_ptr<const std::string> message, SendPriority priority = SendPriority::BULK) override;
+
+    /**
+     * @brief Queues a message to be sent as a binary frame, e.g. an encoded TelemetryFrame.
+     * Thread-safe. Binary messages are never joined with other messages.
+     * @return false if the message was dropped because the queue is full.
+     */
+    bool SendBinary(std::string &&message, SendPriority priority = SendPriority::BULK);
+    bool SendBinary(std::shared_ptr<const std::string> message, SendPriority priority = SendPriority::BULK) override;
+
+    SendStats GetSendStats() const;
 
     /**
      * @brief Sets the callback to be fired when a message is received.
@@ -53,10 +194,20 @@ class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
     void SetOnError(std::function<void(const boost::system::error_code &, const std::string &)> callback);
 
     /**
-     * @brief Initiates the WebSocket close handshake.
-     * Does NOT stop the IO thread.
+     * @brief Waits until every queued message, and the frame on the wire, has been written.
+     * Returns early when the client is stopped or the connection is lost with no reconnect coming. Called from a
+     * client callback it does not wait, the writes run on that same strand.
+     * @return true if nothing is left to write.
+     */
+    bool Drain(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Runs the WebSocket close handshake and waits for it to complete.
+     * Does NOT stop the IO thread, which has to keep running for the close to complete. Called from a client
+     * callback it only starts the close, waiting there would wait on ourselves.
+     * @return false if the close did not complete within timeout, or was only started.
      */
-    void CloseConnection();
+    bool CloseConnection(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
 
     /**
      * @brief Spawns a background thread to run the IO context.
@@ -77,17 +228,81 @@ class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
 
   private:
     // Data members
-    boost::asio::io_context m_ioc;
+    std::unique_ptr<boost::asio::io_context> m_owned_ioc; // empty when running on a shared context
+    boost::asio::io_context &m_ioc;
+    boost::asio::strand<boost::asio::io_context::executor_type> m_strand;
     std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> m_work_guard;
     boost::asio::ip::tcp::resolver m_resolver;
-    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> m_ws;
+    // Recreated for every connection attempt, a closed beast stream cannot be reopened. Handlers carry the
+    // generation they were started on and ignore completions from a stream that has since been replaced.
+    std::optional<boost::beast::websocket::stream<boost::asio::ip::tcp::socket>> m_ws;
+    std::uint64_t m_connection_generation{};
 
     boost::beast::flat_buffer m_buffer;
     std::string m_host;
+    std::string m_port;   // saved for reconnect
     std::string m_target; // saved for handshake
 
-    // Write queue
-    std::queue<std::string> m_write_queue;
+    // Reconnect state, only touched on the strand
+    ReconnectOptions m_reconnect_options;
+    boost::asio::steady_timer m_reconnect_timer;
+    double m_backoff_ms{};
+    bool m_is_reconnect_pending{};
+    bool m_is_closing{};
+
+    struct OutgoingMessage
+    {
+        std::shared_ptr<const std::string> data{};
+        bool is_binary{};
+        SendPriority priority{ SendPriority::BULK };
+        std::chrono::steady_clock::time_point enqueued{};
+    };
+
+    // Written on the strand, read by GetSendStats from any thread
+    struct LaneLatency
+    {
+        static constexpr std::size_t BUCKET_COUNT = 32;
+
+        std::atomic<std::uint64_t> count{};
+        std::atomic<std::uint64_t> total_ns{};
+        std::atomic<std::uint64_t> max_ns{};
+        std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets{};
+
+        void Record(std::chrono::steady_clock::duration latency);
+        void Fill(LaneStats &stats) const;
+    };
+
+    static constexpr std::size_t LANE_COUNT = 2;
+
+    // Write queue, one lane per priority, filled by any thread and drained on the strand
+    SendOptions m_send_options;
+    mutable std::mutex m_queue_mutex;
+    std::condition_variable m_queue_space;
+    std::array<std::deque<OutgoingMessage>, LANE_COUNT> m_lanes;
+    bool m_write_in_progress{};
+    bool m_is_stopping{};
+    bool m_is_connected{};
+    bool m_is_connection_lost{}; // disconnected with no reconnect coming, Send drops until the next Connect
+
+    // Frame currently being written, only touched on the strand
+    std::vector<OutgoingMessage> m_inflight;
+    std::vector<boost::asio::const_buffer> m_frame_buffers;
+
+    std::array<std::atomic<std::size_t>, LANE_COUNT> m_lane_depths{};
+    std::array<LaneLatency, LANE_COUNT> m_lane_latencies{};
+    std::atomic<std::uint64_t> m_dropped_messages{};
+    std::atomic<std::uint64_t> m_sent_messages{};
+    std::atomic<std::uint64_t> m_sent_frames{};
+    std::atomic<std::uint64_t> m_reconnects{};
+    std::atomic<std::uint64_t> m_sent_bytes{};
+
+    // Compression, the sampling state is only touched on the strand
+    CompressionOptions m_compression_options;
+    std::uint64_t m_frames_since_sample{};
+    std::vector<unsigned char> m_sample_buffer;
+    std::atomic<std::uint64_t> m_sampled_bytes{};
+    std::atomic<std::uint64_t> m_sampled_compressed_bytes{};
+    std::atomic<std::uint64_t> m_sampled_compress_ns{};
 
     // User callbacks
     std::function<void(const boost::system::error_code &)> m_on_connect;
@@ -100,18 +315,33 @@ class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
     // Thread management
     std::thread m_io_thread;
 
+    WebSocketClient(std::unique_ptr<boost::asio::io_context> owned_ioc, boost::asio::io_context *shared_ioc,
+                    const SendOptions &send_options, const ReconnectOptions &reconnect_options,
+                    const CompressionOptions &compression_options);
+
     // Internal async steps
-    void OnResolve(boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results);
-    void OnConnect(boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type::endpoint_type ep);
-    void OnHandshake(boost::beast::error_code ec);
+    void StartConnect();
+    void OnResolve(std::uint64_t generation, boost::beast::error_code ec,
+                   boost::asio::ip::tcp::resolver::results_type results);
+    void OnConnect(std::uint64_t generation, boost::beast::error_code ec,
+                   boost::asio::ip::tcp::resolver::results_type::endpoint_type ep);
+    void OnHandshake(std::uint64_t generation, boost::beast::error_code ec);
 
     // ReadLoop
     void DoRead();
-    void OnRead(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void OnRead(std::uint64_t generation, boost::beast::error_code ec, std::size_t bytes_transferred);
 
     // Write Logic
+    bool Enqueue(OutgoingMessage message);
     void DoWrite();
-    void OnWrite(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void SampleCompression(std::size_t frame_bytes);
+    void OnWrite(std::uint64_t generation, boost::beast::error_code ec, std::size_t bytes_transferred);
+
+    // Reconnect Logic
+    void HandleConnectError(boost::beast::error_code ec, const std::string &context);
+    void ScheduleReconnect();
+    void MarkConnectionLost();
+    void RequeueInflight();
 
     // Helper functions to filter duplicates
     void ReportError(boost::beast::error_code ec, const std::string &context);
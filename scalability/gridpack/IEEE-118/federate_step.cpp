@@ -0,0 +1,506 @@
+#include "federate_step.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+#include "profiler.hpp"
+
+ieee_118::FederateStep::FederateStep(helics::ValueFederate &fed, const powerflow::input::PowerflowInput &pf_input,
+                                     double period, ieee_118::IEEE118App &executor, utils::LocalLogHelper &log)
+    : m_fed(fed), m_pf_input(pf_input), m_executor(executor), m_log(log), m_metrics(GetStepMetrics()),
+      m_time_accountant(pf_input.gridpack_name + " rank " + std::to_string(executor.GetWorldRank())),
+      m_pub(fed, pf_input.ln_magnitude, pf_input.voltage_deadband), m_subs(),
+      m_voltage_history(pf_input.extrapolate_voltage), m_period(period),
+      m_solve_period(std::max(pf_input.solve_period, period)), m_next_checkpoint_time(pf_input.checkpoint_interval),
+      m_relaxation(1.0, pf_input.coupling.aitken_max_omega > 0.0 ? pf_input.coupling.aitken_max_omega : 1.0)
+{
+    // Register every subscription in one call, then look each one up by the key it subscribes to
+    fed.registerInterfaces(pf_input.GetSubscriptionsJson());
+
+    const std::vector<std::string> gridlabd_names = pf_input.GetGridalabDNames();
+    m_subs.reserve(gridlabd_names.size());
+
+    for (const std::string &gridlabd_name : gridlabd_names)
+    {
+        m_subs[gridlabd_name] = {
+            utils::DeadbandInput(fed.getSubscription(gridlabd_name + "/Sa"), pf_input.power_deadband),
+            utils::DeadbandInput(fed.getSubscription(gridlabd_name + "/Sb"), pf_input.power_deadband),
+            utils::DeadbandInput(fed.getSubscription(gridlabd_name + "/Sc"), pf_input.power_deadband)
+        };
+    }
+
+    if (!pf_input.binary_log_file.empty())
+    {
+        const std::string path = pf_input.binary_log_file + "." + std::to_string(executor.GetWorldRank()) + ".blog";
+        m_binary_log = std::make_unique<utils::BinaryLogWriter>(path);
+        if (m_binary_log->IsOpen())
+        {
+            m_executor.SetBinaryLog(m_binary_log.get());
+        }
+        else
+        {
+            m_log << "Could not open binary log '" << path << "', using the text log.\n";
+            m_binary_log.reset();
+        }
+    }
+
+    if (!pf_input.trace_file.empty())
+    {
+        const int rank = executor.GetWorldRank();
+        const std::string path = pf_input.trace_file + "." + std::to_string(rank) + ".json";
+        m_trace = std::make_unique<utils::TraceWriter>(path, pf_input.gridpack_name + " rank " + std::to_string(rank));
+        if (m_trace->IsOpen())
+        {
+            utils::Profiler::Get().SetTraceWriter(m_trace.get());
+        }
+        else
+        {
+            m_log << "Could not open trace file '" << path << "'\n";
+            m_trace.reset();
+        }
+    }
+
+    if (pf_input.metrics.enabled)
+    {
+        // Every rank serves its own registry, on the next port up so ranks sharing a host do not collide
+        const int rank = executor.GetWorldRank();
+        const std::string address = pf_input.metrics.address.empty() ? "127.0.0.1" : pf_input.metrics.address;
+        const int port = (pf_input.metrics.port > 0 ? pf_input.metrics.port : 9470) + rank;
+
+        utils::MetricsRegistry::Get().SetConstantLabels(
+            { { "federate", pf_input.gridpack_name }, { "rank", std::to_string(rank) } });
+        m_metrics_server = std::make_unique<utils::MetricsServer>();
+        boost::system::error_code ec;
+        if (m_metrics_server->Start(address, static_cast<unsigned short>(port), ec))
+        {
+            m_log << "Serving metrics at http://" << address << ":" << port << "/metrics\n";
+        }
+        else
+        {
+            m_log << "Could not serve metrics on " << address << ":" << port << ": " << ec.message() << "\n";
+            m_metrics_server.reset();
+        }
+    }
+}
+
+ieee_118::FederateStep::StepMetrics ieee_118::FederateStep::GetStepMetrics()
+{
+    utils::MetricsRegistry &metrics = utils::MetricsRegistry::Get();
+    return { metrics.GetHistogram("corvid_step_ms", "Wall time per granted step"),
+             metrics.GetHistogram("corvid_solve_ms", "Three phase transmission solve per bus"),
+             metrics.GetCounter("corvid_steps_total", "Granted steps"),
+             metrics.GetCounter("corvid_solves_total", "Transmission solves"),
+             metrics.GetCounter("corvid_coupling_iterations_total", "Iterative coupling exchanges"),
+             metrics.GetCounter("corvid_published_voltages_total", "Voltages published past the deadband"),
+             metrics.GetCounter("corvid_suppressed_voltages_total", "Voltages held back by the deadband"),
+             metrics.GetGauge("corvid_granted_time_seconds", "Last granted simulated time") };
+}
+
+ieee_118::FederateStep::~FederateStep()
+{
+    // The executor outlives the step, do not leave it holding our writer
+    m_executor.SetBinaryLog(nullptr);
+    if (m_trace)
+    {
+        utils::Profiler::Get().SetTraceWriter(nullptr);
+    }
+}
+
+void ieee_118::FederateStep::PublishInitialVoltage()
+{
+    const powerflow::tools::ThreePhaseValues initial_phased_voltage = { { 1.0, 0.0 },
+                                                                        { -0.5, -0.866025 },
+                                                                        { -0.5, 0.866025 } };
+
+    m_log << "Publish initial voltage." << std::endl;
+    if (m_voltage_history.GetHistory().empty())
+    {
+        m_pub.ForcePublish(initial_phased_voltage, 0.0);
+    }
+    else
+    {
+        // Resuming, so the feeders get the voltages they had at the checkpoint instead of a flat start
+        for (const auto &[bus_id, solved] : m_voltage_history.GetHistory())
+        {
+            m_pub.ForcePublish(solved.last, m_start_time);
+        }
+    }
+    m_log << "Published." << std::endl;
+}
+
+void ieee_118::FederateStep::Restore(const powerflow::checkpoint::Checkpoint &checkpoint)
+{
+    m_start_time = checkpoint.granted_time;
+    m_next_solve_time = checkpoint.next_solve_time;
+    if (m_pf_input.checkpoint_interval > 0.0)
+    {
+        m_next_checkpoint_time = checkpoint.granted_time + m_pf_input.checkpoint_interval;
+    }
+
+    for (const powerflow::checkpoint::FeederPower &feeder : checkpoint.feeder_powers)
+    {
+        auto found = m_subs.find(feeder.name);
+        if (found != m_subs.end())
+        {
+            found->second.Restore(feeder.power, checkpoint.granted_time);
+        }
+    }
+
+    for (const powerflow::checkpoint::SolvedBusVoltage &bus : checkpoint.solved_voltages)
+    {
+        m_voltage_history.Restore(bus.bus_id, bus.solved);
+    }
+}
+
+void ieee_118::FederateStep::WriteCheckpoint(double granted_time)
+{
+    CORVID_PROFILE_SCOPE(checkpoint_scope, "write_checkpoint");
+
+    powerflow::checkpoint::Checkpoint checkpoint;
+    checkpoint.granted_time = granted_time;
+    checkpoint.next_solve_time = m_next_solve_time;
+    checkpoint.bus_voltages = m_executor.GetBusVoltages();
+    checkpoint.rank_count = m_executor.GetWorldSize();
+    checkpoint.partition_fingerprint = powerflow::checkpoint::GetPartitionFingerprint(checkpoint.bus_voltages);
+
+    checkpoint.feeder_powers.reserve(m_subs.size());
+    for (const auto &[gridlabd_name, current_subs] : m_subs)
+    {
+        checkpoint.feeder_powers.push_back({ gridlabd_name, current_subs.GetValues() });
+    }
+
+    checkpoint.solved_voltages.reserve(m_voltage_history.GetHistory().size());
+    for (const auto &[bus_id, solved] : m_voltage_history.GetHistory())
+    {
+        checkpoint.solved_voltages.push_back({ bus_id, solved });
+    }
+
+    const std::string path =
+        powerflow::checkpoint::GetCheckpointPath(m_pf_input.checkpoint_file, m_executor.GetWorldRank());
+    if (powerflow::checkpoint::WriteCheckpoint(path, checkpoint))
+    {
+        m_log << "Checkpoint at " << granted_time << " written to " << path << " in "
+              << checkpoint_scope.ElapsedMilliseconds() << " ms\n";
+    }
+    else
+    {
+        m_log << "[error] Could not write checkpoint at " << granted_time << " to " << path << "\n";
+    }
+}
+
+namespace
+{
+
+std::vector<std::complex<double>> Flatten(const std::vector<powerflow::tools::ThreePhaseValues> &voltages)
+{
+    std::vector<std::complex<double>> flat;
+    flat.reserve(voltages.size() * 3);
+    for (const powerflow::tools::ThreePhaseValues &v : voltages)
+    {
+        flat.push_back(v.a);
+        flat.push_back(v.b);
+        flat.push_back(v.c);
+    }
+    return flat;
+}
+
+void Unflatten(const std::vector<std::complex<double>> &flat, std::vector<powerflow::tools::ThreePhaseValues> &voltages)
+{
+    for (std::size_t i = 0; i < voltages.size(); i++)
+    {
+        voltages[i] = { flat[3 * i], flat[3 * i + 1], flat[3 * i + 2] };
+    }
+}
+
+} // namespace
+
+/*
+ * What performing a step looks like:
+ * 1. Get the granted time
+ * 2. Separate the distribution systems based on bus_id
+ * 3. For each bus_id, aggregate the total power from the distribution systems. Meaning, limt the power for each
+ * phase and keep a total of all limited power for each phase per bus_id.
+ * 4. Run the powerflow application per bus id (maybe this means one application, or it means an application per
+ * bus_id).
+ * 5. Publish individual calculated V for each ID at the same granted time.
+ */
+void ieee_118::FederateStep::Run(double granted_time)
+{
+    if (m_trace)
+    {
+        m_trace->SetSimulatedTime(granted_time);
+        m_trace->AddInstant("grant");
+    }
+
+    CORVID_PROFILE_SCOPE(step_scope, "federate_step");
+    m_log << "\n[Time " << granted_time << "]\n";
+    m_metrics.steps.Increment();
+    m_metrics.granted_time.Set(granted_time);
+
+    // Small tolerance so floating point drift in granted times does not push a solve to the next step
+    const bool is_solve_step = granted_time + 1e-9 * m_solve_period >= m_next_solve_time;
+    m_step_count++;
+
+    ComputeVoltages(granted_time, is_solve_step);
+    PublishVoltages(granted_time);
+
+    if (is_solve_step && m_coupling_enabled && m_pf_input.coupling.max_iterations > 0)
+    {
+        IterateCoupling(granted_time);
+    }
+
+    if (is_solve_step)
+    {
+        m_next_solve_time = granted_time + m_solve_period;
+    }
+
+    if (m_pf_input.checkpoint_interval > 0.0 && granted_time >= m_next_checkpoint_time)
+    {
+        WriteCheckpoint(granted_time);
+        m_next_checkpoint_time = granted_time + m_pf_input.checkpoint_interval;
+    }
+
+    m_metrics.published_voltages.Advance(m_pub.GetPublishedCount());
+    m_metrics.suppressed_voltages.Advance(m_pub.GetSuppressedCount());
+    m_metrics.step_ms.Observe(step_scope.ElapsedMilliseconds());
+}
+
+void ieee_118::FederateStep::ComputeVoltages(double granted_time, bool is_solve_step)
+{
+    m_step_voltages.resize(m_pf_input.gridlabd_infos.size());
+
+    for (std::size_t i = 0; i < m_pf_input.gridlabd_infos.size(); i++)
+    {
+        const powerflow::input::GridlabDInputs &gridlabd_info = m_pf_input.gridlabd_infos[i];
+        if (!m_binary_log) m_log << "\nBus Id: " << gridlabd_info.bus_id << "\nGridlabd Names:\n\t";
+
+        powerflow::tools::ThreePhaseValues s_total;
+        for (const std::string &gridlabd_name : gridlabd_info.names)
+        {
+            if (!m_binary_log) m_log << "\"" << gridlabd_name << "\" ";
+            powerflow::tools::ThreePhaseSubscriptions &current_subs = m_subs.at(gridlabd_name);
+            current_subs.Update(granted_time);
+
+            powerflow::tools::ThreePhaseValues limited_power = powerflow::tools::LimitPower(current_subs, 1.0);
+            s_total.a += limited_power.a;
+            s_total.b += limited_power.b;
+            s_total.c += limited_power.c;
+        }
+
+        // The feeder names never change, the binary log only records the numbers
+        if (m_binary_log)
+        {
+            CORVID_BINARY_LOG(*m_binary_log, "Granted Time: {} Bus Id: {} Total S: [({},{}), ({},{}), ({},{})]\n",
+                              granted_time, gridlabd_info.bus_id, s_total.a.real(), s_total.a.imag(),
+                              s_total.b.real(), s_total.b.imag(), s_total.c.real(), s_total.c.imag());
+        }
+        else
+        {
+            m_log << "\nTotal S received from Gridlab-D: [" << s_total.a << ", " << s_total.b << ", " << s_total.c
+                  << "]\n";
+        }
+
+        powerflow::tools::ThreePhaseValues &v = m_step_voltages[i];
+        if (is_solve_step || !m_voltage_history.HasVoltage(gridlabd_info.bus_id))
+        {
+            CORVID_PROFILE_SCOPE(solve_scope, "compute_voltage");
+            if (solve_scope.IsTracing())
+            {
+                solve_scope.SetLabel("bus " + std::to_string(gridlabd_info.bus_id));
+            }
+            v = m_executor.ComputeVoltage(s_total, gridlabd_info.bus_id);
+            const double solve_ms = solve_scope.Stop();
+            m_solve_ms += solve_ms;
+            m_solve_count++;
+            m_metrics.solve_ms.Observe(solve_ms);
+            m_metrics.solves.Increment();
+
+            m_voltage_history.Record(gridlabd_info.bus_id, granted_time, v);
+            if (m_binary_log)
+            {
+                CORVID_BINARY_LOG(*m_binary_log, "Updated V by GridPACK: [({},{}), ({},{}), ({},{})]\n", v.a.real(),
+                                  v.a.imag(), v.b.real(), v.b.imag(), v.c.real(), v.c.imag());
+            }
+            else
+            {
+                m_log << "Updated V by GridPACK: [" << v.a << ", " << v.b << ", " << v.c << "]\n";
+            }
+        }
+        else
+        {
+            v = m_voltage_history.Estimate(gridlabd_info.bus_id, granted_time);
+            if (m_binary_log)
+            {
+                CORVID_BINARY_LOG(*m_binary_log, "{} V: [({},{}), ({},{}), ({},{})]\n",
+                                  m_pf_input.extrapolate_voltage ? "Extrapolated" : "Held", v.a.real(), v.a.imag(),
+                                  v.b.real(), v.b.imag(), v.c.real(), v.c.imag());
+            }
+            else
+            {
+                m_log << (m_pf_input.extrapolate_voltage ? "Extrapolated" : "Held") << " V: [" << v.a << ", " << v.b
+                      << ", " << v.c << "]\n";
+            }
+        }
+    }
+}
+
+void ieee_118::FederateStep::PublishVoltages(double granted_time, bool bypass_deadband)
+{
+    CORVID_PROFILE_ZONE("publish_voltages");
+    for (std::size_t i = 0; i < m_step_voltages.size(); i++)
+    {
+        if (bypass_deadband)
+        {
+            m_pub.ForcePublish(m_step_voltages[i], granted_time);
+        }
+        else
+        {
+            m_pub.Publish(m_step_voltages[i], granted_time);
+        }
+    }
+}
+
+/*
+ * Keeps exchanging with the feeders at the same granted time until the interface voltages settle, nobody has new
+ * data for us, or the iteration cap is hit. Each pass re-ingests the feeder powers, solves, and optionally relaxes
+ * the new voltages with Aitken's method before publishing them. Convergence is judged on the solve itself, since a
+ * small omega shrinks the relaxed step without the fixed point being reached. The iterates skip the deadband, a
+ * suppressed one would leave the feeders iterating against a stale voltage.
+ */
+void ieee_118::FederateStep::IterateCoupling(double granted_time)
+{
+    const powerflow::input::CouplingOptions &options = m_pf_input.coupling;
+    m_relaxation.Reset();
+
+    int iterations = 0;
+    bool converged = false;
+    while (!converged && iterations < options.max_iterations)
+    {
+        CORVID_PROFILE_SCOPE(iterate_scope, "request_time_iterative");
+        const helics::iteration_time result =
+            m_time_accountant.RequestTimeIterative(m_fed, granted_time, helics::IterationRequest::ITERATE_IF_NEEDED);
+        iterate_scope.Stop();
+        if (result.state != helics::IterationResult::ITERATING)
+        {
+            // No new feeder data at this time, the exchange is settled
+            converged = true;
+            break;
+        }
+        iterations++;
+
+        std::vector<std::complex<double>> previous = Flatten(m_step_voltages);
+        ComputeVoltages(granted_time, true);
+        std::vector<std::complex<double>> next = Flatten(m_step_voltages);
+
+        double max_change = 0.0;
+        for (std::size_t i = 0; i < next.size(); i++)
+        {
+            const double scale = std::max(std::abs(previous[i]), 1e-12);
+            max_change = std::max(max_change, std::abs(next[i] - previous[i]) / scale);
+        }
+        converged = max_change <= options.tolerance;
+
+        if (options.aitken)
+        {
+            next = m_relaxation.Relax(previous, next);
+            Unflatten(next, m_step_voltages);
+            for (std::size_t i = 0; i < m_step_voltages.size(); i++)
+            {
+                m_voltage_history.Record(m_pf_input.gridlabd_infos[i].bus_id, granted_time, m_step_voltages[i]);
+            }
+        }
+
+        m_log << "Coupling Iteration " << iterations << ": max relative change " << max_change;
+        if (options.aitken)
+        {
+            m_log << ", omega " << m_relaxation.GetOmega();
+        }
+        m_log << "\n";
+
+        PublishVoltages(granted_time, true);
+    }
+
+    m_log << "Coupling Iterations: " << iterations << (converged ? " (converged)" : " (capped)") << "\n";
+
+    m_iteration_total += iterations;
+    m_metrics.coupling_iterations.Increment(static_cast<std::uint64_t>(iterations));
+    m_iteration_max = std::max(m_iteration_max, iterations);
+    m_iterated_steps++;
+    if (!converged)
+    {
+        m_capped_steps++;
+    }
+}
+
+void ieee_118::FederateStep::LogSummary()
+{
+    m_executor.LogPartitionReport();
+
+    std::uint64_t suppressed_inputs = 0;
+    for (const auto &[gridlabd_name, current_subs] : m_subs)
+    {
+        suppressed_inputs += current_subs.GetSuppressedCount();
+    }
+    m_log << "Deadband Published Voltages: " << m_pub.GetPublishedCount()
+          << "\nDeadband Suppressed Voltages: " << m_pub.GetSuppressedCount()
+          << "\nDeadband Suppressed Power Updates: " << suppressed_inputs << "\n";
+
+    if (m_binary_log)
+    {
+        m_binary_log->Flush();
+        m_log << "Binary Log Statements: " << m_binary_log->GetStatementCount() << "\n";
+    }
+    if (m_trace)
+    {
+        m_trace->Flush();
+        m_log << "Trace Events Written: " << m_trace->GetEventCount() << "\n";
+    }
+
+    if (m_iterated_steps > 0)
+    {
+        m_log << "Coupled Steps: " << m_iterated_steps << "\nCoupling Iterations: " << m_iteration_total
+              << "\nMean Iterations per Step: " << static_cast<double>(m_iteration_total) / m_iterated_steps
+              << "\nMax Iterations in a Step: " << m_iteration_max << "\nSteps Hitting the Cap: " << m_capped_steps
+              << "\n";
+    }
+
+    // Solves that would have run at the federate period versus solves that actually ran
+    const long long full_rate_solves = m_step_count * static_cast<long long>(m_pf_input.gridlabd_infos.size());
+    const long long skipped_solves = full_rate_solves - m_solve_count;
+    const double mean_solve_ms = m_solve_count > 0 ? m_solve_ms / m_solve_count : 0.0;
+    m_log << "\n##########################################\n"
+          << "Solve Period: " << m_solve_period << " (federate period " << m_period << ")\n"
+          << "Granted Steps: " << m_step_count << "\nTransmission Solves: " << m_solve_count
+          << "\nSkipped Solves: " << skipped_solves << "\nSolve Reduction: "
+          << (m_solve_count > 0 ? static_cast<double>(full_rate_solves) / m_solve_count : 0.0) << "x"
+          << "\nMean Solve Time: " << mean_solve_ms << " ms\nEstimated Solve Time Saved: "
+          << mean_solve_ms * skipped_solves << " ms"
+          << "\n##########################################\n";
+
+    // Every rank keeps its own zones, the table from rank 0 stands in for the rest in the shared log
+    utils::Profiler &profiler = utils::Profiler::Get();
+    const int rank = m_executor.GetWorldRank();
+    if (rank == 0)
+    {
+        m_log << "\nProfile (rank 0):\n" << profiler.GetSummaryTable();
+        m_log << m_time_accountant.GetSummary();
+    }
+    if (!m_pf_input.profile_file.empty())
+    {
+        const std::string path = m_pf_input.profile_file + "." + std::to_string(rank) + ".json";
+        if (!profiler.WriteJson(path))
+        {
+            m_log << "Could not write profile to '" << path << "'\n";
+        }
+    }
+    if (!m_pf_input.time_report_file.empty())
+    {
+        const std::string path = m_pf_input.time_report_file + "." + std::to_string(rank) + ".json";
+        if (!m_time_accountant.WriteReport(path))
+        {
+            m_log << "Could not write time report to '" << path << "'\n";
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <helics/application_api/ValueFederate.hpp>
+
+#include "ieee_118_app.hpp"
+#include "local_log_helper.hpp"
+#include "binary_log.hpp"
+#include "trace_writer.hpp"
+#include "metrics_server.hpp"
+#include "time_accountant.hpp"
+#include "input.hpp"
+#include "tools.hpp"
+#include "checkpoint.hpp"
+
+namespace ieee_118
+{
+
+/**
+ * The work the GridPACK federate does for a single granted time: ingest feeder powers, aggregate them per bus,
+ * solve (or reuse the held/extrapolated voltage between solves), and publish. It owns the federate's interfaces but
+ * not the time loop, so the same step can be driven by a blocking requestTime loop or by a HELICS callback.
+ */
+class FederateStep
+{
+  public:
+    FederateStep(helics::ValueFederate &fed, const powerflow::input::PowerflowInput &pf_input, double period,
+                 IEEE118App &executor, utils::LocalLogHelper &log);
+    ~FederateStep();
+
+    void PublishInitialVoltage();
+    void Run(double granted_time);
+    void LogSummary();
+
+    /**
+     * Picks a run back up from a checkpoint: feeder injections, solved voltage history, and the time to resume at.
+     * The network voltages are restored separately when the executor is initialized.
+     */
+    void Restore(const powerflow::checkpoint::Checkpoint &checkpoint);
+    double GetStartTime() const { return m_start_time; }
+
+    // Iterative coupling needs requestTimeIterative, which only the blocking loop can call.
+    void DisableCoupling() { m_coupling_enabled = false; }
+
+    /**
+     * The time loop requests time through this, or marks its waits on it in callback mode, so the coupling
+     * iterations are accounted with the grants. Finish it when the loop ends, LogSummary reports it.
+     */
+    utils::TimeAccountant &GetTimeAccountant() { return m_time_accountant; }
+
+  private:
+    /**
+     * The registry metrics the step records into, looked up once so the step does not take the registry lock.
+     */
+    struct StepMetrics
+    {
+        utils::Histogram &step_ms;
+        utils::Histogram &solve_ms;
+        utils::Counter &steps;
+        utils::Counter &solves;
+        utils::Counter &coupling_iterations;
+        utils::Counter &published_voltages;
+        utils::Counter &suppressed_voltages;
+        utils::Gauge &granted_time;
+    };
+    static StepMetrics GetStepMetrics();
+
+    helics::ValueFederate &m_fed;
+    const powerflow::input::PowerflowInput &m_pf_input;
+    IEEE118App &m_executor;
+    utils::LocalLogHelper &m_log;
+    // Replaces the per step text logging when PowerflowInput::binary_log_file is set
+    std::unique_ptr<utils::BinaryLogWriter> m_binary_log;
+    // Set as the profiler's trace writer while the step exists when PowerflowInput::trace_file is set
+    std::unique_ptr<utils::TraceWriter> m_trace;
+    StepMetrics m_metrics;
+    // Serves the metrics registry when PowerflowInput::metrics is enabled
+    std::unique_ptr<utils::MetricsServer> m_metrics_server;
+    utils::TimeAccountant m_time_accountant;
+
+    powerflow::tools::VoltagePublisher m_pub;
+    std::unordered_map<std::string, powerflow::tools::ThreePhaseSubscriptions> m_subs;
+    powerflow::tools::VoltageHistory m_voltage_history;
+
+    // Multi-rate bookkeeping
+    const double m_period{};
+    const double m_solve_period{};
+    double m_next_solve_time{};
+    long long m_step_count{};
+    long long m_solve_count{};
+    double m_solve_ms{};
+
+    // Checkpointing
+    double m_start_time{};
+    double m_next_checkpoint_time{};
+
+    // Iterative coupling, the voltages of the current step in gridlabd_infos order
+    std::vector<powerflow::tools::ThreePhaseValues> m_step_voltages;
+    powerflow::tools::AitkenRelaxation m_relaxation;
+    bool m_coupling_enabled{ true };
+    long long m_iterated_steps{};
+    long long m_iteration_total{};
+    int m_iteration_max{};
+    long long m_capped_steps{};
+
+    void ComputeVoltages(double granted_time, bool is_solve_step);
+    void PublishVoltages(double granted_time, bool bypass_deadband = false);
+    void IterateCoupling(double granted_time);
+    void WriteCheckpoint(double granted_time);
+};
+
+} // namespace ieee_118
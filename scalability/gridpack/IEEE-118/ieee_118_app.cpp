@@ -3,8 +3,12 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <unordered_set>
 
-#include "stopwatch.hpp"
+#include "profiler.hpp"
 
 #include "gridpack/include/gridpack.hpp"
 #include "/usr/local/GridPACK/include/gridpack/applications/modules/powerflow/pf_factory_module.hpp"
@@ -39,6 +43,26 @@ class ieee_118::IEEE118App::State
 
     double base_MVA = 100.0;
 
+    // Ghost exchange bookkeeping
+    bool skip_idle_exchange = true;
+    bool has_ghost_exchange = true;
+    double exchange_ms = 0.0;
+    double exchange_calls = 0.0;
+    double newton_iterations = 0.0;
+
+    // Incremental solve bookkeeping. Loads applied since the last converged solve mark their buses dirty, a solve
+    // with no dirty buses is skipped and one touching few buses reuses the Jacobian on its first iteration.
+    double incremental_max_fraction = 0.1;
+    double incremental_load_tolerance = 1.0e-6; // MW/Mvar
+    double active_bus_total = 0.0;
+    std::unordered_map<int, double> affected_bus_totals; // active buses in reach of each interface bus, all ranks
+    std::unordered_map<int, std::complex<double>> applied_loads;
+    std::unordered_set<int> dirty_buses;
+    bool is_converged = false;
+    double skipped_solves = 0.0;
+    double jacobian_reuses = 0.0;
+    double full_assemblies = 0.0;
+
     std::unique_ptr<gridpack::powerflow::PFFactoryModule> pf_factory;
     std::unique_ptr<gridpack::mapper::BusVectorMap<gridpack::powerflow::PFNetwork>> v_map;
     std::unique_ptr<gridpack::mapper::FullMatrixMap<gridpack::powerflow::PFNetwork>> j_map;
@@ -91,6 +115,9 @@ class ieee_118::IEEE118App::State
         }
 
         const double phase_shift_sign = cursor->get("phaseShiftSign", 1.0);
+        skip_idle_exchange = cursor->get("skipIdleGhostExchange", true);
+        incremental_max_fraction = cursor->get("incrementalMaxDirtyFraction", 0.1);
+        incremental_load_tolerance = cursor->get("incrementalLoadTolerance", 1.0e-6);
         if (m_world.rank() == 0)
         {
             std::cout << "Network filename: (" << filename << ")\n";
@@ -161,10 +188,40 @@ class ieee_118::IEEE118App::State
         return true;
     }
 
-    void InitializeFactoryAndFields()
+    void InitializeFactoryAndFields(const std::vector<powerflow::checkpoint::BusVoltage> &warm_start)
     {
         // One time build
         network->partition();
+        ApplyWarmStart(warm_start);
+
+        // Everything the solve decisions need from the other ranks is fixed by the partition, so it is summed once
+        // here instead of on every solve: the ghost and active bus totals, and the buses each interface bus reaches.
+        std::vector<int> interface_indeces;
+        for (const auto &[bus_id, bus_index] : m_bus_indeces)
+        {
+            interface_indeces.push_back(bus_index);
+        }
+        std::sort(interface_indeces.begin(), interface_indeces.end());
+
+        std::vector<double> totals(2 + interface_indeces.size(), 0.0);
+        totals[0] = CountGhostBuses();
+        for (int i = 0; i < network->numBuses(); i++)
+        {
+            if (network->getActiveBus(i)) totals[1] += 1.0;
+        }
+        for (std::size_t i = 0; i < interface_indeces.size(); i++)
+        {
+            totals[2 + i] = CountAffectedBuses(interface_indeces[i]);
+        }
+        m_world.sum(totals.data(), static_cast<int>(totals.size()));
+
+        // With no ghost buses anywhere in the communicator, updateBuses() has nothing to exchange.
+        has_ghost_exchange = !skip_idle_exchange || totals[0] > 0.0;
+        active_bus_total = totals[1];
+        for (std::size_t i = 0; i < interface_indeces.size(); i++)
+        {
+            affected_bus_totals[interface_indeces[i]] = totals[2 + i];
+        }
 
         pf_factory = std::make_unique<gridpack::powerflow::PFFactoryModule>(network);
         pf_factory->load();
@@ -201,30 +258,178 @@ class ieee_118::IEEE118App::State
         return bus_index;
     }
     int GetWorldRank() const { return m_world.rank(); }
+    int GetWorldSize() const { return m_world.size(); }
 
-    std::complex<double> ComputeVoltageCurrent(const std::string &config_file, int target_bus_id,
-                                               const std::string &phase_name, const std::complex<double> &Sa)
+    /**
+     * Seeds the parsed bus voltages with checkpointed values before the factory loads them, so the first solve
+     * after a restart starts from the converged state instead of the flat start in the raw file.
+     */
+    void ApplyWarmStart(const std::vector<powerflow::checkpoint::BusVoltage> &warm_start)
     {
-        // Apply S (pu in MW/Mvar) and solve
-        const double P_MW = Sa.real() * this->base_MVA;
-        const double Q_Mvar = Sa.imag() * this->base_MVA;
+        if (warm_start.empty()) return;
 
-        const int bus_index = this->GetBusIndex(target_bus_id);
+        std::unordered_map<int, const powerflow::checkpoint::BusVoltage *> voltages;
+        for (const powerflow::checkpoint::BusVoltage &bus : warm_start)
+        {
+            voltages[bus.bus_id] = &bus;
+        }
+
+        for (int i = 0; i < network->numBuses(); i++)
+        {
+            auto found = voltages.find(network->getOriginalBusIndex(i));
+            if (found == voltages.end()) continue;
+
+            network->getBusData(i)->setValue(BUS_VOLTAGE_MAG, found->second->magnitude);
+            network->getBusData(i)->setValue(BUS_VOLTAGE_ANG, found->second->angle_deg);
+        }
+    }
+
+    std::vector<powerflow::checkpoint::BusVoltage> GetBusVoltages() const
+    {
+        std::vector<powerflow::checkpoint::BusVoltage> voltages;
+        for (int i = 0; i < network->numBuses(); i++)
+        {
+            if (!network->getActiveBus(i)) continue;
+
+            voltages.push_back(
+                { network->getOriginalBusIndex(i), network->getBus(i)->getVoltage(), network->getBus(i)->getPhase() });
+        }
+        return voltages;
+    }
+
+    double CountGhostBuses() const
+    {
+        double ghosts = 0.0;
+        for (int i = 0; i < network->numBuses(); i++)
+        {
+            if (!network->getActiveBus(i)) ghosts += 1.0;
+        }
+        return ghosts;
+    }
+
+    /**
+     * Exchanges ghost bus values, timing the exchange. Skipped entirely when partitioning produced no ghosts.
+     */
+    void UpdateBuses()
+    {
+        if (!has_ghost_exchange) return;
+
+        CORVID_PROFILE_SCOPE(exchange_scope, "ghost_exchange");
+        network->updateBuses();
+        exchange_ms += exchange_scope.Stop();
+        exchange_calls += 1.0;
+    }
+
+    enum class Assembly
+    {
+        SKIP,
+        REUSE_JACOBIAN,
+        FULL
+    };
+
+    /**
+     * Active buses on this rank whose mismatch a load change at bus_index moves: the bus itself and the buses
+     * sharing a branch with it.
+     */
+    double CountAffectedBuses(int bus_index) const
+    {
+        std::unordered_set<int> affected{ bus_index };
+        for (int branch : network->getConnectedBranches(bus_index))
+        {
+            int from = -1;
+            int to = -1;
+            network->getBranchEndpoints(branch, &from, &to);
+            affected.insert(from);
+            affected.insert(to);
+        }
+
+        double count = 0.0;
+        for (int index : affected)
+        {
+            if (network->getActiveBus(index)) count += 1.0;
+        }
+        return count;
+    }
 
-        this->network->getBusData(bus_index)->setValue(LOAD_PL, P_MW, 0);
-        this->network->getBusData(bus_index)->setValue(LOAD_QL, Q_Mvar, 0);
+    /**
+     * Collective call, once per bus and step. Finds which of the three phase loads, applied one after the other,
+     * moved by more than incrementalLoadTolerance (MW/Mvar) from the load the network holds before it. A single
+     * reduction makes every rank agree, so all ranks skip or solve the same phases.
+     */
+    std::array<bool, 3> FindMovedLoads(int bus_index, const std::array<std::complex<double>, 3> &loads)
+    {
+        double moved[3] = { 0.0, 0.0, 0.0 };
+        auto applied = applied_loads.find(bus_index);
+        std::optional<std::complex<double>> held{};
+        if (applied != applied_loads.end()) held = applied->second;
+        for (std::size_t i = 0; i < loads.size(); i++)
+        {
+            if (held && std::abs(loads[i] - held.value()) <= incremental_load_tolerance) continue;
+
+            moved[i] = 1.0;
+            held = loads[i];
+        }
+        m_world.sum(moved, 3);
+
+        return { moved[0] > 0.0, moved[1] > 0.0, moved[2] > 0.0 };
+    }
+
+    /**
+     * Applies the load to the bus and marks it dirty. A load within the tolerance is not applied, so the network
+     * keeps the load it was last solved with.
+     */
+    void ApplyLoad(int bus_index, const std::complex<double> &load, bool is_moved)
+    {
+        if (!is_moved) return;
+
+        network->getBusData(bus_index)->setValue(LOAD_PL, load.real(), 0);
+        network->getBusData(bus_index)->setValue(LOAD_QL, load.imag(), 0);
+        applied_loads[bus_index] = load;
+        dirty_buses.insert(bus_index);
+    }
+
+    /**
+     * Picks how much of the Newton system has to be rebuilt for the current dirty buses. A load change only moves
+     * the mismatch of its bus and the buses sharing a branch with it, while the Jacobian of constant power loads
+     * depends on the voltages alone, so the Jacobian left from the last converged solve is still a valid first
+     * iteration matrix when that affected region is small. Needs no communication: the dirty buses were agreed on
+     * in FindMovedLoads, the reach of each bus was summed at start up, and convergence comes from a global norm.
+     */
+    Assembly ChooseAssembly() const
+    {
+        if (!is_converged) return Assembly::FULL;
+        if (dirty_buses.empty()) return Assembly::SKIP;
+
+        double affected = 0.0;
+        for (int bus_index : dirty_buses)
+        {
+            const auto found = affected_bus_totals.find(bus_index);
+            affected += found != affected_bus_totals.end() ? found->second : active_bus_total;
+        }
+        if (affected <= incremental_max_fraction * active_bus_total) return Assembly::REUSE_JACOBIAN;
+        return Assembly::FULL;
+    }
 
+    void SolveNewton(bool reuse_jacobian)
+    {
+        CORVID_PROFILE_ZONE("newton_solve");
         const double tolerance = this->cursor->get("tolerance", 1.0e-6);
         const int max_iteration = this->cursor->get("maxIteration", 50);
 
         this->pf_factory->setMode(gridpack::powerflow::RHS);
         this->v_map->mapToVector(*this->PQ);
 
-        this->pf_factory->setMode(gridpack::powerflow::Jacobian);
-        this->j_map->mapToMatrix(*this->J);
+        if (!reuse_jacobian)
+        {
+            this->pf_factory->setMode(gridpack::powerflow::Jacobian);
+            this->j_map->mapToMatrix(*this->J);
+        }
 
-        this->X->zero();
-        this->solver->solve(*this->PQ, *this->X);
+        {
+            CORVID_PROFILE_ZONE("linear_solve");
+            this->X->zero();
+            this->solver->solve(*this->PQ, *this->X);
+        }
         auto tol = this->PQ->normInfinity();
 
         int iterator = 0;
@@ -232,22 +437,134 @@ class ieee_118::IEEE118App::State
         {
             this->pf_factory->setMode(gridpack::powerflow::RHS);
             this->v_map->mapToBus(*this->X);
-            this->network->updateBuses();
+            this->UpdateBuses();
             this->v_map->mapToVector(*this->PQ);
 
             this->pf_factory->setMode(gridpack::powerflow::Jacobian);
             this->j_map->mapToMatrix(*this->J);
 
-            this->X->zero();
-            this->solver->solve(*this->PQ, *this->X);
+            {
+                CORVID_PROFILE_ZONE("linear_solve");
+                this->X->zero();
+                this->solver->solve(*this->PQ, *this->X);
+            }
             tol = this->PQ->normInfinity();
             iterator++;
         }
+        this->newton_iterations += iterator;
+        this->is_converged = std::real(tol) <= tolerance;
+        this->dirty_buses.clear();
 
-        // Push solution and return bus id voltage
+        // Push solution
         this->pf_factory->setMode(gridpack::powerflow::RHS);
         this->v_map->mapToBus(*this->X);
-        this->network->updateBuses();
+        this->UpdateBuses();
+    }
+
+    /**
+     * Collective call, every rank must participate. Returns the per-rank table on rank 0 and an empty string
+     * everywhere else.
+     */
+    std::string GetPartitionReport()
+    {
+        enum Column
+        {
+            BUSES,
+            GHOSTS,
+            INTERFACE,
+            EXCHANGE_MS,
+            EXCHANGE_CALLS,
+            ITERATIONS,
+            SKIPPED,
+            REUSED,
+            FULL,
+            COLUMN_COUNT
+        };
+
+        const int ranks = m_world.size();
+        std::vector<double> table(ranks * COLUMN_COUNT, 0.0);
+        double *row = &table[m_world.rank() * COLUMN_COUNT];
+
+        for (int i = 0; i < network->numBuses(); i++)
+        {
+            if (!network->getActiveBus(i)) continue;
+
+            row[BUSES] += 1.0;
+            if (m_bus_indeces.count(network->getOriginalBusIndex(i))) row[INTERFACE] += 1.0;
+        }
+        row[GHOSTS] = CountGhostBuses();
+        row[EXCHANGE_MS] = exchange_ms;
+        row[EXCHANGE_CALLS] = exchange_calls;
+        row[ITERATIONS] = newton_iterations;
+        row[SKIPPED] = skipped_solves;
+        row[REUSED] = jacobian_reuses;
+        row[FULL] = full_assemblies;
+
+        m_world.sum(table.data(), static_cast<int>(table.size()));
+
+        if (m_world.rank() != 0)
+        {
+            return "";
+        }
+
+        double max_buses = 0.0;
+        double total_buses = 0.0;
+        std::stringstream out;
+        out << "####################################\n";
+        out << "Partition Report (" << ranks << " ranks, ghost exchange "
+            << (has_ghost_exchange ? "enabled" : "skipped") << ")\n";
+        out << "Rank,Buses,Ghosts,Interface Buses,Exchange Time (ms),Exchanges,Newton Iterations,"
+               "Exchange Time per Iteration (ms),Skipped Solves,Jacobian Reuses,Full Assemblies\n";
+        for (int rank = 0; rank < ranks; rank++)
+        {
+            const double *r = &table[rank * COLUMN_COUNT];
+            const double per_iteration = r[ITERATIONS] > 0.0 ? r[EXCHANGE_MS] / r[ITERATIONS] : 0.0;
+            out << rank << "," << r[BUSES] << "," << r[GHOSTS] << "," << r[INTERFACE] << "," << r[EXCHANGE_MS] << ","
+                << r[EXCHANGE_CALLS] << "," << r[ITERATIONS] << "," << per_iteration << "," << r[SKIPPED] << ","
+                << r[REUSED] << "," << r[FULL] << "\n";
+
+            max_buses = std::max(max_buses, r[BUSES]);
+            total_buses += r[BUSES];
+        }
+        const double imbalance = total_buses > 0.0 ? max_buses / (total_buses / ranks) : 1.0;
+        out << "Bus Imbalance (max / mean): " << imbalance << "\n";
+        out << "####################################\n\n";
+
+        return out.str();
+    }
+
+    /**
+     * Converts the per unit phase powers of a bus to MW/Mvar and finds which of them move the bus.
+     */
+    std::array<bool, 3> FindMovedPhases(int target_bus_id, const powerflow::tools::ThreePhaseValues &power_s)
+    {
+        return FindMovedLoads(GetBusIndex(target_bus_id),
+                              { power_s.a * base_MVA, power_s.b * base_MVA, power_s.c * base_MVA });
+    }
+
+    std::complex<double> ComputeVoltageCurrent(const std::string &config_file, int target_bus_id,
+                                               const std::string &phase_name, const std::complex<double> &Sa,
+                                               bool is_load_moved)
+    {
+        // Apply S (pu in MW/Mvar) and solve
+        const int bus_index = this->GetBusIndex(target_bus_id);
+
+        this->ApplyLoad(bus_index, Sa * this->base_MVA, is_load_moved);
+
+        switch (this->ChooseAssembly())
+        {
+        case Assembly::SKIP:
+            this->skipped_solves += 1.0;
+            break;
+        case Assembly::REUSE_JACOBIAN:
+            this->jacobian_reuses += 1.0;
+            this->SolveNewton(true);
+            break;
+        case Assembly::FULL:
+            this->full_assemblies += 1.0;
+            this->SolveNewton(false);
+            break;
+        }
 
         const double v_mag = this->network->getBus(bus_index)->getVoltage();
         const double v_ang_deg = this->network->getBus(bus_index)->getPhase(); // deg
@@ -286,7 +603,8 @@ ieee_118::IEEE118App::IEEE118App()
 ieee_118::IEEE118App::~IEEE118App() = default;
 
 bool ieee_118::IEEE118App::Initialize(const std::string &config_file, const std::vector<int> &bus_ids,
-                                      const std::complex<double> &r)
+                                      const std::complex<double> &r,
+                                      const std::vector<powerflow::checkpoint::BusVoltage> &warm_start)
 {
     m_config_file = config_file;
     m_bus_ids = bus_ids;
@@ -313,15 +631,57 @@ bool ieee_118::IEEE118App::Initialize(const std::string &config_file, const std:
         return success;
     }
 
-    m_state->InitializeFactoryAndFields();
+    m_state->InitializeFactoryAndFields(warm_start);
+    LogPartitionReport();
 
     return success;
 }
 
+void ieee_118::IEEE118App::LogPartitionReport()
+{
+    const std::string report = m_state->GetPartitionReport();
+    if (!report.empty())
+    {
+        m_log << report;
+    }
+}
+
+std::vector<powerflow::checkpoint::BusVoltage> ieee_118::IEEE118App::GetBusVoltages() const
+{
+    return m_state->GetBusVoltages();
+}
+
+int ieee_118::IEEE118App::GetWorldRank() const { return m_state->GetWorldRank(); }
+
+int ieee_118::IEEE118App::GetWorldSize() const { return m_state->GetWorldSize(); }
+
 powerflow::tools::ThreePhaseValues
 ieee_118::IEEE118App::ComputeVoltage(const powerflow::tools::ThreePhaseValues &power_s, int bus_id)
 {
     powerflow::tools::ThreePhaseValues phased_voltage;
+    const std::array<bool, 3> moved = m_state->FindMovedPhases(bus_id, power_s);
+
+    CORVID_PROFILE_SCOPE(phase_a_scope, "phase_a");
+    phased_voltage.a = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "A", power_s.a, moved[0]);
+    long long time_a = phase_a_scope.Stop();
+
+    CORVID_PROFILE_SCOPE(phase_b_scope, "phase_b");
+    phased_voltage.b = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "B", power_s.b, moved[1]) * m_r;
+    long long time_b = phase_b_scope.Stop();
+
+    CORVID_PROFILE_SCOPE(phase_c_scope, "phase_c");
+    phased_voltage.c = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "C", power_s.c, moved[2]) * m_r * m_r;
+    long long time_c = phase_c_scope.Stop();
+
+    if (m_binary_log != nullptr)
+    {
+        CORVID_BINARY_LOG(*m_binary_log,
+                          "Bus Id: {} Power A: ({},{}) Power B: ({},{}) Power C: ({},{}) Time A: {} ms Time B: {} ms "
+                          "Time C: {} ms\n",
+                          bus_id, power_s.a.real(), power_s.a.imag(), power_s.b.real(), power_s.b.imag(),
+                          power_s.c.real(), power_s.c.imag(), time_a, time_b, time_c);
+        return phased_voltage;
+    }
 
     std::stringstream out;
     out << "####################################\n";
@@ -329,23 +689,9 @@ ieee_118::IEEE118App::ComputeVoltage(const powerflow::tools::ThreePhaseValues &p
     out << "Power A: " << power_s.a << "\n";
     out << "Power B: " << power_s.b << "\n";
     out << "Power C: " << power_s.c << "\n";
-
-    utils::Stopwatch watch;
-    watch.Start();
-    phased_voltage.a = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "A", power_s.a);
-    long long time_a = watch.ElapsedMilliseconds();
     out << "Time A: " << time_a << " ms\n";
-
-    watch.Start();
-    phased_voltage.b = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "B", power_s.b) * m_r;
-    long long time_b = watch.ElapsedMilliseconds();
     out << "Time B: " << time_b << " ms\n";
-
-    watch.Start();
-    phased_voltage.c = m_state->ComputeVoltageCurrent(m_config_file, bus_id, "C", power_s.c) * m_r * m_r;
-    long long time_c = watch.ElapsedMilliseconds();
     out << "Time C: " << time_c << " ms\n";
-
     out << "####################################\n\n";
 
     m_log << out.str();
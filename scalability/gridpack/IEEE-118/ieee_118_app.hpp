@@ -6,7 +6,9 @@
 #include <complex>
 
 #include "local_log_helper.hpp"
+#include "binary_log.hpp"
 #include "tools.hpp"
+#include "checkpoint.hpp"
 
 namespace ieee_118
 {
@@ -17,9 +19,21 @@ class IEEE118App
     IEEE118App();
     ~IEEE118App(); // This is required in order to use the forward declared inner class.
 
-    bool Initialize(const std::string &config_file, const std::vector<int> &bus_ids, const std::complex<double> &r);
+    bool Initialize(const std::string &config_file, const std::vector<int> &bus_ids, const std::complex<double> &r,
+                    const std::vector<powerflow::checkpoint::BusVoltage> &warm_start = {});
     powerflow::tools::ThreePhaseValues ComputeVoltage(const powerflow::tools::ThreePhaseValues &power_s, int bus_id);
 
+    // Collective across all ranks: logs per-rank bus, ghost and exchange time counts from rank 0.
+    void LogPartitionReport();
+
+    // Voltages of the buses owned by this rank, keyed by original bus index.
+    std::vector<powerflow::checkpoint::BusVoltage> GetBusVoltages() const;
+    int GetWorldRank() const;
+    int GetWorldSize() const;
+
+    // When set, the per bus timings go to the binary log instead of the text log. Not owned.
+    void SetBinaryLog(utils::BinaryLogWriter *binary_log) { m_binary_log = binary_log; }
+
   private:
     class State; // forward declare, implement in source file
     std::unique_ptr<State> m_state;
@@ -28,6 +42,7 @@ class IEEE118App
     std::complex<double> m_r;
 
     utils::LocalLogHelper m_log;
+    utils::BinaryLogWriter *m_binary_log{};
 
     std::complex<double> ComputeVoltageCurrent(const std::string &config_file, int target_bus_id,
                                                const std::string &phase_name, const std::complex<double> &Sa);
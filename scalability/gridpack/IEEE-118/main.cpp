@@ -8,17 +8,31 @@
 #include <cmath>
 #include <complex>
 #include <unordered_map>
+#include <future>
+#include <algorithm>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string_view>
 
 #include <helics/application_api/ValueFederate.hpp>
 #include <helics/application_api/Publications.hpp>
 #include <helics/application_api/Inputs.hpp>
+#include <helics/application_api/CallbackFederate.hpp>
 
 #include "ieee_118_app.hpp"
+#include "federate_step.hpp"
 #include "json_templates.hpp"
 #include "local_log_helper.hpp"
+#include "stopwatch.hpp"
+#include "profiler.hpp"
+#include "metrics_registry.hpp"
 
 #include "tools.hpp"
 #include "input.hpp"
+#include "checkpoint.hpp"
 
 // GridPACK includes
 #include "mpi.h"
@@ -29,6 +43,39 @@
 namespace
 {
 
+/**
+ * Wall clock time of each startup phase, tracked up to the first granted time.
+ */
+class StartupTimes
+{
+  private:
+    utils::Stopwatch m_total_watch;
+    utils::Stopwatch m_phase_watch;
+    std::stringstream m_phases;
+
+  public:
+    StartupTimes()
+    {
+        m_total_watch.Start();
+        m_phase_watch.Start();
+    }
+
+    void Mark(const std::string &phase)
+    {
+        m_phases << "\t" << phase << ": " << m_phase_watch.ElapsedMilliseconds() << " ms\n";
+        m_phase_watch.Start();
+    }
+
+    void LogFirstGrant(utils::LocalLogHelper &log)
+    {
+        Mark("first grant");
+        log << "\n##########################################\n"
+            << "Startup Phases:\n"
+            << m_phases.str() << "Time to First Grant: " << m_total_watch.ElapsedMilliseconds() << " ms"
+            << "\n##########################################\n";
+    }
+};
+
 std::string FederateToString(helics::ValueFederate &fed)
 {
     std::string json_result = fed.query(fed.getName(), "federate");
@@ -78,48 +125,91 @@ std::optional<powerflow::input::PowerflowInput> GetPowerflowInput(int argc, char
     return pf_input;
 }
 
-helics::ValueFederate GetGridpackFederate(const powerflow::input::PowerflowInput &pf_input, utils::LocalLogHelper &log)
+template <typename Federate>
+Federate GetGridpackFederate(const powerflow::input::PowerflowInput &pf_input, utils::LocalLogHelper &log)
 {
     // Create a FederateInfo object
     helics::FederateInfo fi;
     fi.loadInfoFromJson(pf_input.fed_info_json);
 
-    helics::ValueFederate gpk_118(pf_input.gridpack_name, fi);
+    Federate gpk_118(pf_input.gridpack_name, fi);
     log << "HELICS GridPACK Federate created successfully." << std::endl;
 
     return gpk_118;
 }
 
-double PerformLoop(helics::ValueFederate &gpk_118, const powerflow::input::PowerflowInput &pf_input,
-                   utils::LocalLogHelper &log)
+/**
+ * Collective over MPI_COMM_WORLD. Returns true only when every rank passes true.
+ */
+bool AllRanksAgree(bool is_ok)
 {
-    // Publications
-    powerflow::tools::VoltagePublisher pub(gpk_118, pf_input.ln_magnitude);
+    int local = is_ok ? 1 : 0;
+    int all = 0;
+    MPI_Allreduce(&local, &all, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    return all == 1;
+}
 
-    // Subscriptions
-    std::unordered_map<std::string, powerflow::tools::ThreePhaseSubscriptions> subs;
-    for (const std::string &gridlabd_name : pf_input.GetGridalabDNames())
+/**
+ * Collective over MPI_COMM_WORLD. Every rank resumes from its checkpoint, or every rank starts from time 0: a rank
+ * that fails to read its file, or checkpoints written at different granted times, drop the checkpoint everywhere.
+ */
+std::optional<powerflow::checkpoint::Checkpoint> GetCheckpoint(const powerflow::input::PowerflowInput &pf_input,
+                                                               int rank, int rank_count, utils::LocalLogHelper &log)
+{
+    std::optional<powerflow::checkpoint::Checkpoint> checkpoint{};
+    if (!pf_input.resume_from_checkpoint)
     {
-        subs[gridlabd_name] = { gpk_118.registerSubscription(gridlabd_name + "/Sa", "VA"),
-                                gpk_118.registerSubscription(gridlabd_name + "/Sb", "VA"),
-                                gpk_118.registerSubscription(gridlabd_name + "/Sc", "VA") };
+        return checkpoint;
     }
 
-    log << "Registered Pubs/Subs" << std::endl;
-    log << "\n" << FederateToString(gpk_118) << std::endl;
+    const std::string path = powerflow::checkpoint::GetCheckpointPath(pf_input.checkpoint_file, rank);
+    checkpoint = powerflow::checkpoint::ReadCheckpoint(path);
+    if (checkpoint && checkpoint->rank_count != rank_count)
+    {
+        log << "[error] Checkpoint " << path << " was written by " << checkpoint->rank_count << " ranks, not "
+            << rank_count << "\n";
+        checkpoint.reset();
+    }
+    else if (!checkpoint)
+    {
+        log << "[error] Could not read checkpoint " << path << "\n";
+    }
+
+    // The max of the times and of their negation, that is the latest and the earliest checkpoint
+    double times[2] = { checkpoint ? checkpoint->granted_time : 0.0, checkpoint ? -checkpoint->granted_time : 0.0 };
+    MPI_Allreduce(MPI_IN_PLACE, times, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    if (!AllRanksAgree(checkpoint.has_value()))
+    {
+        log << "[error] Not every rank has a usable checkpoint, starting from time 0\n";
+        checkpoint.reset();
+    }
+    else if (times[0] != -times[1])
+    {
+        log << "[error] Checkpoints were written at granted times from " << -times[1] << " to " << times[0]
+            << ", starting from time 0\n";
+        checkpoint.reset();
+    }
+    else
+    {
+        log << "[preflight] Resuming from checkpoint " << path << " at time " << checkpoint->granted_time << "\n";
+    }
+
+    return checkpoint;
+}
 
+bool InitializeExecutor(ieee_118::IEEE118App &executor, const powerflow::input::PowerflowInput &pf_input,
+                        const std::optional<powerflow::checkpoint::Checkpoint> &checkpoint,
+                        utils::LocalLogHelper &log)
+{
     // initialize constant values
     const std::string xml_file = "118.xml";
     const std::complex<double> r120({ -0.5, -0.866025 });
     const std::vector<int> bus_ids = GetBusIds(pf_input);
-    const powerflow::tools::ThreePhaseValues initial_phased_voltage = { { 1.0, 0.0 },
-                                                                        { -0.5, -0.866025 },
-                                                                        { -0.5, 0.866025 } };
-    const double period = gpk_118.getTimeProperty(HELICS_PROPERTY_TIME_PERIOD);
+    const std::vector<powerflow::checkpoint::BusVoltage> warm_start =
+        checkpoint ? checkpoint->bus_voltages : std::vector<powerflow::checkpoint::BusVoltage>();
 
-    // Initialize variables
-    ieee_118::IEEE118App executor;
-    if (!executor.Initialize(xml_file, bus_ids, r120))
+    const bool is_initialized = executor.Initialize(xml_file, bus_ids, r120, warm_start);
+    if (!is_initialized)
     {
         log << "Failed to initialize the executor.\n" << "xml_file: " << xml_file << "\n";
         log << "bus_ids: ";
@@ -128,38 +218,87 @@ double PerformLoop(helics::ValueFederate &gpk_118, const powerflow::input::Power
             log << bus_id << " ";
         }
         log << "\nr120: " << r120 << "\n";
-        return -1.0;
     }
 
-    std::unordered_map<std::string, powerflow::tools::ThreePhaseValues> last_known_values;
-    for (const std::string &gridlabd_name : pf_input.GetGridalabDNames())
+    // The same rank count can still partition differently, and then the checkpoint holds other buses
+    const bool is_same_partition =
+        !is_initialized || !checkpoint ||
+        checkpoint->partition_fingerprint == powerflow::checkpoint::GetPartitionFingerprint(executor.GetBusVoltages());
+    if (!is_same_partition)
     {
-        last_known_values[gridlabd_name] = powerflow::tools::ThreePhaseValues();
+        log << "[error] Checkpoint was written from a different partition, refusing to restore it\n";
+    }
+
+    // Every rank fails together, one rank returning alone would leave the others waiting in a collective
+    if (!AllRanksAgree(is_initialized && is_same_partition))
+    {
+        if (is_initialized && is_same_partition)
+        {
+            log << "[error] Another rank failed to initialize or restore its checkpoint\n";
+        }
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Startup shared by both loops once the step registered its interfaces: dumps the federate, initializes the solver,
+ * and restores the checkpoint when resuming.
+ */
+bool PrepareStep(helics::ValueFederate &gpk_118, ieee_118::IEEE118App &executor, ieee_118::FederateStep &step,
+                 const powerflow::input::PowerflowInput &pf_input, StartupTimes &startup, utils::LocalLogHelper &log)
+{
+    startup.Mark("register");
+
+    log << "Registered Pubs/Subs" << std::endl;
+    if (pf_input.dump_federate_query)
+    {
+        log << "\n" << FederateToString(gpk_118) << std::endl;
+    }
+
+    const std::optional<powerflow::checkpoint::Checkpoint> checkpoint =
+        GetCheckpoint(pf_input, executor.GetWorldRank(), executor.GetWorldSize(), log);
+    if (!InitializeExecutor(executor, pf_input, checkpoint, log))
+    {
+        return false;
+    }
+    if (checkpoint)
+    {
+        step.Restore(checkpoint.value());
+    }
+    startup.Mark("init solver");
+
+    return true;
+}
+
+double PerformLoop(helics::ValueFederate &gpk_118, const powerflow::input::PowerflowInput &pf_input,
+                   StartupTimes &startup, utils::LocalLogHelper &log)
+{
+    const double period = gpk_118.getTimeProperty(HELICS_PROPERTY_TIME_PERIOD);
+
+    // Publications and Subscriptions
+    ieee_118::IEEE118App executor;
+    ieee_118::FederateStep step(gpk_118, pf_input, period, executor, log);
+    if (!PrepareStep(gpk_118, executor, step, pf_input, startup, log))
+    {
+        return -1.0;
     }
 
     // Enter execution mode
     gpk_118.enterExecutingMode();
+    startup.Mark("enter exec");
     log << "GridPACK Federate has entered execution mode." << std::endl;
 
     // Initial voltage publish
-    log << "Publish initial voltage." << std::endl;
-    pub.Publish(initial_phased_voltage);
-    log << "Published." << std::endl;
+    step.PublishInitialVoltage();
 
     // Perform Simulation
-
-    /*
-     * What performing the simulation looks like:
-     * 1. Get the granted time
-     * 2. Separate the distribution systems based on bus_id
-     * 3. For each bus_id, aggregate the total power from the distribution systems. Meaning, limt the power for each
-     * phase and keep a total of all limited power for each phase per bus_id.
-     * 4. Run the powerflow application per bus id (maybe this means one application, or it means an application per
-     * bus_id).
-     * 5. Publish individual calculated V for each ID at the same granted time.
-     */
     const double total_interval = pf_input.total_time;
-    double granted_time = 0.0;
+    double granted_time = step.GetStartTime();
+    long long step_count = 0;
+    utils::Histogram &grant_wait_metric =
+        utils::MetricsRegistry::Get().GetHistogram("corvid_grant_wait_ms", "Time blocked in requestTime");
     while (granted_time + period <= total_interval)
     {
         log << "\n##########################################\n"
@@ -167,50 +306,209 @@ double PerformLoop(helics::ValueFederate &gpk_118, const powerflow::input::Power
             << "\n\tTotal Interval: " << total_interval << "\nRequesting New Granted Time: " << granted_time + period
             << "\n";
 
-        granted_time = gpk_118.requestTime(granted_time + period);
-        log << "\n[Time " << granted_time << "]\n";
+        {
+            CORVID_PROFILE_SCOPE(grant_scope, "request_time");
+            granted_time = step.GetTimeAccountant().RequestTime(gpk_118, granted_time + period);
+            grant_wait_metric.Observe(grant_scope.Stop());
+        }
+        if (step_count++ == 0)
+        {
+            startup.LogFirstGrant(log);
+        }
+        step.Run(granted_time);
+
+        log << "##########################################\n";
+    }
+    step.GetTimeAccountant().Finish();
+
+    step.LogSummary();
 
-        for (const powerflow::input::GridlabDInputs &gridlabd_info : pf_input.gridlabd_infos)
+    return granted_time;
+}
+
+/**
+ * The result of a callback driven run, set once by whichever callback ends it first.
+ */
+struct CallbackResult
+{
+    std::promise<double> promise{};
+    std::atomic<bool> is_set{ false };
+
+    void SetValue(double granted_time)
+    {
+        if (!is_set.exchange(true))
+        {
+            promise.set_value(granted_time);
+        }
+    }
+
+    void SetException(std::exception_ptr error)
+    {
+        if (!is_set.exchange(true))
+        {
+            promise.set_exception(error);
+        }
+    }
+};
+
+/**
+ * GridPACK calls made from the HELICS callbacks run on the core's thread, which MPI only allows from
+ * MPI_THREAD_SERIALIZED up.
+ */
+bool HasSerializedMpiThreading()
+{
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    return provided >= MPI_THREAD_SERIALIZED;
+}
+
+/**
+ * Same step as PerformLoop, but driven by HELICS: the initialize and next-time callbacks run on the core's thread,
+ * so there is no thread hand-off per grant. GridPACK calls then happen off the main thread while it waits, see
+ * HasSerializedMpiThreading(). The main thread waits until the last step, an exception in a step, a federation
+ * error, or the end of the co-simulation, whichever comes first.
+ */
+double PerformCallbackLoop(helics::CallbackFederate &gpk_118, const powerflow::input::PowerflowInput &pf_input,
+                           StartupTimes &startup, utils::LocalLogHelper &log)
+{
+    const double period = gpk_118.getTimeProperty(HELICS_PROPERTY_TIME_PERIOD);
+
+    // Publications and Subscriptions
+    ieee_118::IEEE118App executor;
+    ieee_118::FederateStep step(gpk_118, pf_input, period, executor, log);
+    if (!PrepareStep(gpk_118, executor, step, pf_input, startup, log))
+    {
+        return -1.0;
+    }
+
+    if (pf_input.coupling.max_iterations > 0)
+    {
+        log << "Iterative coupling is not available in callback mode, exchanging once per step." << std::endl;
+        step.DisableCoupling();
+    }
+
+    const double total_interval = pf_input.total_time;
+    // Shared with the callbacks, the error and terminate ones can still fire from finalize() after we return
+    const std::shared_ptr<CallbackResult> finished = std::make_shared<CallbackResult>();
+    std::future<double> finished_future = finished->promise.get_future();
+    long long step_count = 0;
+    // In callback mode the wait for a grant is the gap between returning the next time and the next callback
+    utils::Histogram &grant_wait_metric =
+        utils::MetricsRegistry::Get().GetHistogram("corvid_grant_wait_ms", "Time blocked in requestTime");
+    std::optional<std::chrono::steady_clock::time_point> last_return{};
+    utils::TimeAccountant &accountant = step.GetTimeAccountant();
+
+    gpk_118.setInitializeCallback(
+        [&step]()
         {
-            log << "\nBus Id: " << gridlabd_info.bus_id << "\nGridlabd Names:\n\t";
+            step.PublishInitialVoltage();
+            return helics::IterationRequest::NO_ITERATIONS;
+        });
 
-            powerflow::tools::ThreePhaseValues s_total;
-            for (const std::string &gridlabd_name : gridlabd_info.names)
+    gpk_118.setNextTimeCallback(
+        [&](helics::Time time) -> helics::Time
+        {
+            try
             {
-                log << "\"" << gridlabd_name << "\" ";
-                powerflow::tools::ThreePhaseSubscriptions &current_subs = subs.at(gridlabd_name);
-                if (current_subs.a.isUpdated() || current_subs.a.isValid())
+                const double granted_time = static_cast<double>(time);
+                if (last_return)
                 {
-                    last_known_values.at(gridlabd_name).a = current_subs.a.getValue<std::complex<double>>();
+                    const std::chrono::duration<double, std::milli> wait =
+                        std::chrono::steady_clock::now() - *last_return;
+                    grant_wait_metric.Observe(wait.count());
                 }
-                if (current_subs.b.isUpdated() || current_subs.b.isValid())
+
+                // The first callback is the entry into execution mode at time zero, nothing to solve yet
+                if (granted_time <= 0.0)
                 {
-                    last_known_values.at(gridlabd_name).b = current_subs.b.getValue<std::complex<double>>();
+                    startup.Mark("enter exec");
                 }
-                if (current_subs.c.isUpdated() || current_subs.c.isValid())
+                else
                 {
-                    last_known_values.at(gridlabd_name).c = current_subs.c.getValue<std::complex<double>>();
+                    accountant.EndWait(granted_time);
+                    if (step_count++ == 0)
+                    {
+                        startup.LogFirstGrant(log);
+                    }
+                    step.Run(granted_time);
+                    log << "##########################################\n";
                 }
 
-                powerflow::tools::ThreePhaseValues limited_power =
-                    powerflow::tools::LimitPower(subs.at(gridlabd_name), 1.0);
-                s_total.a += limited_power.a;
-                s_total.b += limited_power.b;
-                s_total.c += limited_power.c;
+                // When resuming, the first request jumps straight past the checkpointed time
+                const double current_time = std::max(granted_time, step.GetStartTime());
+                if (current_time + period > total_interval)
+                {
+                    accountant.Finish();
+                    finished->SetValue(current_time);
+                    return helics::Time::maxVal();
+                }
+
+                last_return = std::chrono::steady_clock::now();
+                accountant.BeginWait();
+                return current_time + period;
+            }
+            catch (...)
+            {
+                // Left on the core's thread this would never reach the main thread, which would wait forever
+                finished->SetException(std::current_exception());
+                return helics::Time::maxVal();
             }
+        });
 
-            log << "\nTotal S received from Gridlab-D: [" << s_total.a << ", " << s_total.b << ", " << s_total.c
-                << "]\n";
+    gpk_118.setErrorHandlerCallback(
+        [finished, &log](int error_code, std::string_view error_string)
+        {
+            log << "HELICS error " << error_code << ": " << error_string << std::endl;
+            finished->SetValue(-1.0);
+        });
 
-            powerflow::tools::ThreePhaseValues v = executor.ComputeVoltage(s_total, gridlabd_info.bus_id);
+    // Only ends the wait when the federation stopped before the last step
+    gpk_118.setCosimulationTerminatedCallback([finished]() { finished->SetValue(-1.0); });
 
-            log << "Updated V by GridPACK: [" << v.a << ", " << v.b << ", " << v.c << "]\n";
+    // Hands control to the core, the callbacks above now drive the federate
+    gpk_118.enterInitializingModeAsync();
+    log << "GridPACK Federate is running from HELICS callbacks." << std::endl;
 
-            pub.Publish(v);
-        }
+    double granted_time = -1.0;
+    try
+    {
+        granted_time = finished_future.get();
+    }
+    catch (const std::exception &e)
+    {
+        log << "Step failed in callback mode: " << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        log << "Step failed in callback mode." << std::endl;
+    }
 
-        log << "##########################################\n";
+    // The next-time callback holds references to the locals above, stop the core before they go out of scope
+    gpk_118.finalize();
+    if (granted_time < 0.0)
+    {
+        return granted_time;
     }
+    step.LogSummary();
+
+    return granted_time;
+}
+
+/**
+ * Creates the federate, runs the loop on it, and tears both GridPACK and the federate down again.
+ */
+template <typename Federate>
+double RunFederate(double (*loop)(Federate &, const powerflow::input::PowerflowInput &, StartupTimes &,
+                                  utils::LocalLogHelper &),
+                   const powerflow::input::PowerflowInput &pf_input, StartupTimes &startup,
+                   utils::LocalLogHelper &log)
+{
+    Federate gpk_118 = GetGridpackFederate<Federate>(pf_input, log);
+    startup.Mark("create federate");
+    const double granted_time = loop(gpk_118, pf_input, startup, log);
+
+    gridpack::math::Finalize();
+    gpk_118.finalize();
 
     return granted_time;
 }
@@ -226,25 +524,37 @@ int main(int argc, char **argv)
     utils::LocalLogHelper log("gpk_118_console.txt");
     log.SetOnWriteCallback([](const std::string &msg) { std::cout << msg; });
 
+    StartupTimes startup;
+
     // Read PowerFlowInput and print json string
     const std::optional<powerflow::input::PowerflowInput> pf_input = GetPowerflowInput(argc, argv, log);
     if (!pf_input)
     {
         return 1;
     }
+    startup.Mark("parse");
 
     log << "pf_input.value():\n" << utils::GetPrettyJsonString(utils::ToJsonString(pf_input.value())) << std::endl;
     log << "pf_input.value().fed_info_json:\n"
         << utils::GetPrettyJsonString(pf_input.value().fed_info_json) << std::endl;
 
-    // Create a FederateInfo object
-    helics::ValueFederate gpk_118 = GetGridpackFederate(pf_input.value(), log);
-
-    // Perform Simulation
-    const double granted_time = PerformLoop(gpk_118, pf_input.value(), log);
-
-    gridpack::math::Finalize();
-    gpk_118.finalize();
+    // Create the federate and perform the simulation
+    double granted_time = -1.0;
+    bool use_callback_federate = pf_input.value().use_callback_federate;
+    if (use_callback_federate && !HasSerializedMpiThreading())
+    {
+        log << "MPI does not provide MPI_THREAD_SERIALIZED, running the requestTime loop instead of callbacks."
+            << std::endl;
+        use_callback_federate = false;
+    }
+    if (use_callback_federate)
+    {
+        granted_time = RunFederate<helics::CallbackFederate>(PerformCallbackLoop, pf_input.value(), startup, log);
+    }
+    else
+    {
+        granted_time = RunFederate<helics::ValueFederate>(PerformLoop, pf_input.value(), startup, log);
+    }
 
     if (granted_time < 0.0)
     {
@@ -0,0 +1,231 @@
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+namespace
+{
+
+// "CVCK" followed by the format version, bump the version whenever the layout below changes.
+constexpr std::uint32_t CHECKPOINT_MAGIC = 0x4B435643;
+constexpr std::uint32_t CHECKPOINT_VERSION = 2;
+
+template <typename T> void WritePod(std::ofstream &out, const T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written directly.");
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool ReadPod(std::ifstream &in, T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read directly.");
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+void WriteThreePhase(std::ofstream &out, const powerflow::tools::ThreePhaseValues &v)
+{
+    WritePod(out, v.a);
+    WritePod(out, v.b);
+    WritePod(out, v.c);
+}
+
+bool ReadThreePhase(std::ifstream &in, powerflow::tools::ThreePhaseValues &v)
+{
+    return ReadPod(in, v.a) && ReadPod(in, v.b) && ReadPod(in, v.c);
+}
+
+std::uint64_t GetRemainingBytes(std::ifstream &in)
+{
+    const std::streampos position = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streampos end = in.tellg();
+    in.seekg(position);
+    return end > position ? static_cast<std::uint64_t>(end - position) : 0;
+}
+
+void WriteString(std::ofstream &out, const std::string &value)
+{
+    WritePod(out, static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+bool ReadString(std::ifstream &in, std::string &value)
+{
+    std::uint32_t size = 0;
+    if (!ReadPod(in, size) || size > GetRemainingBytes(in)) return false;
+
+    value.resize(size);
+    return static_cast<bool>(in.read(value.data(), size));
+}
+
+/**
+ * Reads an entry count, each entry taking at least min_entry_bytes. A corrupt count can then never ask for more
+ * entries than the rest of the file could hold.
+ */
+bool ReadCount(std::ifstream &in, std::uint64_t min_entry_bytes, std::uint64_t &count)
+{
+    return ReadPod(in, count) && count <= GetRemainingBytes(in) / min_entry_bytes;
+}
+
+} // namespace
+
+std::uint64_t powerflow::checkpoint::GetPartitionFingerprint(
+    const std::vector<powerflow::checkpoint::BusVoltage> &owned_buses)
+{
+    std::vector<int> bus_ids;
+    bus_ids.reserve(owned_buses.size());
+    for (const powerflow::checkpoint::BusVoltage &bus : owned_buses)
+    {
+        bus_ids.push_back(bus.bus_id);
+    }
+    std::sort(bus_ids.begin(), bus_ids.end());
+
+    // FNV-1a over the sorted ids
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const int bus_id : bus_ids)
+    {
+        const auto value = static_cast<std::uint32_t>(bus_id);
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            hash ^= (value >> shift) & 0xFF;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+std::string powerflow::checkpoint::GetCheckpointPath(const std::string &prefix, int rank)
+{
+    return prefix + "." + std::to_string(rank) + ".bin";
+}
+
+bool powerflow::checkpoint::WriteCheckpoint(const std::string &path,
+                                            const powerflow::checkpoint::Checkpoint &checkpoint)
+{
+    const std::string temp_path = path + ".tmp";
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            return false;
+        }
+
+        WritePod(out, CHECKPOINT_MAGIC);
+        WritePod(out, CHECKPOINT_VERSION);
+        WritePod(out, static_cast<std::int32_t>(checkpoint.rank_count));
+        WritePod(out, checkpoint.partition_fingerprint);
+        WritePod(out, checkpoint.granted_time);
+        WritePod(out, checkpoint.next_solve_time);
+
+        WritePod(out, static_cast<std::uint64_t>(checkpoint.bus_voltages.size()));
+        for (const powerflow::checkpoint::BusVoltage &bus : checkpoint.bus_voltages)
+        {
+            WritePod(out, static_cast<std::int32_t>(bus.bus_id));
+            WritePod(out, bus.magnitude);
+            WritePod(out, bus.angle_deg);
+        }
+
+        WritePod(out, static_cast<std::uint64_t>(checkpoint.feeder_powers.size()));
+        for (const powerflow::checkpoint::FeederPower &feeder : checkpoint.feeder_powers)
+        {
+            WriteString(out, feeder.name);
+            WriteThreePhase(out, feeder.power);
+        }
+
+        WritePod(out, static_cast<std::uint64_t>(checkpoint.solved_voltages.size()));
+        for (const powerflow::checkpoint::SolvedBusVoltage &bus : checkpoint.solved_voltages)
+        {
+            WritePod(out, static_cast<std::int32_t>(bus.bus_id));
+            WritePod(out, bus.solved.previous_time);
+            WriteThreePhase(out, bus.solved.previous);
+            WritePod(out, bus.solved.last_time);
+            WriteThreePhase(out, bus.solved.last);
+            WritePod(out, static_cast<std::int32_t>(bus.solved.count));
+        }
+
+        out.flush();
+        if (!out.good())
+        {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    return !ec;
+}
+
+std::optional<powerflow::checkpoint::Checkpoint> powerflow::checkpoint::ReadCheckpoint(const std::string &path)
+{
+    std::optional<powerflow::checkpoint::Checkpoint> result{};
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        return result;
+    }
+
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    if (!ReadPod(in, magic) || !ReadPod(in, version) || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION)
+    {
+        return result;
+    }
+
+    powerflow::checkpoint::Checkpoint checkpoint;
+    std::int32_t rank_count = 0;
+    if (!ReadPod(in, rank_count) || !ReadPod(in, checkpoint.partition_fingerprint) ||
+        !ReadPod(in, checkpoint.granted_time) || !ReadPod(in, checkpoint.next_solve_time))
+    {
+        return result;
+    }
+    checkpoint.rank_count = rank_count;
+
+    // Smallest size of an entry in each list below
+    constexpr std::uint64_t BUS_VOLTAGE_BYTES = sizeof(std::int32_t) + 2 * sizeof(double);
+    constexpr std::uint64_t THREE_PHASE_BYTES = 3 * sizeof(std::complex<double>);
+    constexpr std::uint64_t FEEDER_POWER_BYTES = sizeof(std::uint32_t) + THREE_PHASE_BYTES;
+    constexpr std::uint64_t SOLVED_VOLTAGE_BYTES =
+        2 * sizeof(std::int32_t) + 2 * sizeof(double) + 2 * THREE_PHASE_BYTES;
+
+    std::uint64_t count = 0;
+    if (!ReadCount(in, BUS_VOLTAGE_BYTES, count)) return result;
+    checkpoint.bus_voltages.resize(count);
+    for (powerflow::checkpoint::BusVoltage &bus : checkpoint.bus_voltages)
+    {
+        std::int32_t bus_id = 0;
+        if (!ReadPod(in, bus_id) || !ReadPod(in, bus.magnitude) || !ReadPod(in, bus.angle_deg)) return result;
+        bus.bus_id = bus_id;
+    }
+
+    if (!ReadCount(in, FEEDER_POWER_BYTES, count)) return result;
+    checkpoint.feeder_powers.resize(count);
+    for (powerflow::checkpoint::FeederPower &feeder : checkpoint.feeder_powers)
+    {
+        if (!ReadString(in, feeder.name) || !ReadThreePhase(in, feeder.power)) return result;
+    }
+
+    if (!ReadCount(in, SOLVED_VOLTAGE_BYTES, count)) return result;
+    checkpoint.solved_voltages.resize(count);
+    for (powerflow::checkpoint::SolvedBusVoltage &bus : checkpoint.solved_voltages)
+    {
+        std::int32_t bus_id = 0;
+        std::int32_t solve_count = 0;
+        if (!ReadPod(in, bus_id) || !ReadPod(in, bus.solved.previous_time) ||
+            !ReadThreePhase(in, bus.solved.previous) || !ReadPod(in, bus.solved.last_time) ||
+            !ReadThreePhase(in, bus.solved.last) || !ReadPod(in, solve_count))
+        {
+            return result;
+        }
+        bus.bus_id = bus_id;
+        bus.solved.count = solve_count;
+    }
+
+    result = std::move(checkpoint);
+    return result;
+}
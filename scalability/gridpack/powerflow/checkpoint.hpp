@@ -0,0 +1,75 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "tools.hpp"
+
+namespace powerflow
+{
+namespace checkpoint
+{
+
+struct BusVoltage
+{
+    int bus_id{}; // original bus index
+    double magnitude{};
+    double angle_deg{};
+};
+
+struct FeederPower
+{
+    std::string name{};
+    tools::ThreePhaseValues power{};
+};
+
+struct SolvedBusVoltage
+{
+    int bus_id{};
+    tools::SolvedVoltages solved{};
+};
+
+/**
+ * Everything the GridPACK federate needs to pick a run back up at granted_time: the network voltages for a warm
+ * start, the last accepted feeder injections, and the solved voltage history used between solves. A checkpoint only
+ * fits the partition it was written from, so rank_count and partition_fingerprint identify it.
+ */
+struct Checkpoint
+{
+    int rank_count{};
+    std::uint64_t partition_fingerprint{};
+    double granted_time{};
+    double next_solve_time{};
+    std::vector<BusVoltage> bus_voltages{};
+    std::vector<FeederPower> feeder_powers{};
+    std::vector<SolvedBusVoltage> solved_voltages{};
+};
+
+/**
+ * @brief Order independent hash of the original bus indices a rank owns.
+ */
+std::uint64_t GetPartitionFingerprint(const std::vector<BusVoltage> &owned_buses);
+
+/**
+ * Per rank checkpoint file name, every rank only holds the buses it owns.
+ */
+std::string GetCheckpointPath(const std::string &prefix, int rank);
+
+/**
+ * @brief Writes the checkpoint in the compact binary format. The file is written next to the target and renamed
+ *        over it, so a crash while writing never leaves a truncated checkpoint behind.
+ * @return true if the checkpoint was fully written.
+ */
+bool WriteCheckpoint(const std::string &path, const Checkpoint &checkpoint);
+
+/**
+ * @brief Reads a checkpoint written by WriteCheckpoint.
+ * @return the checkpoint, or an empty optional if the file is missing, truncated, or from another format version.
+ */
+std::optional<Checkpoint> ReadCheckpoint(const std::string &path);
+
+} // namespace checkpoint
+} // namespace powerflow
@@ -20,6 +20,50 @@ powerflow::input::tag_invoke(boost::json::value_to_tag<powerflow::input::Gridlab
     return data;
 }
 
+void powerflow::input::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value,
+                                  const powerflow::input::CouplingOptions &data)
+{
+    json_value = { { "max_iterations", data.max_iterations },
+                   { "tolerance", data.tolerance },
+                   { "aitken", data.aitken },
+                   { "aitken_max_omega", data.aitken_max_omega } };
+}
+
+powerflow::input::CouplingOptions
+powerflow::input::tag_invoke(boost::json::value_to_tag<powerflow::input::CouplingOptions>,
+                             const boost::json::value &json_value)
+{
+    powerflow::input::CouplingOptions data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "max_iterations", data.max_iterations);
+    utils::extract(obj, "tolerance", data.tolerance);
+    utils::extract(obj, "aitken", data.aitken);
+    utils::extract(obj, "aitken_max_omega", data.aitken_max_omega);
+
+    return data;
+}
+
+void powerflow::input::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value,
+                                  const powerflow::input::MetricsOptions &data)
+{
+    json_value = { { "enabled", data.enabled }, { "address", data.address }, { "port", data.port } };
+}
+
+powerflow::input::MetricsOptions
+powerflow::input::tag_invoke(boost::json::value_to_tag<powerflow::input::MetricsOptions>,
+                             const boost::json::value &json_value)
+{
+    powerflow::input::MetricsOptions data;
+    const boost::json::object &obj = json_value.as_object();
+
+    utils::extract(obj, "enabled", data.enabled);
+    utils::extract(obj, "address", data.address);
+    utils::extract(obj, "port", data.port);
+
+    return data;
+}
+
 void powerflow::input::tag_invoke(boost::json::value_from_tag, boost::json::value &json_value,
                                   const powerflow::input::PowerflowInput &data)
 {
@@ -27,7 +71,22 @@ void powerflow::input::tag_invoke(boost::json::value_from_tag, boost::json::valu
                    { "fed_info_json", boost::json::parse(data.fed_info_json) },
                    { "gridlabd_infos", data.gridlabd_infos },
                    { "total_time", data.total_time },
-                   { "ln_magnitude", data.ln_magnitude } };
+                   { "ln_magnitude", data.ln_magnitude },
+                   { "voltage_deadband", data.voltage_deadband },
+                   { "power_deadband", data.power_deadband },
+                   { "solve_period", data.solve_period },
+                   { "extrapolate_voltage", data.extrapolate_voltage },
+                   { "use_callback_federate", data.use_callback_federate },
+                   { "dump_federate_query", data.dump_federate_query },
+                   { "checkpoint_interval", data.checkpoint_interval },
+                   { "checkpoint_file", data.checkpoint_file },
+                   { "resume_from_checkpoint", data.resume_from_checkpoint },
+                   { "coupling", data.coupling },
+                   { "binary_log_file", data.binary_log_file },
+                   { "profile_file", data.profile_file },
+                   { "trace_file", data.trace_file },
+                   { "time_report_file", data.time_report_file },
+                   { "metrics", data.metrics } };
 }
 
 powerflow::input::PowerflowInput
@@ -42,6 +101,21 @@ powerflow::input::tag_invoke(boost::json::value_to_tag<powerflow::input::Powerfl
     utils::extract(obj, "gridlabd_infos", data.gridlabd_infos);
     utils::extract(obj, "total_time", data.total_time);
     utils::extract(obj, "ln_magnitude", data.ln_magnitude);
+    utils::extract(obj, "voltage_deadband", data.voltage_deadband);
+    utils::extract(obj, "power_deadband", data.power_deadband);
+    utils::extract(obj, "solve_period", data.solve_period);
+    utils::extract(obj, "extrapolate_voltage", data.extrapolate_voltage);
+    utils::extract(obj, "use_callback_federate", data.use_callback_federate);
+    utils::extract(obj, "dump_federate_query", data.dump_federate_query);
+    utils::extract(obj, "checkpoint_interval", data.checkpoint_interval);
+    utils::extract(obj, "checkpoint_file", data.checkpoint_file);
+    utils::extract(obj, "resume_from_checkpoint", data.resume_from_checkpoint);
+    utils::extract(obj, "coupling", data.coupling);
+    utils::extract(obj, "binary_log_file", data.binary_log_file);
+    utils::extract(obj, "profile_file", data.profile_file);
+    utils::extract(obj, "trace_file", data.trace_file);
+    utils::extract(obj, "time_report_file", data.time_report_file);
+    utils::extract(obj, "metrics", data.metrics);
 
     return data;
 }
@@ -59,4 +133,45 @@ std::vector<std::string> powerflow::input::PowerflowInput::GetGridalabDNames() c
     }
 
     return names;
-}
\ No newline at end of file
+}
+
+/**
+ * Builds a HELICS interface configuration with the Sa, Sb, and Sc subscriptions of every GridLAB-D name, in the
+ * order returned by GetGridalabDNames(). Handing this to registerInterfaces registers all of them in one call.
+ */
+std::string powerflow::input::PowerflowInput::GetSubscriptionsJson() const
+{
+    static const std::string phase_keys[] = { "/Sa", "/Sb", "/Sc" };
+
+    std::size_t name_count = 0;
+    for (const powerflow::input::GridlabDInputs &info : gridlabd_infos)
+    {
+        name_count += info.names.size();
+    }
+
+    boost::json::array subscriptions;
+    subscriptions.reserve(name_count * 3);
+
+    for (const powerflow::input::GridlabDInputs &info : gridlabd_infos)
+    {
+        for (const std::string &name : info.names)
+        {
+            for (const std::string &phase_key : phase_keys)
+            {
+                std::string key;
+                key.reserve(name.size() + phase_key.size());
+                key.append(name).append(phase_key);
+
+                boost::json::object subscription;
+                subscription["key"] = std::move(key);
+                subscription["unit"] = "VA";
+                subscriptions.push_back(std::move(subscription));
+            }
+        }
+    }
+
+    boost::json::object config;
+    config["subscriptions"] = std::move(subscriptions);
+
+    return boost::json::serialize(config);
+}
@@ -5,6 +5,8 @@
 
 #include <boost/json.hpp>
 
+#include "deadband.hpp"
+
 namespace powerflow
 {
 namespace input
@@ -16,6 +18,28 @@ struct GridlabDInputs
     std::vector<std::string> names{};
 };
 
+/**
+ * Iterative coupling with the feeders inside a single time step. max_iterations of 0 keeps the single exchange per
+ * step. The tolerance is on the largest relative change of an interface voltage between iterations.
+ */
+struct CouplingOptions
+{
+    int max_iterations{};
+    double tolerance{};
+    bool aitken{};
+    double aitken_max_omega{}; // upper bound of the Aitken relaxation factor, 0 uses 1
+};
+
+/**
+ * Prometheus endpoint per rank, see utils::MetricsServer. Each rank serves on port + rank.
+ */
+struct MetricsOptions
+{
+    bool enabled{};
+    std::string address{};
+    unsigned short port{};
+};
+
 struct PowerflowInput
 {
     std::string gridpack_name{};
@@ -23,13 +47,49 @@ struct PowerflowInput
     std::vector<GridlabDInputs> gridlabd_infos{};
     double total_time{};
     double ln_magnitude{};
+    utils::DeadbandOptions voltage_deadband{};
+    utils::DeadbandOptions power_deadband{};
+    // Transmission solve period, anything at or below the federate period solves every step
+    double solve_period{};
+    // Between solves publish a linear trend of the last two solves instead of holding the last solve
+    bool extrapolate_voltage{};
+    // Run the step from HELICS callbacks instead of a blocking requestTime loop
+    bool use_callback_federate{};
+    // Log the full federate query before entering execution mode, expensive with many feeders
+    bool dump_federate_query{};
+    // Simulated seconds between checkpoints, 0 disables checkpointing
+    double checkpoint_interval{};
+    // Checkpoint file prefix, each rank appends its rank
+    std::string checkpoint_file{};
+    // Resume from the checkpoint at checkpoint_file instead of starting from time 0
+    bool resume_from_checkpoint{};
+    CouplingOptions coupling{};
+    // Per step logs go to this binary log instead of the text logs, each rank appends its rank. Read it back with
+    // decode_binary_log. Empty keeps the text logs.
+    std::string binary_log_file{};
+    // Zone profile written as JSON at exit, each rank appends its rank. Empty logs the rank 0 summary only.
+    std::string profile_file{};
+    // Chrome trace of the zones and grants, each rank appends its rank. Merge with the other federates' traces using
+    // merge_traces. Empty disables.
+    std::string trace_file{};
+    // Blocked versus compute time per step, each rank appends its rank. Combine with the other federates' reports
+    // using combine_time_reports. Empty logs the rank 0 summary only.
+    std::string time_report_file{};
+    MetricsOptions metrics{};
 
     std::vector<std::string> GetGridalabDNames() const;
+    std::string GetSubscriptionsJson() const;
 };
 
 void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const GridlabDInputs &data);
 GridlabDInputs tag_invoke(boost::json::value_to_tag<GridlabDInputs>, const boost::json::value &json_value);
 
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const CouplingOptions &data);
+CouplingOptions tag_invoke(boost::json::value_to_tag<CouplingOptions>, const boost::json::value &json_value);
+
+void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const MetricsOptions &data);
+MetricsOptions tag_invoke(boost::json::value_to_tag<MetricsOptions>, const boost::json::value &json_value);
+
 void tag_invoke(boost::json::value_from_tag, boost::json::value &json_value, const PowerflowInput &data);
 PowerflowInput tag_invoke(boost::json::value_to_tag<PowerflowInput>, const boost::json::value &json_value);
 
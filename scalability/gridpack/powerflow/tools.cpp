@@ -1,18 +1,167 @@
 #include "tools.hpp"
 
-powerflow::tools::VoltagePublisher::VoltagePublisher(helics::ValueFederate &fed, double ln_magnitude)
+#include <algorithm>
+#include <cmath>
+
+void powerflow::tools::ThreePhaseSubscriptions::Update(double granted_time)
+{
+    a.Update(granted_time);
+    b.Update(granted_time);
+    c.Update(granted_time);
+}
+
+void powerflow::tools::ThreePhaseSubscriptions::Restore(const powerflow::tools::ThreePhaseValues &power, double time)
+{
+    a.Restore(power.a, time);
+    b.Restore(power.b, time);
+    c.Restore(power.c, time);
+}
+
+powerflow::tools::ThreePhaseValues powerflow::tools::ThreePhaseSubscriptions::GetValues() const
+{
+    return { a.GetValue(), b.GetValue(), c.GetValue() };
+}
+
+std::uint64_t powerflow::tools::ThreePhaseSubscriptions::GetSuppressedCount() const
+{
+    return a.GetSuppressedCount() + b.GetSuppressedCount() + c.GetSuppressedCount();
+}
+
+powerflow::tools::VoltagePublisher::VoltagePublisher(helics::ValueFederate &fed, double ln_magnitude,
+                                                     const utils::DeadbandOptions &deadband)
     : m_ln_magnitude(ln_magnitude)
 {
-    m_a = fed.registerPublication("Va", "complex", "V");
-    m_b = fed.registerPublication("Vb", "complex", "V");
-    m_c = fed.registerPublication("Vc", "complex", "V");
+    m_a = utils::DeadbandPublication(fed.registerPublication("Va", "complex", "V"), deadband);
+    m_b = utils::DeadbandPublication(fed.registerPublication("Vb", "complex", "V"), deadband);
+    m_c = utils::DeadbandPublication(fed.registerPublication("Vc", "complex", "V"), deadband);
 }
 
-void powerflow::tools::VoltagePublisher::Publish(const powerflow::tools::ThreePhaseValues &v)
+bool powerflow::tools::VoltagePublisher::Publish(const powerflow::tools::ThreePhaseValues &v, double granted_time)
 {
-    m_a.publish(v.a * m_ln_magnitude);
-    m_b.publish(v.b * m_ln_magnitude);
-    m_c.publish(v.c * m_ln_magnitude);
+    const std::complex<double> a = v.a * m_ln_magnitude;
+    const std::complex<double> b = v.b * m_ln_magnitude;
+    const std::complex<double> c = v.c * m_ln_magnitude;
+    if (!m_a.IsDue(a, granted_time) && !m_b.IsDue(b, granted_time) && !m_c.IsDue(c, granted_time))
+    {
+        m_a.Suppress();
+        m_b.Suppress();
+        m_c.Suppress();
+        return false;
+    }
+
+    m_a.ForcePublish(a, granted_time);
+    m_b.ForcePublish(b, granted_time);
+    m_c.ForcePublish(c, granted_time);
+    return true;
+}
+
+void powerflow::tools::VoltagePublisher::ForcePublish(const powerflow::tools::ThreePhaseValues &v,
+                                                      double granted_time)
+{
+    m_a.ForcePublish(v.a * m_ln_magnitude, granted_time);
+    m_b.ForcePublish(v.b * m_ln_magnitude, granted_time);
+    m_c.ForcePublish(v.c * m_ln_magnitude, granted_time);
+}
+
+std::uint64_t powerflow::tools::VoltagePublisher::GetPublishedCount() const
+{
+    return m_a.GetPublishedCount() + m_b.GetPublishedCount() + m_c.GetPublishedCount();
+}
+
+std::uint64_t powerflow::tools::VoltagePublisher::GetSuppressedCount() const
+{
+    return m_a.GetSuppressedCount() + m_b.GetSuppressedCount() + m_c.GetSuppressedCount();
+}
+
+powerflow::tools::VoltageHistory::VoltageHistory(bool extrapolate) : m_extrapolate(extrapolate) {}
+
+void powerflow::tools::VoltageHistory::Record(int bus_id, double time, const powerflow::tools::ThreePhaseValues &v)
+{
+    SolvedVoltages &history = m_history[bus_id];
+
+    // Another solve at the same time (a coupling iteration) refines the last solve instead of extending the trend
+    if (history.count > 0 && time == history.last_time)
+    {
+        history.last = v;
+        return;
+    }
+
+    history.previous_time = history.last_time;
+    history.previous = history.last;
+    history.last_time = time;
+    history.last = v;
+    history.count++;
+}
+
+bool powerflow::tools::VoltageHistory::HasVoltage(int bus_id) const { return m_history.count(bus_id) > 0; }
+
+powerflow::tools::ThreePhaseValues powerflow::tools::VoltageHistory::Estimate(int bus_id, double time) const
+{
+    const SolvedVoltages &history = m_history.at(bus_id);
+    const double span = history.last_time - history.previous_time;
+    if (!m_extrapolate || history.count < 2 || span <= 0.0)
+    {
+        return history.last;
+    }
+
+    const double scale = (time - history.last_time) / span;
+
+    powerflow::tools::ThreePhaseValues estimate;
+    estimate.a = history.last.a + (history.last.a - history.previous.a) * scale;
+    estimate.b = history.last.b + (history.last.b - history.previous.b) * scale;
+    estimate.c = history.last.c + (history.last.c - history.previous.c) * scale;
+
+    return estimate;
+}
+
+powerflow::tools::AitkenRelaxation::AitkenRelaxation(double initial_omega, double max_omega)
+    : m_initial_omega(std::min(initial_omega, max_omega)), m_max_omega(max_omega), m_omega(m_initial_omega)
+{
+}
+
+void powerflow::tools::AitkenRelaxation::Reset()
+{
+    m_omega = m_initial_omega;
+    m_last_residual.clear();
+}
+
+std::vector<std::complex<double>>
+powerflow::tools::AitkenRelaxation::Relax(const std::vector<std::complex<double>> &previous,
+                                          const std::vector<std::complex<double>> &computed)
+{
+    std::vector<std::complex<double>> residual(previous.size());
+    for (std::size_t i = 0; i < previous.size(); i++)
+    {
+        residual[i] = computed[i] - previous[i];
+    }
+
+    // omega_k = -omega_(k-1) * <r_(k-1), r_k - r_(k-1)> / |r_k - r_(k-1)|^2, treating complex values as 2D vectors
+    if (m_last_residual.size() == residual.size())
+    {
+        double numerator = 0.0;
+        double denominator = 0.0;
+        for (std::size_t i = 0; i < residual.size(); i++)
+        {
+            const std::complex<double> delta = residual[i] - m_last_residual[i];
+            numerator += m_last_residual[i].real() * delta.real() + m_last_residual[i].imag() * delta.imag();
+            denominator += std::norm(delta);
+        }
+
+        if (denominator > 0.0)
+        {
+            const double omega = -m_omega * numerator / denominator;
+            m_omega = std::isfinite(omega) && omega > 0.0 ? std::min(omega, m_max_omega) : m_initial_omega;
+        }
+    }
+
+    std::vector<std::complex<double>> relaxed(previous.size());
+    for (std::size_t i = 0; i < previous.size(); i++)
+    {
+        relaxed[i] = previous[i] + m_omega * residual[i];
+    }
+
+    m_last_residual = std::move(residual);
+    return relaxed;
 }
 
 std::complex<double> powerflow::tools::LimitPower(const std::complex<double> &s, double max_v)
@@ -33,9 +182,9 @@ powerflow::tools::ThreePhaseValues powerflow::tools::LimitPower(powerflow::tools
 {
     powerflow::tools::ThreePhaseValues limited_power;
 
-    limited_power.a = LimitPower(sub.a.getValue<std::complex<double>>() / 1e8, max_v);
-    limited_power.b = LimitPower(sub.b.getValue<std::complex<double>>() / 1e8, max_v);
-    limited_power.c = LimitPower(sub.c.getValue<std::complex<double>>() / 1e8, max_v);
+    limited_power.a = LimitPower(sub.a.GetValue() / 1e8, max_v);
+    limited_power.b = LimitPower(sub.b.GetValue() / 1e8, max_v);
+    limited_power.c = LimitPower(sub.c.GetValue() / 1e8, max_v);
 
     return limited_power;
 }
\ No newline at end of file
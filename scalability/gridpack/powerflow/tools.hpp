@@ -1,11 +1,16 @@
 #pragma once
 
 #include <complex>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 #include <helics/application_api/ValueFederate.hpp>
 #include <helics/application_api/Publications.hpp>
 #include <helics/application_api/Inputs.hpp>
 
+#include "deadband.hpp"
+
 namespace powerflow
 {
 namespace tools
@@ -20,23 +25,93 @@ struct ThreePhaseValues
 
 struct ThreePhaseSubscriptions
 {
-    helics::Input a{};
-    helics::Input b{};
-    helics::Input c{};
+    utils::DeadbandInput a{};
+    utils::DeadbandInput b{};
+    utils::DeadbandInput c{};
+
+    void Update(double granted_time);
+    void Restore(const ThreePhaseValues &power, double time);
+    ThreePhaseValues GetValues() const;
+    std::uint64_t GetSuppressedCount() const;
 };
 
 class VoltagePublisher
 {
   private:
-    helics::Publication m_a;
-    helics::Publication m_b;
-    helics::Publication m_c;
+    utils::DeadbandPublication m_a;
+    utils::DeadbandPublication m_b;
+    utils::DeadbandPublication m_c;
     const double m_ln_magnitude{};
 
   public:
-    VoltagePublisher(helics::ValueFederate &fed, double ln_magnitude);
+    VoltagePublisher(helics::ValueFederate &fed, double ln_magnitude, const utils::DeadbandOptions &deadband);
+
+    /**
+     * Publishes all three phases when any of them left the deadband around the value last put on its publication,
+     * and none of them otherwise, so the feeders never see phases from different solves.
+     * @return true if the phases were published.
+     */
+    bool Publish(const ThreePhaseValues &v, double granted_time);
+
+    /**
+     * Publishes all three phases without the deadband.
+     */
+    void ForcePublish(const ThreePhaseValues &v, double granted_time);
+    std::uint64_t GetPublishedCount() const;
+    std::uint64_t GetSuppressedCount() const;
+};
+
+struct SolvedVoltages
+{
+    double previous_time{};
+    ThreePhaseValues previous{};
+    double last_time{};
+    ThreePhaseValues last{};
+    int count{};
+};
+
+/**
+ * Keeps the last two solved voltages per bus so steps between transmission solves can republish either the held
+ * voltage or a linear extrapolation of the trend between the last two solves.
+ */
+class VoltageHistory
+{
+  private:
+    std::unordered_map<int, SolvedVoltages> m_history;
+    bool m_extrapolate{};
+
+  public:
+    explicit VoltageHistory(bool extrapolate);
+
+    void Record(int bus_id, double time, const ThreePhaseValues &v);
+    bool HasVoltage(int bus_id) const;
+    ThreePhaseValues Estimate(int bus_id, double time) const;
+
+    const std::unordered_map<int, SolvedVoltages> &GetHistory() const { return m_history; }
+    void Restore(int bus_id, const SolvedVoltages &solved) { m_history[bus_id] = solved; }
+};
+
+/**
+ * Aitken's dynamic relaxation for a fixed point x = g(x). Given the previous iterate and the value computed from it,
+ * returns the relaxed next iterate, adapting the relaxation factor from how the residual changed between iterations.
+ * The factor is kept in (0, max_omega]; when the update turns it negative or not finite it starts over from the
+ * initial factor. Reset at the start of every time step.
+ */
+class AitkenRelaxation
+{
+  private:
+    const double m_initial_omega{};
+    const double m_max_omega{};
+    double m_omega{};
+    std::vector<std::complex<double>> m_last_residual;
+
+  public:
+    AitkenRelaxation(double initial_omega, double max_omega);
 
-    void Publish(const ThreePhaseValues &v);
+    void Reset();
+    std::vector<std::complex<double>> Relax(const std::vector<std::complex<double>> &previous,
+                                            const std::vector<std::complex<double>> &computed);
+    double GetOmega() const { return m_omega; }
 };
 
 std::complex<double> LimitPower(const std::complex<double> &s, double max_v);
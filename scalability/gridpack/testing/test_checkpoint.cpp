@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "checkpoint.hpp"
+
+namespace
+{
+
+// magic | version | rank count | fingerprint | granted time | next solve time, then the bus voltage count
+constexpr std::size_t BUS_COUNT_OFFSET = 2 * sizeof(std::uint32_t) + sizeof(std::int32_t) + sizeof(std::uint64_t) +
+                                         2 * sizeof(double);
+constexpr std::size_t BUS_VOLTAGE_BYTES = sizeof(std::int32_t) + 2 * sizeof(double);
+
+powerflow::checkpoint::Checkpoint MakeCheckpoint()
+{
+    powerflow::checkpoint::Checkpoint checkpoint;
+    checkpoint.rank_count = 4;
+    checkpoint.granted_time = 120.0;
+    checkpoint.next_solve_time = 150.0;
+    checkpoint.bus_voltages = { { 7, 1.02, -3.5 }, { 12, 0.98, 10.25 } };
+    checkpoint.partition_fingerprint = powerflow::checkpoint::GetPartitionFingerprint(checkpoint.bus_voltages);
+
+    powerflow::tools::ThreePhaseValues power;
+    power.a = { 1.0e6, 2.0e5 };
+    power.b = { 1.1e6, 2.1e5 };
+    power.c = { 1.2e6, 2.2e5 };
+    checkpoint.feeder_powers = { { "feeder_7", power } };
+
+    powerflow::tools::SolvedVoltages solved;
+    solved.previous_time = 90.0;
+    solved.previous.a = { 7000.0, 1.0 };
+    solved.last_time = 120.0;
+    solved.last.a = { 7100.0, -1.0 };
+    solved.count = 2;
+    checkpoint.solved_voltages = { { 7, solved } };
+    return checkpoint;
+}
+
+class CheckpointTest : public ::testing::Test
+{
+  protected:
+    std::string m_path{};
+
+    void SetUp() override
+    {
+        const std::string test_name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        m_path = powerflow::checkpoint::GetCheckpointPath(
+            (std::filesystem::temp_directory_path() / ("corvid_checkpoint_" + test_name)).string(), 0);
+    }
+
+    void TearDown() override
+    {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+
+    std::string ReadBytes() const
+    {
+        std::ifstream in(m_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteBytes(const std::string &bytes) const
+    {
+        std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+};
+
+} // namespace
+
+TEST_F(CheckpointTest, RoundTripsEverything)
+{
+    const powerflow::checkpoint::Checkpoint written = MakeCheckpoint();
+    ASSERT_TRUE(powerflow::checkpoint::WriteCheckpoint(m_path, written));
+    EXPECT_FALSE(std::filesystem::exists(m_path + ".tmp"));
+
+    const std::optional<powerflow::checkpoint::Checkpoint> read = powerflow::checkpoint::ReadCheckpoint(m_path);
+    ASSERT_TRUE(read.has_value());
+    EXPECT_EQ(read->rank_count, written.rank_count);
+    EXPECT_EQ(read->partition_fingerprint, written.partition_fingerprint);
+    EXPECT_EQ(read->granted_time, written.granted_time);
+    EXPECT_EQ(read->next_solve_time, written.next_solve_time);
+
+    ASSERT_EQ(read->bus_voltages.size(), 2U);
+    EXPECT_EQ(read->bus_voltages[1].bus_id, 12);
+    EXPECT_EQ(read->bus_voltages[1].magnitude, 0.98);
+    EXPECT_EQ(read->bus_voltages[1].angle_deg, 10.25);
+
+    ASSERT_EQ(read->feeder_powers.size(), 1U);
+    EXPECT_EQ(read->feeder_powers[0].name, "feeder_7");
+    EXPECT_EQ(read->feeder_powers[0].power.c, written.feeder_powers[0].power.c);
+
+    ASSERT_EQ(read->solved_voltages.size(), 1U);
+    EXPECT_EQ(read->solved_voltages[0].bus_id, 7);
+    EXPECT_EQ(read->solved_voltages[0].solved.previous_time, 90.0);
+    EXPECT_EQ(read->solved_voltages[0].solved.previous.a, written.solved_voltages[0].solved.previous.a);
+    EXPECT_EQ(read->solved_voltages[0].solved.last.a, written.solved_voltages[0].solved.last.a);
+    EXPECT_EQ(read->solved_voltages[0].solved.count, 2);
+}
+
+TEST_F(CheckpointTest, FingerprintIgnoresBusOrder)
+{
+    const std::vector<powerflow::checkpoint::BusVoltage> buses = { { 1 }, { 2 }, { 3 } };
+    const std::vector<powerflow::checkpoint::BusVoltage> reordered = { { 3 }, { 1 }, { 2 } };
+    const std::vector<powerflow::checkpoint::BusVoltage> other = { { 1 }, { 2 }, { 4 } };
+
+    EXPECT_EQ(powerflow::checkpoint::GetPartitionFingerprint(buses),
+              powerflow::checkpoint::GetPartitionFingerprint(reordered));
+    EXPECT_NE(powerflow::checkpoint::GetPartitionFingerprint(buses),
+              powerflow::checkpoint::GetPartitionFingerprint(other));
+}
+
+TEST_F(CheckpointTest, RejectsEveryTruncation)
+{
+    ASSERT_TRUE(powerflow::checkpoint::WriteCheckpoint(m_path, MakeCheckpoint()));
+    const std::string bytes = ReadBytes();
+
+    for (std::size_t size = 0; size < bytes.size(); size++)
+    {
+        WriteBytes(bytes.substr(0, size));
+        EXPECT_FALSE(powerflow::checkpoint::ReadCheckpoint(m_path).has_value()) << "size " << size;
+    }
+}
+
+TEST_F(CheckpointTest, RejectsCountLargerThanFile)
+{
+    ASSERT_TRUE(powerflow::checkpoint::WriteCheckpoint(m_path, MakeCheckpoint()));
+    std::string bytes = ReadBytes();
+
+    const std::uint64_t count = 1ULL << 40;
+    std::memcpy(bytes.data() + BUS_COUNT_OFFSET, &count, sizeof(count));
+    WriteBytes(bytes);
+    EXPECT_FALSE(powerflow::checkpoint::ReadCheckpoint(m_path).has_value());
+}
+
+TEST_F(CheckpointTest, RejectsNameLongerThanFile)
+{
+    ASSERT_TRUE(powerflow::checkpoint::WriteCheckpoint(m_path, MakeCheckpoint()));
+    std::string bytes = ReadBytes();
+
+    // Past the two bus voltages and the feeder count sits the first feeder name length
+    const std::size_t name_offset = BUS_COUNT_OFFSET + sizeof(std::uint64_t) + 2 * BUS_VOLTAGE_BYTES +
+                                    sizeof(std::uint64_t);
+    const std::uint32_t length = 0x7FFFFFFF;
+    std::memcpy(bytes.data() + name_offset, &length, sizeof(length));
+    WriteBytes(bytes);
+    EXPECT_FALSE(powerflow::checkpoint::ReadCheckpoint(m_path).has_value());
+}
+
+TEST_F(CheckpointTest, RejectsOtherVersions)
+{
+    ASSERT_TRUE(powerflow::checkpoint::WriteCheckpoint(m_path, MakeCheckpoint()));
+    std::string bytes = ReadBytes();
+
+    const std::uint32_t version = 1;
+    std::memcpy(bytes.data() + sizeof(std::uint32_t), &version, sizeof(version));
+    WriteBytes(bytes);
+    EXPECT_FALSE(powerflow::checkpoint::ReadCheckpoint(m_path).has_value());
+}
+
+TEST_F(CheckpointTest, RejectsMissingFile)
+{
+    EXPECT_FALSE(powerflow::checkpoint::ReadCheckpoint(m_path).has_value());
+}